@@ -0,0 +1,118 @@
+/*
+ * libprocps - Library to read proc filesystem
+ * Benchmark for the pids history hash
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * The history functions are all static, so this benchmark includes the
+ * library source directly.  No /proc access occurs, each 'reap' is just
+ * a pids_toggle_history followed by a pids_make_hist for every task.
+ */
+#include "pids.c"
+
+#include <getopt.h>
+#include <time.h>
+
+static double elapsed_ns (const struct timespec *beg, const struct timespec *end)
+{
+    return (end->tv_sec - beg->tv_sec) * 1e9 + (end->tv_nsec - beg->tv_nsec);
+}
+
+static void usage (const char *pgm)
+{
+    fprintf(stderr, "usage: %s [-i iterations] [tasks ...]\n", pgm);
+    exit(EXIT_FAILURE);
+}
+
+static int bench_one (int numtasks, int iterations)
+{
+    enum pids_item item = PIDS_ID_PID;
+    struct pids_info *info = NULL;
+    struct timespec beg, end;
+    proc_t *procs;
+    double ns_total = 0;
+    int i, j;
+
+    if (procps_pids_new(&info, &item, 1) < 0
+    || !(procs = calloc(numtasks, sizeof(proc_t)))) {
+        fprintf(stderr, "out of memory\n");
+        return 0;
+    }
+    // ascending but sparse tids, as a busy system with a large pid_max has
+    srandom(numtasks);
+    for (i = 0, j = 1; i < numtasks; i++) {
+        j += 1 + (random() & 7);
+        procs[i].tid = j;
+        procs[i].start_time = j;
+    }
+
+    // the first cycle only sizes things, so it goes uncounted
+    for (i = 0; i <= iterations; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &beg);
+        pids_toggle_history(info);
+        for (j = 0; j < numtasks; j++) {
+            procs[j].utime += 1;
+            if (!pids_make_hist(info, &procs[j])) {
+                fprintf(stderr, "pids_make_hist failed\n");
+                return 0;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (i)
+            ns_total += elapsed_ns(&beg, &end);
+    }
+    // every task was seen last time, so each has exactly 1 elapsed tic
+    for (j = 0; j < numtasks; j++)
+        if (procs[j].pcpu != 1) {
+            fprintf(stderr, "tid %d was lost\n", procs[j].tid);
+            return 0;
+        }
+
+    printf("pids_make_hist: %8d tasks, %3d iterations, %6.1f ns/task\n"
+        , numtasks, iterations, ns_total / ((double)numtasks * iterations));
+
+    free(procs);
+    procps_pids_unref(&info);
+    return 1;
+}
+
+int main (int argc, char *argv[])
+{
+    static const int defaults[] = { 10000, 100000, 1000000 };
+    int i, opt, iterations = 10;
+
+    while ((opt = getopt(argc, argv, "i:")) != -1) {
+        switch (opt) {
+            case 'i':
+                if ((iterations = atoi(optarg)) < 1) usage(argv[0]);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if (optind < argc) {
+        for (i = optind; i < argc; i++)
+            if (atoi(argv[i]) < 1 || !bench_one(atoi(argv[i]), iterations))
+                return EXIT_FAILURE;
+    } else {
+        for (i = 0; i < (int)(sizeof(defaults) / sizeof(defaults[0])); i++)
+            if (!bench_one(defaults[i], iterations))
+                return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/*
+ * libprocps - Library to read proc filesystem
+ * Benchmark for pids library reap paths
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <proc/pids.h>
+#include "bench_sys.h"
+
+
+static enum pids_item items[] = {
+    PIDS_ID_PID,        PIDS_ID_PPID,       PIDS_ID_EUSER,
+    PIDS_STATE,         PIDS_TICS_ALL,      PIDS_TICS_ALL_DELTA,
+    PIDS_VM_RSS,        PIDS_MEM_VIRT,      PIDS_CMD
+};
+
+static void usage (const char *pgm)
+{
+    fprintf(stderr, "usage: %s [-i iterations] [-f maxfds] [-p threads] [-I] [-t]\n", pgm);
+    exit(EXIT_FAILURE);
+}
+
+int main (int argc, char *argv[])
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetch;
+    enum pids_fetch_type which = PIDS_FETCH_TASKS_ONLY;
+    long tasks = 0;
+    int i, opt, iterations = 10, maxfds = 0, numthreads = 1, incremental = 0;
+
+    while ((opt = getopt(argc, argv, "f:i:Ip:t")) != -1) {
+        switch (opt) {
+            case 'I':
+                incremental = 1;
+                break;
+            case 'f':
+                if ((maxfds = atoi(optarg)) < 0) usage(argv[0]);
+                break;
+            case 'i':
+                if ((iterations = atoi(optarg)) < 1) usage(argv[0]);
+                break;
+            case 'p':
+                if ((numthreads = atoi(optarg)) < 0) usage(argv[0]);
+                break;
+            case 't':
+                which = PIDS_FETCH_THREADS_TOO;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if (procps_pids_new(&info, items, sizeof(items) / sizeof(items[0])) < 0) {
+        fprintf(stderr, "procps_pids_new failed\n");
+        return EXIT_FAILURE;
+    }
+    if (maxfds && (maxfds = procps_pids_fdcache(info, maxfds)) < 0) {
+        fprintf(stderr, "procps_pids_fdcache failed\n");
+        return EXIT_FAILURE;
+    }
+    if (incremental && procps_pids_incremental(info, 1) < 0) {
+        fprintf(stderr, "procps_pids_incremental failed\n");
+        return EXIT_FAILURE;
+    }
+    // one reap to warm caches (pwcache, numa, etc.), which goes uncounted
+    if (!procps_pids_reap_parallel(info, which, numthreads)) {
+        fprintf(stderr, "procps_pids_reap failed\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < iterations; i++) {
+        bench_start();
+        fetch = procps_pids_reap_parallel(info, which, numthreads);
+        bench_stop();
+        if (!fetch) {
+            fprintf(stderr, "procps_pids_reap failed\n");
+            return EXIT_FAILURE;
+        }
+        tasks += fetch->counts->total;
+    }
+
+    printf("procps_pids_reap(%s): %d iterations, %.0f tasks/reap, %d fdcache, %d threads%s\n"
+        , which ? "PIDS_FETCH_THREADS_TOO" : "PIDS_FETCH_TASKS_ONLY"
+        , iterations, (double)tasks / iterations, maxfds, numthreads
+        , incremental ? ", incremental" : "");
+    bench_report("task", tasks);
+
+    procps_pids_unref(&info);
+    return EXIT_SUCCESS;
+}
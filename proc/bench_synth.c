@@ -0,0 +1,580 @@
+/*
+ * libprocps - Library to read proc filesystem
+ * Benchmark for libproc-2 against a synthetic /proc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <proc/diskstats.h>
+#include <proc/meminfo.h>
+#include <proc/misc.h>
+#include <proc/pids.h>
+#include <proc/stat.h>
+#include <proc/vmstat.h>
+#include "bench_sys.h"
+
+/*
+ * Unlike bench_pids, which measures whatever this machine happens to be
+ * running, this builds a /proc (and /sys/block) of known shape and size
+ * so that results can be compared from one build (or one host) to the
+ * next.  The contents are typical of a 6.x kernel, but only that which
+ * the library reads is present.
+ */
+
+static enum pids_item items[] = {
+    PIDS_ID_PID,        PIDS_ID_PPID,       PIDS_ID_EUSER,
+    PIDS_STATE,         PIDS_TICS_ALL,      PIDS_TICS_ALL_DELTA,
+    PIDS_VM_RSS,        PIDS_MEM_VIRT,      PIDS_CMD,
+    PIDS_CMDLINE,       PIDS_SMAP_PSS
+};
+
+static enum stat_item stat_items[] = {
+    STAT_TIC_ID,        STAT_TIC_USER,      STAT_TIC_SYSTEM,
+    STAT_TIC_IDLE
+};
+
+static enum stat_item irq_items[] = {
+    STAT_IRQ_NAME,      STAT_IRQ_DELTA_TOTAL, STAT_IRQ_CPU_HOT,
+    STAT_IRQ_DELTA_CPU_HOT
+};
+
+static enum diskstats_item disk_items[] = {
+    DISKSTATS_NAME,     DISKSTATS_TYPE,     DISKSTATS_READS,
+    DISKSTATS_WRITES,   DISKSTATS_IO_TIME
+};
+
+#define SELECT_BATCH  64
+
+static char root[PATH_MAX / 2];
+
+
+static void usage (const char *pgm)
+{
+    fprintf(stderr, "usage: %s [-i iterations] [-n processes] [-m threads] [-c cpus] [-I irqs] [-D disks] [-d dir] [-k]\n", pgm);
+    exit(EXIT_FAILURE);
+}
+
+static void fail (const char *what)
+{
+    fprintf(stderr, "%s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+
+// ___ Building The Tree ||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+static void mkdirf (const char *fmt, ...)
+{
+    char path[PATH_MAX];
+    int n;
+    va_list ap;
+
+    n = snprintf(path, sizeof(path), "%s", root);
+    va_start(ap, fmt);
+    vsnprintf(path + n, sizeof(path) - n, fmt, ap);
+    va_end(ap);
+    if (mkdir(path, 0755) && errno != EEXIST) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// the contents are either len bytes as is or, when len is zero, printf style
+static void putf (const char *name, size_t len, const char *fmt, ...)
+{
+    char path[PATH_MAX];
+    FILE *fp;
+    va_list ap;
+
+    snprintf(path, sizeof(path), "%s%s", root, name);
+    if (!(fp = fopen(path, "w"))) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    if (len)
+        fwrite(fmt, 1, len, fp);
+    else {
+        va_start(ap, fmt);
+        vfprintf(fp, fmt, ap);
+        va_end(ap);
+    }
+    if (fclose(fp)) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void make_task (const char *dir, int tgid, int tid, int nthreads, int ppid)
+{
+    static const char *comms[] = { "systemd", "bash", "postgres", "nginx", "python3", "kworker/0:1" };
+    const char *comm = comms[tgid % 6];
+    unsigned uid = (tgid % 3) ? 65534 : 0;
+    unsigned long vsize = 220000000UL + tgid * 4096UL;
+    unsigned long rss = 2000 + tgid % 5000;
+    char path[PATH_MAX], cmdline[256];
+    int len;
+
+    mkdirf("%s", dir);
+    snprintf(path, sizeof(path), "%s/stat", dir);
+    putf(path, 0,
+        "%d (%s) %c %d %d %d 0 -1 4194560 %lu 0 %lu 0 %lu %lu 0 0 20 0 %d 0 %lu %lu %lu "
+        "18446744073709551615 94000000000000 94000000100000 140730000000000 0 0 0 0 "
+        "4096 16384 0 0 0 17 %d 0 0 0 0 0 94000000200000 94000000300000 94000001000000 "
+        "140730000001000 140730000001100 140730000001100 140730000002000 0\n"
+        , tid, comm, "SRSI"[tid % 4], ppid, tgid, tgid
+        , 1000UL + tid, 10UL + tid % 7, 50UL + tid % 113, 20UL + tid % 37
+        , nthreads, 500UL + tgid, vsize, rss, tid % 8);
+    snprintf(path, sizeof(path), "%s/status", dir);
+    putf(path, 0,
+        "Name:\t%s\nUmask:\t0022\nState:\t%c (sleeping)\nTgid:\t%d\nNgid:\t0\nPid:\t%d\n"
+        "PPid:\t%d\nTracerPid:\t0\nUid:\t%u\t%u\t%u\t%u\nGid:\t%u\t%u\t%u\t%u\n"
+        "FDSize:\t64\nGroups:\t \nNStgid:\t%d\nNSpid:\t%d\nNSpgid:\t%d\nNSsid:\t%d\n"
+        "Kthread:\t0\nVmPeak:\t%8lu kB\nVmSize:\t%8lu kB\nVmLck:\t       0 kB\nVmPin:\t       0 kB\n"
+        "VmHWM:\t%8lu kB\nVmRSS:\t%8lu kB\nRssAnon:\t    1024 kB\nRssFile:\t%8lu kB\n"
+        "RssShmem:\t       0 kB\nVmData:\t    2048 kB\nVmStk:\t     132 kB\nVmExe:\t     400 kB\n"
+        "VmLib:\t    8000 kB\nVmPTE:\t      80 kB\nVmSwap:\t       0 kB\nHugetlbPages:\t       0 kB\n"
+        "CoreDumping:\t0\nTHP_enabled:\t1\nuntag_mask:\t0xffffffffffffffff\nThreads:\t%d\n"
+        "SigQ:\t0/63371\nSigPnd:\t0000000000000000\nShdPnd:\t0000000000000000\n"
+        "SigBlk:\t0000000000000000\nSigIgn:\t0000000000001000\nSigCgt:\t0000000180014002\n"
+        "CapInh:\t0000000000000000\nCapPrm:\t0000000000000000\nCapEff:\t0000000000000000\n"
+        "CapBnd:\t000001ffffffffff\nCapAmb:\t0000000000000000\nNoNewPrivs:\t0\nSeccomp:\t0\n"
+        "Seccomp_filters:\t0\nSpeculation_Store_Bypass:\tthread vulnerable\n"
+        "SpeculationIndirectBranch:\tconditional enabled\nCpus_allowed:\tff\n"
+        "Cpus_allowed_list:\t0-7\nMems_allowed:\t00000001\nMems_allowed_list:\t0\n"
+        "voluntary_ctxt_switches:\t%d\nnonvoluntary_ctxt_switches:\t%d\n"
+        , comm, "SRSI"[tid % 4], tgid, tid, ppid, uid, uid, uid, uid, uid, uid, uid, uid
+        , tid, tid, tgid, tgid, vsize / 1024 + 100, vsize / 1024, rss * 4 + 100, rss * 4
+        , rss * 4 - 1024, nthreads, tid % 1000, tid % 10);
+    snprintf(path, sizeof(path), "%s/statm", dir);
+    putf(path, 0, "%lu %lu %lu 100 0 512 0\n", vsize / 4096, rss, rss - 256);
+    snprintf(path, sizeof(path), "%s/smaps_rollup", dir);
+    putf(path, 0,
+        "55d000000000-7fff00000000 ---p 00000000 00:00 0                          [rollup]\n"
+        "Rss:            %8lu kB\nPss:            %8lu kB\nPss_Dirty:          1024 kB\n"
+        "Pss_Anon:           1024 kB\nPss_File:       %8lu kB\nPss_Shmem:             0 kB\n"
+        "Shared_Clean:       2048 kB\nShared_Dirty:          0 kB\nPrivate_Clean:       512 kB\n"
+        "Private_Dirty:      1024 kB\nReferenced:     %8lu kB\nAnonymous:          1024 kB\n"
+        "KSM:                   0 kB\nLazyFree:              0 kB\nAnonHugePages:         0 kB\n"
+        "ShmemPmdMapped:        0 kB\nFilePmdMapped:         0 kB\nShared_Hugetlb:        0 kB\n"
+        "Private_Hugetlb:       0 kB\nSwap:                  0 kB\nSwapPss:               0 kB\n"
+        "Locked:                0 kB\n"
+        , rss * 4, rss * 2, rss * 2 - 1024, rss * 4);
+    len = snprintf(cmdline, sizeof(cmdline), "/usr/bin/%s%c--config%c/etc/%s/%d.conf%c"
+        , comm, '\0', '\0', comm, tgid, '\0');
+    snprintf(path, sizeof(path), "%s/cmdline", dir);
+    putf(path, len, cmdline);
+    snprintf(path, sizeof(path), "%s/wchan", dir);
+    putf(path, 0, "%s", (tid % 4 == 1) ? "0" : "do_epoll_wait");
+}
+
+// the real thing, having far too many keys to invent
+static void copyf (const char *name)
+{
+    char path[PATH_MAX], buf[BUFSIZ];
+    FILE *in, *out;
+    size_t n;
+
+    if (!(in = fopen(name, "r")))
+        return;
+    snprintf(path, sizeof(path), "%s%s", root, name);
+    if (!(out = fopen(path, "w")))
+        fail("fopen");
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        fwrite(buf, 1, n, out);
+    fclose(out);
+    fclose(in);
+}
+
+static void make_irqs (const char *name, int ncpus, int nirqs, const char **labels, int nlabels)
+{
+    char path[PATH_MAX];
+    FILE *fp;
+    int i, j;
+
+    snprintf(path, sizeof(path), "%s%s", root, name);
+    if (!(fp = fopen(path, "w")))
+        fail("fopen");
+    fprintf(fp, "%*s", nlabels ? 12 : 4, "");
+    for (i = 0; i < ncpus; i++)
+        fprintf(fp, "CPU%-8d", i);
+    fputc('\n', fp);
+    for (i = 0; i < nirqs + nlabels; i++) {
+        if (i < nirqs)
+            fprintf(fp, "%4d:", i);
+        else
+            fprintf(fp, "%11s:", labels[i - nirqs]);
+        for (j = 0; j < ncpus; j++)
+            fprintf(fp, " %10d", (i % ncpus == j) ? 1000000 + i : j % 7);
+        if (i < nirqs)
+            fprintf(fp, "  IR-PCI-MSIX-0000:41:00.0 %d-edge      eth0-TxRx-%d", i, i);
+        fputc('\n', fp);
+    }
+    fclose(fp);
+}
+
+static void make_tree (int nprocs, int nthreads, int ncpus, int nirqs, int ndisks)
+{
+    char path[PATH_MAX];
+    int i, j, pid, tid;
+    FILE *fp;
+
+    mkdirf("/proc");
+    mkdirf("/proc/sys");
+    mkdirf("/proc/sys/kernel");
+    mkdirf("/proc/tty");
+    mkdirf("/sys");
+    mkdirf("/sys/block");
+
+    for (i = 0, tid = 1; i < nprocs; i++) {
+        pid = tid;
+        snprintf(path, sizeof(path), "/proc/%d", pid);
+        make_task(path, pid, pid, nthreads, i ? 1 : 0);
+        snprintf(path, sizeof(path), "/proc/%d/task", pid);
+        mkdirf("%s", path);
+        for (j = 0; j < nthreads; j++, tid++) {
+            snprintf(path, sizeof(path), "/proc/%d/task/%d", pid, tid);
+            make_task(path, pid, tid, nthreads, i ? 1 : 0);
+        }
+    }
+    snprintf(path, sizeof(path), "%s/proc/self", root);
+    if (symlink("1", path) && errno != EEXIST) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+
+    snprintf(path, sizeof(path), "%s/proc/stat", root);
+    if (!(fp = fopen(path, "w")))
+        fail("fopen");
+    fprintf(fp, "cpu  %d 1000 %d 9000000 5000 0 3000 0 0 0\n", 80000 * ncpus, 20000 * ncpus);
+    for (i = 0; i < ncpus; i++)
+        fprintf(fp, "cpu%d %d 125 %d 1125000 625 0 %d 0 0 0\n", i, 80000 + i, 20000 + i, 300 + i);
+    fprintf(fp, "intr 123456789 0 9 0 0 0 0 0 0 0 1 0 0 156 0 0 0 0 0 0\n"
+        "ctxt 987654321\nbtime 1700000000\nprocesses %d\nprocs_running 2\n"
+        "procs_blocked 0\nsoftirq 55555555 0 111 222 333 444 0 555 666 0 777\n", nprocs);
+    fclose(fp);
+
+    make_irqs("/proc/interrupts", ncpus, nirqs, NULL, 0);
+    make_irqs("/proc/softirqs", ncpus, 0, (const char *[]){ "HI", "TIMER", "NET_TX"
+        , "NET_RX", "BLOCK", "IRQ_POLL", "TASKLET", "SCHED", "HRTIMER", "RCU" }, 10);
+
+    snprintf(path, sizeof(path), "%s/proc/diskstats", root);
+    if (!(fp = fopen(path, "w")))
+        fail("fopen");
+    for (i = 0; i < ndisks; i++) {
+        fprintf(fp, " 259 %7d nvme%dn1 %d 1000 %d 2000 %d 500 %d 3000 0 4000 5000 10 0 20 0 30 40\n"
+            , i * 16, i, 100000 + i, 8000000 + i, 200000 + i, 9000000 + i);
+        for (j = 1; j <= 2; j++)
+            fprintf(fp, " 259 %7d nvme%dn1p%d %d 500 %d 1000 %d 250 %d 1500 0 2000 2500 5 0 10 0 0 0\n"
+                , i * 16 + j, i, j, 50000 + i, 4000000 + i, 100000 + i, 4500000 + i);
+        mkdirf("/sys/block/nvme%dn1", i);
+    }
+    fclose(fp);
+
+    putf("/proc/uptime", 0, "123456.78 987654.32\n");
+    putf("/proc/loadavg", 0, "0.52 0.58 0.59 2/%d %d\n", nprocs * (nthreads + 1), tid);
+    putf("/proc/meminfo", 0,
+        "MemTotal:       32768000 kB\nMemFree:        16384000 kB\nMemAvailable:   24576000 kB\n"
+        "Buffers:          512000 kB\nCached:          8192000 kB\nSwapCached:            0 kB\n"
+        "Active:         10240000 kB\nInactive:        4096000 kB\nSwapTotal:       8192000 kB\n"
+        "SwapFree:        8192000 kB\nShmem:            256000 kB\nSReclaimable:     768000 kB\n");
+    copyf("/proc/vmstat");
+    putf("/proc/sys/kernel/pid_max", 0, "4194304\n");
+    putf("/proc/sys/kernel/osrelease", 0, "6.8.0-synthetic\n");
+    putf("/proc/tty/drivers", 0,
+        "/dev/tty             /dev/tty        5       0 system:/dev/tty\n"
+        "/dev/console         /dev/console    5       1 system:console\n"
+        "/dev/ptmx            /dev/ptmx       5       2 system\n"
+        "pty_slave            /dev/pts      136 0-1048575 pty:slave\n"
+        "serial               /dev/ttyS       4 64-111 serial\n");
+}
+
+static int unlink_cb (const char *path, const struct stat *sb, int flag, struct FTW *ftw)
+{
+    (void)sb; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+
+// ___ The Benchmarks |||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+static void bench_reap (enum pids_fetch_type which, int iterations)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetch;
+    long tasks = 0;
+    int i;
+
+    if (procps_pids_new(&info, items, sizeof(items) / sizeof(items[0])) < 0)
+        fail("procps_pids_new");
+    // one reap to warm caches (pwcache, numa, etc.), which goes uncounted
+    if (!procps_pids_reap(info, which))
+        fail("procps_pids_reap");
+    for (i = 0; i < iterations; i++) {
+        bench_start();
+        fetch = procps_pids_reap(info, which);
+        bench_stop();
+        if (!fetch)
+            fail("procps_pids_reap");
+        tasks += fetch->counts->total;
+    }
+    printf("procps_pids_reap(%s): %.0f tasks\n"
+        , which ? "PIDS_FETCH_THREADS_TOO" : "PIDS_FETCH_TASKS_ONLY"
+        , (double)tasks / iterations);
+    bench_report("task", tasks);
+    procps_pids_unref(&info);
+}
+
+static void bench_select_sort (int nprocs, int nthreads, int iterations)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetch;
+    struct pids_stack **stacks;
+    unsigned pids[SELECT_BATCH];
+    long tasks = 0, sorted = 0;
+    int i, j, n;
+
+    if (procps_pids_new(&info, items, sizeof(items) / sizeof(items[0])) < 0)
+        fail("procps_pids_new");
+    if (!procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY))
+        fail("procps_pids_reap");
+
+    // pids are those assigned by make_tree, every (nthreads + 1)th
+    for (i = 0; i < iterations; i++) {
+        for (j = 0; j < nprocs; j += n) {
+            for (n = 0; n < SELECT_BATCH && j + n < nprocs; n++)
+                pids[n] = 1 + (j + n) * nthreads;
+            bench_start();
+            fetch = procps_pids_select(info, pids, n, PIDS_SELECT_PID);
+            bench_stop();
+            if (!fetch)
+                fail("procps_pids_select");
+            tasks += fetch->counts->total;
+        }
+    }
+    printf("procps_pids_select(PIDS_SELECT_PID): %d pids per call\n", SELECT_BATCH);
+    bench_report("task", tasks);
+
+    for (i = 0; i < iterations; i++) {
+        if (!(fetch = procps_pids_reap(info, PIDS_FETCH_THREADS_TOO)))
+            fail("procps_pids_reap");
+        n = fetch->counts->total;
+        bench_start();
+        stacks = procps_pids_sort(info, fetch->stacks, n, PIDS_CMDLINE, PIDS_SORT_ASCEND);
+        stacks = procps_pids_sort(info, fetch->stacks, n, PIDS_TICS_ALL, PIDS_SORT_DESCEND);
+        bench_stop();
+        if (!stacks)
+            fail("procps_pids_sort");
+        sorted += 2 * n;
+    }
+    printf("procps_pids_sort(PIDS_CMDLINE, PIDS_TICS_ALL): %.0f tasks\n", (double)sorted / iterations / 2);
+    bench_report("task", sorted);
+    procps_pids_unref(&info);
+}
+
+static void bench_stat (int iterations)
+{
+    struct stat_info *info = NULL;
+    struct stat_reaped *reaped;
+    long cpus = 0;
+    int i;
+
+    if (procps_stat_new(&info) < 0)
+        fail("procps_stat_new");
+    if (!procps_stat_reap(info, STAT_REAP_CPUS_ONLY, stat_items, sizeof(stat_items) / sizeof(stat_items[0])))
+        fail("procps_stat_reap");
+    for (i = 0; i < iterations; i++) {
+        bench_start();
+        reaped = procps_stat_reap(info, STAT_REAP_CPUS_ONLY, stat_items, sizeof(stat_items) / sizeof(stat_items[0]));
+        bench_stop();
+        if (!reaped)
+            fail("procps_stat_reap");
+        cpus += reaped->cpus->total;
+    }
+    printf("procps_stat_reap(STAT_REAP_CPUS_ONLY): %.0f cpus\n", (double)cpus / iterations);
+    bench_report("cpu", cpus);
+    procps_stat_unref(&info);
+}
+
+static void bench_irqs (enum stat_irq_type which, int iterations)
+{
+    struct stat_info *info = NULL;
+    struct stat_reap *reaped;
+    long irqs = 0;
+    int i;
+
+    if (procps_stat_new(&info) < 0)
+        fail("procps_stat_new");
+    for (i = 0; i < iterations; i++) {
+        bench_start();
+        reaped = procps_stat_reap_irqs(info, which, irq_items, sizeof(irq_items) / sizeof(irq_items[0]));
+        bench_stop();
+        if (!reaped)
+            fail("procps_stat_reap_irqs");
+        irqs += reaped->total;
+    }
+    printf("procps_stat_reap_irqs(%s): %.0f irqs\n"
+        , which == STAT_IRQ_HARD ? "STAT_IRQ_HARD" : "STAT_IRQ_SOFT", (double)irqs / iterations);
+    bench_report("irq", irqs);
+    procps_stat_unref(&info);
+}
+
+static void bench_meminfo (int iterations)
+{
+    enum meminfo_item items[] = { MEMINFO_MEM_FREE, MEMINFO_MEM_AVAILABLE, MEMINFO_MEM_USED };
+    struct meminfo_info *info = NULL;
+    int i;
+
+    if (procps_meminfo_new(&info) < 0)
+        fail("procps_meminfo_new");
+    for (i = 0; i < iterations; i++) {
+        bench_start();
+        if (!procps_meminfo_select(info, items, sizeof(items) / sizeof(items[0])))
+            fail("procps_meminfo_select");
+        bench_stop();
+    }
+    printf("procps_meminfo_select\n");
+    bench_report("read", iterations);
+    procps_meminfo_unref(&info);
+}
+
+static void bench_vmstat (int iterations)
+{
+    enum vmstat_item items[] = { VMSTAT_PGPGIN, VMSTAT_PGPGOUT, VMSTAT_PSWPIN, VMSTAT_PSWPOUT };
+    struct vmstat_info *info = NULL;
+    int i;
+
+    if (procps_vmstat_new(&info) < 0) {
+        printf("procps_vmstat_new: no /proc/vmstat\n");
+        return;
+    }
+    for (i = 0; i < iterations; i++) {
+        bench_start();
+        if (!procps_vmstat_select(info, items, sizeof(items) / sizeof(items[0])))
+            fail("procps_vmstat_select");
+        bench_stop();
+    }
+    printf("procps_vmstat_select\n");
+    bench_report("read", iterations);
+    procps_vmstat_unref(&info);
+}
+
+static void bench_diskstats (int iterations)
+{
+    struct diskstats_info *info = NULL;
+    struct diskstats_reaped *reaped;
+    long disks = 0;
+    int i;
+
+    if (procps_diskstats_new(&info) < 0)
+        fail("procps_diskstats_new");
+    if (!procps_diskstats_reap(info, disk_items, sizeof(disk_items) / sizeof(disk_items[0])))
+        fail("procps_diskstats_reap");
+    for (i = 0; i < iterations; i++) {
+        bench_start();
+        reaped = procps_diskstats_reap(info, disk_items, sizeof(disk_items) / sizeof(disk_items[0]));
+        bench_stop();
+        if (!reaped)
+            fail("procps_diskstats_reap");
+        disks += reaped->total;
+    }
+    printf("procps_diskstats_reap: %.0f devices\n", (double)disks / iterations);
+    bench_report("device", disks);
+    procps_diskstats_unref(&info);
+}
+
+
+int main (int argc, char *argv[])
+{
+    const char *dir = NULL;
+    int opt, iterations = 10, nprocs = 1000, nthreads = 1, ncpus = 64, nirqs = 256, ndisks = 16, keep = 0;
+
+    while ((opt = getopt(argc, argv, "c:d:D:i:I:km:n:")) != -1) {
+        switch (opt) {
+            case 'c':
+                if ((ncpus = atoi(optarg)) < 1) usage(argv[0]);
+                break;
+            case 'd':
+                dir = optarg;
+                break;
+            case 'D':
+                if ((ndisks = atoi(optarg)) < 1) usage(argv[0]);
+                break;
+            case 'i':
+                if ((iterations = atoi(optarg)) < 1) usage(argv[0]);
+                break;
+            case 'I':
+                if ((nirqs = atoi(optarg)) < 0) usage(argv[0]);
+                break;
+            case 'k':
+                keep = 1;
+                break;
+            case 'm':
+                if ((nthreads = atoi(optarg)) < 1) usage(argv[0]);
+                break;
+            case 'n':
+                if ((nprocs = atoi(optarg)) < 1) usage(argv[0]);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if (dir) {
+        snprintf(root, sizeof(root), "%s", dir);
+        if (mkdir(root, 0755) && errno != EEXIST) {
+            perror(root);
+            return EXIT_FAILURE;
+        }
+    } else {
+        snprintf(root, sizeof(root), "/tmp/bench_synth.XXXXXX");
+        if (!mkdtemp(root)) {
+            perror(root);
+            return EXIT_FAILURE;
+        }
+    }
+    make_tree(nprocs, nthreads, ncpus, nirqs, ndisks);
+    printf("synthetic tree %s: %d processes, %d threads each, %d cpus, %d irqs, %d disks, %d iterations\n"
+        , root, nprocs, nthreads, ncpus, nirqs, ndisks, iterations);
+
+    if (procps_root_set(root) < 0)
+        fail("procps_root_set");
+    bench_reap(PIDS_FETCH_TASKS_ONLY, iterations);
+    bench_reap(PIDS_FETCH_THREADS_TOO, iterations);
+    bench_select_sort(nprocs, nthreads, iterations);
+    bench_stat(iterations);
+    bench_irqs(STAT_IRQ_HARD, iterations);
+    bench_irqs(STAT_IRQ_SOFT, iterations);
+    bench_meminfo(iterations);
+    bench_vmstat(iterations);
+    bench_diskstats(iterations);
+    procps_root_set(NULL);
+
+    if (!keep && nftw(root, unlink_cb, 16, FTW_DEPTH | FTW_PHYS))
+        perror(root);
+    return EXIT_SUCCESS;
+}
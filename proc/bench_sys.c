@@ -0,0 +1,182 @@
+/*
+ * libprocps - Library to read proc filesystem
+ * Support common to the benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "bench_sys.h"
+
+/*
+ * Every libc entry point the library might use to reach a /proc file is
+ * interposed here, so that each can be tallied before being handed on to
+ * the real thing.  Those calls libc
+ * makes internally (readdir's getdents, for example) are not visible and
+ * thus are never counted.
+ *
+ * So too are the allocation functions, though those just hand on to the
+ * glibc originals directly (dlsym could itself need calloc).
+ */
+
+enum sys_call {
+    SC_open, SC_openat, SC_stat, SC_fstat, SC_read, SC_pread,
+    SC_readlink, SC_close, SC_count
+};
+
+static const char *sys_names[] = {
+    [SC_open]     = "open",
+    [SC_openat]   = "openat",
+    [SC_stat]     = "stat",
+    [SC_fstat]    = "fstat",
+    [SC_read]     = "read",
+    [SC_pread]    = "pread",
+    [SC_readlink] = "readlink",
+    [SC_close]    = "close"
+};
+
+static unsigned long sys_tally[SC_count];
+static unsigned long alloc_tally;
+static int counting;
+static struct timespec began;
+static double ns_total;
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void __libc_free (void *ptr);
+
+#define REAL(fn) ({ \
+    static __typeof__(&fn) real_ ## fn; \
+    if (!real_ ## fn) real_ ## fn = (__typeof__(&fn))dlsym(RTLD_NEXT, #fn); \
+    real_ ## fn; })
+
+#define TALLY(e) do { if (counting) __sync_fetch_and_add(&sys_tally[e], 1); } while (0)
+
+int open (const char *path, int flags, ...) {
+    mode_t mode = 0;
+    if (flags & O_CREAT) { va_list ap; va_start(ap, flags); mode = va_arg(ap, mode_t); va_end(ap); }
+    TALLY(SC_open);
+    return REAL(open)(path, flags, mode);
+}
+int openat (int dirfd, const char *path, int flags, ...) {
+    mode_t mode = 0;
+    if (flags & O_CREAT) { va_list ap; va_start(ap, flags); mode = va_arg(ap, mode_t); va_end(ap); }
+    TALLY(SC_openat);
+    return REAL(openat)(dirfd, path, flags, mode);
+}
+DIR *opendir (const char *path) {
+    TALLY(SC_open);
+    return REAL(opendir)(path);
+}
+FILE *fopen (const char *path, const char *mode) {
+    TALLY(SC_open);
+    return REAL(fopen)(path, mode);
+}
+int stat (const char *path, struct stat *sb) {
+    TALLY(SC_stat);
+    return REAL(stat)(path, sb);
+}
+int fstat (int fd, struct stat *sb) {
+    TALLY(SC_fstat);
+    return REAL(fstat)(fd, sb);
+}
+int fstatat (int dirfd, const char *path, struct stat *sb, int flags) {
+    TALLY(SC_stat);
+    return REAL(fstatat)(dirfd, path, sb, flags);
+}
+ssize_t read (int fd, void *buf, size_t count) {
+    TALLY(SC_read);
+    return REAL(read)(fd, buf, count);
+}
+ssize_t pread (int fd, void *buf, size_t count, off_t offset) {
+    TALLY(SC_pread);
+    return REAL(pread)(fd, buf, count, offset);
+}
+ssize_t readlink (const char *path, char *buf, size_t siz) {
+    TALLY(SC_readlink);
+    return REAL(readlink)(path, buf, siz);
+}
+ssize_t readlinkat (int dirfd, const char *path, char *buf, size_t siz) {
+    TALLY(SC_readlink);
+    return REAL(readlinkat)(dirfd, path, buf, siz);
+}
+int close (int fd) {
+    TALLY(SC_close);
+    return REAL(close)(fd);
+}
+
+void *malloc (size_t size) {
+    if (counting) __sync_fetch_and_add(&alloc_tally, 1);
+    return __libc_malloc(size);
+}
+void *calloc (size_t nmemb, size_t size) {
+    if (counting) __sync_fetch_and_add(&alloc_tally, 1);
+    return __libc_calloc(nmemb, size);
+}
+void *realloc (void *ptr, size_t size) {
+    if (counting) __sync_fetch_and_add(&alloc_tally, 1);
+    return __libc_realloc(ptr, size);
+}
+void free (void *ptr) {
+    __libc_free(ptr);
+}
+
+#undef REAL
+#undef TALLY
+
+
+void bench_start (void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    counting = 1;
+}
+
+void bench_stop (void)
+{
+    struct timespec end;
+
+    counting = 0;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns_total += (end.tv_sec - began.tv_sec) * 1e9 + (end.tv_nsec - began.tv_nsec);
+}
+
+void bench_report (const char *unit, long units)
+{
+    int i;
+
+    if (units < 1)
+        units = 1;
+    printf("  %10.0f ns/%s\n", ns_total / units, unit);
+    printf("  %10.2f allocs/%s\n", (double)alloc_tally / units, unit);
+    for (i = 0; i < SC_count; i++)
+        if (sys_tally[i])
+            printf("  %10.2f %s/%s\n", (double)sys_tally[i] / units, sys_names[i], unit);
+    memset(sys_tally, 0, sizeof(sys_tally));
+    alloc_tally = 0;
+    ns_total = 0;
+}
@@ -0,0 +1,30 @@
+/*
+ * libprocps - Library to read proc filesystem
+ * Support common to the benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef PROCPS_PROC_BENCH_SYS_H
+#define PROCPS_PROC_BENCH_SYS_H
+
+// Time (and tally the calls and allocations made by) whatever lies between
+// these two, with the totals accumulating until the next bench_report.
+void bench_start (void);
+void bench_stop (void);
+
+// Print those totals, per so many of some unit, and then zero them.
+void bench_report (const char *unit, long units);
+
+#endif
@@ -22,10 +22,12 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include "misc.h"
 #include "devname.h"
+#include "procps-private.h"
 
 // This is the buffer size for a tty name. Any path is legal,
 // which makes PAGE_SIZE appropriate (see kernel source), but
@@ -64,7 +66,8 @@ static void load_drivers(void){
   char *p;
   int fd;
   int bytes;
-  fd = open("/proc/tty/drivers",O_RDONLY);
+  procps_rootf(buf, sizeof buf, "/proc/tty/drivers");
+  fd = open(buf,O_RDONLY);
   if(fd == -1) goto fail;
   bytes = read(fd, buf, sizeof(buf) - 1);
   if(bytes == -1) goto fail;
@@ -114,6 +117,14 @@ fail:
   if(!tty_map) tty_map = (tty_map_node *)-1;
 }
 
+/* Like stat(), but of some /dev name beneath any procps_root_set prefix. */
+static int root_stat(const char *restrict const name, struct stat *restrict const sbuf){
+  char path[PROCPS_ROOTMAX + TTY_NAME_SIZE];
+  const int len = procps_rootf(path, sizeof path, "%s", name);
+  if(len <= 0 || (size_t)len >= sizeof path) return -1;
+  return stat(path, sbuf);
+}
+
 /* Try to guess the device name from /proc/tty/drivers info. */
 static int driver_name(char *restrict const buf, unsigned maj, unsigned min){
   struct stat sbuf;
@@ -127,12 +138,12 @@ static int driver_name(char *restrict const buf, unsigned maj, unsigned min){
     tmn = tmn->next;
   }
   sprintf(buf, "/dev/%s%d", tmn->name, min);  /* like "/dev/ttyZZ255" */
-  if(stat(buf, &sbuf) < 0){
+  if(root_stat(buf, &sbuf) < 0){
     sprintf(buf, "/dev/%s/%d", tmn->name, min);  /* like "/dev/pts/255" */
-    if(stat(buf, &sbuf) < 0){
+    if(root_stat(buf, &sbuf) < 0){
       if(tmn->devfs_type) return 0;
       sprintf(buf, "/dev/%s", tmn->name);  /* like "/dev/ttyZZ255" */
-      if(stat(buf, &sbuf) < 0) return 0;
+      if(root_stat(buf, &sbuf) < 0) return 0;
     }
   }
   if(min != minor(sbuf.st_rdev)) return 0;
@@ -270,26 +281,173 @@ static int guess_name(char *restrict const buf, unsigned maj, unsigned min){
   case 256:  sprintf(buf, "/dev/ttyEQ%d",  min); break;
   default: return 0;
   }
-  if(stat(buf, &sbuf) < 0) return 0;
+  if(root_stat(buf, &sbuf) < 0) return 0;
   if(min != minor(sbuf.st_rdev)) return 0;
   if(maj != major(sbuf.st_rdev)) return 0;
   return 1;
 }
 
+/* Those names found without regard to any pid are remembered, per thread, in
+ * a table keyed by device number.  A failure is remembered too, but only until
+ * devname_refresh() is called (by pids with every reap).  The /dev/pts names
+ * are all loaded at once, and again after a refresh should some pty be missed.
+ * A name from guess_name is marked as such, since a task's fd/2 still wins.
+ */
+typedef struct tty_name_ent {
+  unsigned dev;               // zero when the slot is empty
+  unsigned gen;               // when a failure, the generation it occurred
+  int guessed;                // from guess_name, not the drivers or /dev/pts
+  char *name;                 // NULL for a failure
+} tty_name_ent;
+
+#define TTY_HASH_INIT 256     // power of 2
+
+static unsigned tty_gen;      // bumped by devname_refresh
+static __thread tty_name_ent *tty_names;
+static __thread unsigned tty_names_mask;
+static __thread unsigned tty_names_used;
+static __thread unsigned pts_scan_gen = -1;
+
+static tty_name_ent *tty_find(unsigned dev){
+  unsigned i;
+  if(!tty_names) return NULL;
+  for(i = (dev * 0x9E3779B1u) & tty_names_mask; tty_names[i].dev; i = (i + 1) & tty_names_mask)
+    if(tty_names[i].dev == dev) return &tty_names[i];
+  return NULL;
+}
+
+static int tty_grow(void){
+  tty_name_ent *old = tty_names;
+  unsigned i, j, oldsiz = old ? tty_names_mask + 1 : 0;
+  unsigned siz = oldsiz ? oldsiz * 2 : TTY_HASH_INIT;
+  if(!(tty_names = calloc(siz, sizeof(tty_name_ent)))){
+    tty_names = old;
+    return 0;
+  }
+  tty_names_mask = siz - 1;
+  for(i = 0; i < oldsiz; i++){
+    if(!old[i].dev) continue;
+    for(j = (old[i].dev * 0x9E3779B1u) & tty_names_mask; tty_names[j].dev; j = (j + 1) & tty_names_mask)
+      ;
+    tty_names[j] = old[i];
+  }
+  free(old);
+  return 1;
+}
+
+/* Remember a name (or NULL for a failure) for some device number. */
+static void tty_remember(unsigned dev, const char *name, int guessed){
+  tty_name_ent *ent;
+  unsigned i;
+  if(!(ent = tty_find(dev))){
+    if(!tty_names || (tty_names_used + 1) * 4 > (tty_names_mask + 1) * 3)
+      if(!tty_grow()) return;
+    for(i = (dev * 0x9E3779B1u) & tty_names_mask; tty_names[i].dev; i = (i + 1) & tty_names_mask)
+      ;
+    ent = &tty_names[i];
+    ent->dev = dev;
+    ent->name = NULL;
+    tty_names_used++;
+  }
+  if(ent->name) return;       // the first name found stands
+  ent->gen = __atomic_load_n(&tty_gen, __ATOMIC_RELAXED);
+  ent->guessed = guessed;
+  if(name) ent->name = strdup(name);
+}
+
+/* Load every /dev/pts name, with one stat apiece, rather than probing for
+ * each task's.  Those names no longer there are simply never asked for. */
+static void load_pts(void){
+  char buf[TTY_NAME_SIZE];
+  char path[PROCPS_ROOTMAX + 32];
+  struct dirent *ent;
+  struct stat sbuf;
+  size_t len;
+  DIR *dir;
+  pts_scan_gen = __atomic_load_n(&tty_gen, __ATOMIC_RELAXED);
+  procps_rootf(path, sizeof path, "/dev/pts");
+  if(!(dir = opendir(path))) return;
+  while((ent = readdir(dir))){
+    if(ent->d_name[0] < '0' || ent->d_name[0] > '9') continue;
+    if(fstatat(dirfd(dir), ent->d_name, &sbuf, AT_SYMLINK_NOFOLLOW) < 0) continue;
+    if(!S_ISCHR(sbuf.st_mode)) continue;
+    if((len = strlen(ent->d_name)) + 9 >= sizeof buf) continue;
+    memcpy(buf, "/dev/pts/", 9);
+    memcpy(buf + 9, ent->d_name, len + 1);
+    tty_remember(sbuf.st_rdev, buf, 0);
+  }
+  closedir(dir);
+}
+
+/* Have any failures remembered be retried, since devices may since exist. */
+void devname_refresh(void){
+  __atomic_add_fetch(&tty_gen, 1, __ATOMIC_RELAXED);
+}
+
+/* Forget this thread's drivers and names, as it's about to exit. */
+void devname_thread_free(void){
+  tty_map_node *tmn;
+  unsigned i;
+  while(tty_map && tty_map != (tty_map_node *)-1){
+    tmn = tty_map;
+    tty_map = tmn->next;
+    free(tmn);
+  }
+  tty_map = NULL;
+  for(i = 0; tty_names && i <= tty_names_mask; i++)
+    free(tty_names[i].name);
+  free(tty_names);
+  tty_names = NULL;
+  tty_names_mask = tty_names_used = 0;
+  pts_scan_gen = -1;
+}
+
+/* Find a name without resorting to any pid's links, usually from the table.
+ * On a miss, the drivers and the usual names are probed just as before.  The
+ * caller must still try fd/2 before using any name which was *guessed. */
+static int known_name(char *restrict const buf, unsigned dev, int *guessed){
+  unsigned gen = __atomic_load_n(&tty_gen, __ATOMIC_RELAXED);
+  tty_name_ent *ent = tty_find(dev);
+  if(ent && (ent->name || ent->gen == gen)) goto found;
+#ifndef __CYGWIN__
+  if(major(dev) >= 136 && major(dev) <= 143 && pts_scan_gen != gen){
+    load_pts();
+    if((ent = tty_find(dev)) && ent->name) goto found;
+  }
+#endif
+  if(driver_name(buf, major(dev), minor(dev))){
+    tty_remember(dev, buf, 0);
+    *guessed = 0;
+    return 1;
+  }
+  if(guess_name(buf, major(dev), minor(dev))){
+    tty_remember(dev, buf, 1);
+    *guessed = 1;
+    return 1;
+  }
+  tty_remember(dev, NULL, 0);
+  return 0;
+found:
+  if(!ent->name) return 0;
+  strcpy(buf, ent->name);
+  *guessed = ent->guessed;
+  return 1;
+}
+
 /* Linux 2.2 can give us filenames that might be correct.
  * Useful names could be in /proc/PID/fd/2 (stderr, seldom redirected)
  * and in /proc/PID/fd/255 (used by bash to remember the tty).
  */
 static int link_name(char *restrict const buf, unsigned maj, unsigned min, int pid, const char *restrict name){
   struct stat sbuf;
-  char path[32];
+  char path[PROCPS_ROOTMAX + 32];
   ssize_t count;
-  const int len = snprintf(path, sizeof path, "/proc/%d/%s", pid, name);  /* often permission denied */
+  const int len = procps_rootf(path, sizeof path, "/proc/%d/%s", pid, name);  /* often permission denied */
   if(len <= 0 || (size_t)len >= sizeof path) return 0;
   count = readlink(path,buf,TTY_NAME_SIZE-1);
   if(count <= 0 || count >= TTY_NAME_SIZE-1) return 0;
   buf[count] = '\0';
-  if(stat(buf, &sbuf) < 0) return 0;
+  if(root_stat(buf, &sbuf) < 0) return 0;
   if(min != minor(sbuf.st_rdev)) return 0;
   if(maj != major(sbuf.st_rdev)) return 0;
   return 1;
@@ -299,10 +457,10 @@ static int link_name(char *restrict const buf, unsigned maj, unsigned min, int p
 /* Cygwin keeps the name to the controlling tty in a virtual file called
    /proc/PID/ctty, including a trailing LF (sigh). */
 static int ctty_name(char *restrict const buf, int pid) {
-  char path[32];
+  char path[PROCPS_ROOTMAX + 32];
   FILE *fp;
   char *lf;
-  sprintf (path, "/proc/%d/ctty", pid);  /* often permission denied */
+  procps_rootf (path, sizeof path, "/proc/%d/ctty", pid);  /* often permission denied */
   fp = fopen (path, "r");
   if (!fp)
     return 0;
@@ -322,17 +480,19 @@ static int ctty_name(char *restrict const buf, int pid) {
 /* number --> name */
 unsigned dev_to_tty(char *restrict ret, unsigned chop, dev_t dev_t_dev, int pid, unsigned int flags) {
   static __thread char buf[TTY_NAME_SIZE];
+  char guess[TTY_NAME_SIZE];
   char *restrict tmp = buf;
   unsigned dev = dev_t_dev;
   unsigned i = 0;
-  int c;
+  int c, guessed = 0;
 #ifdef USE_PROC_CTTY
   if(  ctty_name(tmp, pid                                        )) goto abbrev;
 #endif
   if(dev == 0u) goto no_tty;
-  if(driver_name(tmp, major(dev), minor(dev)               )) goto abbrev;
+  // the same order as ever: drivers, fd/2, the usual names, then fd/255
+  if( known_name(guess, dev, &guessed) && !guessed) { strcpy(tmp, guess); goto abbrev; }
   if(  link_name(tmp, major(dev), minor(dev), pid, "fd/2"  )) goto abbrev;
-  if( guess_name(tmp, major(dev), minor(dev)               )) goto abbrev;
+  if(            guessed                                   ) { strcpy(tmp, guess); goto abbrev; }
   if(  link_name(tmp, major(dev), minor(dev), pid, "fd/255")) goto abbrev;
   // fall through if unable to find a device file
 no_tty:
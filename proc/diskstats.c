@@ -35,6 +35,8 @@
 
 #include <proc/procps-private.h>
 #include <proc/diskstats.h>
+#include <proc/keyhash.h>
+#include <proc/record.h>
 
 /* The following define will cause the 'node_add' function to maintain our |
    nodes list in ascending alphabetical order which could be used to avoid |
@@ -47,7 +49,11 @@
 #define DISKSTATS_FILE      "/proc/diskstats"
 #define SYSBLOCK_DIR        "/sys/block"
 
+#define DISKSTATS_MAX_VALS  17           // counters in the most recent format
+#define NSECS_PER_SEC       1000000000ULL
+
 #define STACKS_INCR         64           // amount reap stack allocations grow
+#define HASH_INCR           64           // initial (and least) hash buckets
 #define STR_COMPARE         strverscmp
 
 /* ----------------------------------------------------------------------- +
@@ -70,6 +76,12 @@ struct dev_data {
     unsigned long io_inprogress;
     unsigned long io_time;
     unsigned long io_wtime;
+    unsigned long discards;            // since 4.18, else zero
+    unsigned long discards_merged;
+    unsigned long discard_sectors;
+    unsigned long discard_time;
+    unsigned long flushes;             // since 5.5, else zero
+    unsigned long flush_time;
 };
 
 struct dev_node {
@@ -77,10 +89,27 @@ struct dev_node {
     int type;
     int major;
     int minor;
-    time_t stamped;
+    int fields;
+    unsigned long long stamped;        // CLOCK_MONOTONIC nsecs of 'new'
+    unsigned long long old_stamped;    //   ditto, of 'old'
     struct dev_data new;
     struct dev_data old;
     struct dev_node *next;
+    struct dev_node *hnext;            // next with the same major/minor hash
+};
+
+struct dev_hash {
+    struct dev_node **buckets;         // by major & minor, for every node
+    unsigned mask;                     // buckets - 1 (a power of 2)
+    int count;                         // nodes in all of those buckets
+};
+
+struct sys_block {
+    char *names;                       // /sys/block entries, nul separated
+    struct keyhash_key *keys;          // those names, as keyhash wants them
+    struct keyhash *hash;              // and those keys hashed, if any
+    int unreadable;                    // no /sys/block, so all are disks
+    int scanned;                       // /sys/block was read this read
 };
 
 struct stacks_extent {
@@ -106,9 +135,12 @@ struct fetch_support {
 struct diskstats_info {
     int refcount;
     FILE *diskstats_fp;
-    time_t old_stamp;                  // previous read seconds
-    time_t new_stamp;                  // current read seconds
+    unsigned long long old_stamp;      // previous read nsecs (monotonic)
+    unsigned long long new_stamp;      // current read nsecs (monotonic)
     struct dev_node *nodes;            // dev nodes anchor
+    struct dev_node *tail;             // the last such node
+    struct dev_hash hash;              // those nodes by major & minor
+    struct sys_block disks;            // which devices are whole disks
     struct ext_support select_ext;     // supports concurrent select/reap
     struct ext_support fetch_ext;      // supports concurrent select/reap
     struct fetch_support fetch;        // support for procps_diskstats_reap
@@ -127,6 +159,19 @@ struct diskstats_info {
 #define REG_set(e,t,x) setDECL(e) { R->result. t = N->new. x; }
 // delta assignment
 #define HST_set(e,t,x) setDECL(e) { R->result. t = ( N->new. x - N->old. x ); }
+// per second assignment
+#define RTE_set(e,x) setDECL(e) { R->result.real = diskstats_rate(N, N->new. x - N->old. x); }
+
+static inline double diskstats_rate (
+        struct dev_node *N,
+        unsigned long delta)
+{
+    unsigned long long nsecs = N->stamped - N->old_stamped;
+
+    if (!nsecs)
+        return 0.0;
+    return (double)delta * NSECS_PER_SEC / nsecs;
+}
 
 setDECL(noop)  { (void)R; (void)N; }
 setDECL(extra) { (void)N; R->result.ul_int = 0; }
@@ -160,10 +205,42 @@ HST_set(DELTA_WRITE_TIME,     s_int,   write_time)
 HST_set(DELTA_IO_TIME,        s_int,   io_time)
 HST_set(DELTA_WEIGHTED_TIME,  s_int,   io_wtime)
 
+DEV_set(FIELDS,               s_int,   fields)
+REG_set(DISCARDS,             ul_int,  discards)
+REG_set(DISCARDS_MERGED,      ul_int,  discards_merged)
+REG_set(DISCARD_SECTORS,      ul_int,  discard_sectors)
+REG_set(DISCARD_TIME,         ul_int,  discard_time)
+REG_set(FLUSHES,              ul_int,  flushes)
+REG_set(FLUSH_TIME,           ul_int,  flush_time)
+
+HST_set(DELTA_DISCARDS,       s_int,   discards)
+HST_set(DELTA_DISCARDS_MERGED, s_int,  discards_merged)
+HST_set(DELTA_DISCARD_SECTORS, s_int,  discard_sectors)
+HST_set(DELTA_DISCARD_TIME,   s_int,   discard_time)
+HST_set(DELTA_FLUSHES,        s_int,   flushes)
+HST_set(DELTA_FLUSH_TIME,     s_int,   flush_time)
+
+DEV_set(STAMP_NSECS,          ull_int, stamped)
+setDECL(DELTA_NSECS)          { R->result.ull_int = N->stamped - N->old_stamped; }
+
+RTE_set(RATE_READS,                    reads)
+RTE_set(RATE_READ_SECTORS,             read_sectors)
+RTE_set(RATE_WRITES,                   writes)
+RTE_set(RATE_WRITE_SECTORS,            write_sectors)
+RTE_set(RATE_DISCARDS,                 discards)
+RTE_set(RATE_DISCARD_SECTORS,          discard_sectors)
+RTE_set(RATE_FLUSHES,                  flushes)
+setDECL(UTILIZATION) {
+    // io_time is in msecs, so 1000 per second would be 100% busy
+    double pcnt = diskstats_rate(N, N->new.io_time - N->old.io_time) / 10.0;
+    R->result.real = pcnt > 100.0 ? 100.0 : pcnt;
+}
+
 #undef setDECL
 #undef DEV_set
 #undef REG_set
 #undef HST_set
+#undef RTE_set
 
 
 // ___ Sorting Support ||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -191,6 +268,22 @@ srtDECL(ul_int) {
     return 0;
 }
 
+srtDECL(ull_int) {
+    const struct diskstats_result *a = (*A)->head + P->offset; \
+    const struct diskstats_result *b = (*B)->head + P->offset; \
+    if ( a->result.ull_int > b->result.ull_int ) return P->order > 0 ?  1 : -1; \
+    if ( a->result.ull_int < b->result.ull_int ) return P->order > 0 ? -1 :  1; \
+    return 0;
+}
+
+srtDECL(real) {
+    const struct diskstats_result *a = (*A)->head + P->offset; \
+    const struct diskstats_result *b = (*B)->head + P->offset; \
+    if ( a->result.real > b->result.real ) return P->order > 0 ?  1 : -1; \
+    if ( a->result.real < b->result.real ) return P->order > 0 ? -1 :  1; \
+    return 0;
+}
+
 srtDECL(str) {
     const struct diskstats_result *a = (*A)->head + P->offset;
     const struct diskstats_result *b = (*B)->head + P->offset;
@@ -266,6 +359,33 @@ static struct {
   { RS(DELTA_WRITE_TIME),     QS(s_int),   TS(s_int)  },
   { RS(DELTA_IO_TIME),        QS(s_int),   TS(s_int)  },
   { RS(DELTA_WEIGHTED_TIME),  QS(s_int),   TS(s_int)  },
+
+  { RS(FIELDS),               QS(s_int),   TS(s_int)  },
+  { RS(DISCARDS),             QS(ul_int),  TS(ul_int) },
+  { RS(DISCARDS_MERGED),      QS(ul_int),  TS(ul_int) },
+  { RS(DISCARD_SECTORS),      QS(ul_int),  TS(ul_int) },
+  { RS(DISCARD_TIME),         QS(ul_int),  TS(ul_int) },
+  { RS(FLUSHES),              QS(ul_int),  TS(ul_int) },
+  { RS(FLUSH_TIME),           QS(ul_int),  TS(ul_int) },
+
+  { RS(DELTA_DISCARDS),       QS(s_int),   TS(s_int)  },
+  { RS(DELTA_DISCARDS_MERGED), QS(s_int),  TS(s_int)  },
+  { RS(DELTA_DISCARD_SECTORS), QS(s_int),  TS(s_int)  },
+  { RS(DELTA_DISCARD_TIME),   QS(s_int),   TS(s_int)  },
+  { RS(DELTA_FLUSHES),        QS(s_int),   TS(s_int)  },
+  { RS(DELTA_FLUSH_TIME),     QS(s_int),   TS(s_int)  },
+
+  { RS(STAMP_NSECS),          QS(ull_int), TS(ull_int) },
+  { RS(DELTA_NSECS),          QS(ull_int), TS(ull_int) },
+
+  { RS(RATE_READS),           QS(real),    TS(real)   },
+  { RS(RATE_READ_SECTORS),    QS(real),    TS(real)   },
+  { RS(RATE_WRITES),          QS(real),    TS(real)   },
+  { RS(RATE_WRITE_SECTORS),   QS(real),    TS(real)   },
+  { RS(RATE_DISCARDS),        QS(real),    TS(real)   },
+  { RS(RATE_DISCARD_SECTORS), QS(real),    TS(real)   },
+  { RS(RATE_FLUSHES),         QS(real),    TS(real)   },
+  { RS(UTILIZATION),          QS(real),    TS(real)   },
 };
 
     /* please note,
@@ -285,11 +405,13 @@ static struct dev_node *node_add (
         struct diskstats_info *info,
         struct dev_node *this)
 {
+#ifdef ALPHABETIC_NODES
     struct dev_node *prev, *walk;
 
-#ifdef ALPHABETIC_NODES
     if (!info->nodes
     || (STR_COMPARE(this->name, info->nodes->name) < 0)) {
+        if (!info->nodes)
+            info->tail = this;
         this->next = info->nodes;
         info->nodes = this;
         return this;
@@ -304,45 +426,178 @@ static struct dev_node *node_add (
     }
     prev->next = this;
     this->next = walk;
+    if (!walk)
+        info->tail = this;
 #else
+    this->next = NULL;
     if (!info->nodes)
         info->nodes = this;
-    else {
-        walk = info->nodes;
-        do {
-            prev = walk;
-            walk = walk->next;
-        } while (walk);
-        prev->next = this;
-    }
+    else
+        info->tail->next = this;
+    info->tail = this;
 #endif
     return this;
 } // end: node_add
 
 
-static void node_classify (
+static inline unsigned node_hash (
+        struct diskstats_info *info,
+        int major,
+        int minor)
+{
+    unsigned h = (unsigned)major * 0x9e3779b1u ^ (unsigned)minor * 0x85ebca6bu;
+
+    return (h ^ (h >> 16)) & info->hash.mask;
+} // end: node_hash
+
+
+static int node_hash_add_failed (
+        struct diskstats_info *info,
         struct dev_node *this)
 {
+    struct dev_node **old, *node, *next;
+    unsigned i, b, oldmask;
+
+    // we'll keep to an average of no more than 2 nodes per bucket
+    if (!info->hash.buckets || info->hash.count >= 2 * (int)(info->hash.mask + 1)) {
+        old = info->hash.buckets;
+        oldmask = info->hash.mask;
+        i = old ? (oldmask + 1) * 2 : HASH_INCR;
+        if (!(info->hash.buckets = calloc(i, sizeof(void *)))) {
+            info->hash.buckets = old;
+            return 1;        // here, errno was set to ENOMEM
+        }
+        info->hash.mask = i - 1;
+        for (i = 0; old && i <= oldmask; i++) {
+            for (node = old[i]; node; node = next) {
+                next = node->hnext;
+                b = node_hash(info, node->major, node->minor);
+                node->hnext = info->hash.buckets[b];
+                info->hash.buckets[b] = node;
+            }
+        }
+        free(old);
+    }
+    b = node_hash(info, this->major, this->minor);
+    this->hnext = info->hash.buckets[b];
+    info->hash.buckets[b] = this;
+    info->hash.count++;
+    return 0;
+} // end: node_hash_add_failed
+
+
+static void node_hash_cut (
+        struct diskstats_info *info,
+        struct dev_node *this)
+{
+    struct dev_node **walk;
+
+    walk = &info->hash.buckets[node_hash(info, this->major, this->minor)];
+    for ( ; *walk; walk = &(*walk)->hnext) {
+        if (*walk == this) {
+            *walk = this->hnext;
+            info->hash.count--;
+            return;
+        }
+    }
+} // end: node_hash_cut
+
+
+static void sysblock_free (
+        struct sys_block *this)
+{
+    keyhash_destroy(this->hash);
+    free(this->keys);
+    free(this->names);
+    this->hash = NULL;
+    this->keys = NULL;
+    this->names = NULL;
+} // end: sysblock_free
+
+
+/*
+ * sysblock_scan_failed:
+ *
+ * Remember the names found in /sys/block, at most once per read and
+ * then only when some new device has appeared in /proc/diskstats.
+ *
+ * Returns: 0 on success, 1 on error (with errno set to ENOMEM)
+ */
+static int sysblock_scan_failed (
+        struct diskstats_info *info)
+{
+    struct sys_block *this = &info->disks;
+    char path[PROCPS_ROOTMAX + 32];
     DIR *dirp;
     struct dirent *dent;
+    size_t len, used = 0, size = 0;
+    char *p;
+    int i, n = 0;
+
+    sysblock_free(this);
+    this->scanned = 1;
+
+    procps_rootf(path, sizeof(path), SYSBLOCK_DIR);
+    if (!(dirp = opendir(path))) {
+        this->unreadable = 1;
+        return 0;
+    }
+    this->unreadable = 0;
+    while ((dent = readdir(dirp))) {
+        if (dent->d_name[0] == '.')
+            continue;
+        len = strlen(dent->d_name) + 1;
+        if (len > DISKSTATS_NAME_LEN + 1)
+            continue;
+        if (used + len > size) {
+            size = size ? size * 2 : BUFSIZ;
+            if (!(p = realloc(this->names, size)))
+                goto nomem;
+            this->names = p;
+        }
+        memcpy(this->names + used, dent->d_name, len);
+        used += len;
+        n++;
+    }
+    closedir(dirp);
+    if (!n)
+        return 0;
 
+    if (!(this->keys = calloc(n, sizeof(struct keyhash_key))))
+        goto nomem_closed;
+    for (i = 0, p = this->names; i < n; i++) {
+        this->keys[i].name = p;
+        this->keys[i].len = strlen(p);
+        p += this->keys[i].len + 1;
+    }
+    if (!(this->hash = keyhash_create(this->keys, n)))
+        goto nomem_closed;
+    return 0;
+
+nomem:
+    closedir(dirp);
+nomem_closed:
+    sysblock_free(this);
+    errno = ENOMEM;
+    return 1;
+} // end: sysblock_scan_failed
+
+
+static void node_classify (
+        struct diskstats_info *info,
+        struct dev_node *this)
+{
     /* all disks start off as partitions. this function
        checks /sys/block and changes a device found there
        into a disk. if /sys/block cannot have the directory
        read, all devices are then treated as disks. */
     this->type = DISKSTATS_TYPE_PARTITION;
 
-    if (!(dirp = opendir(SYSBLOCK_DIR))) {
+    if (info->disks.unreadable)
+        this->type = DISKSTATS_TYPE_DISK;
+    else if (info->disks.hash
+    && (keyhash_find(info->disks.hash, this->name, strlen(this->name)) >= 0))
         this->type = DISKSTATS_TYPE_DISK;
-        return;
-    }
-    while ((dent = readdir(dirp))) {
-        if (strcmp(this->name, dent->d_name) == 0) {
-            this->type = DISKSTATS_TYPE_DISK;
-            break;
-        }
-    }
-    closedir(dirp);
 } // end: node_classify
 
 
@@ -353,13 +608,18 @@ static struct dev_node *node_cut (
     struct dev_node *node = info->nodes;
 
     if (this) {
+        node_hash_cut(info, this);
         if (this == node) {
             info->nodes = node->next;
+            if (info->tail == this)
+                info->tail = NULL;
             return this;
         }
         do {
             if (this == node->next) {
                 node->next = node->next->next;
+                if (info->tail == this)
+                    info->tail = node;
                 return this;
             }
             node = node->next;
@@ -369,6 +629,41 @@ static struct dev_node *node_cut (
 } // end: node_cut
 
 
+static inline int node_stale (
+        struct diskstats_info *info,
+        struct dev_node *node)
+{
+    /* if this disk or partition has somehow gotten stale, we'll lose
+       it and then pretend it was never actually found ...
+     [ we test against both stamps in case a 'read' was avoided ] */
+    return node->stamped != info->old_stamp
+        && node->stamped != info->new_stamp;
+} // end: node_stale
+
+
+static struct dev_node *node_find (
+        struct diskstats_info *info,
+        struct dev_node *source)
+{
+    struct dev_node *node = NULL;
+
+    if (info->hash.buckets) {
+        node = info->hash.buckets[node_hash(info, source->major, source->minor)];
+        while (node) {
+            if (node->major == source->major && node->minor == source->minor)
+                break;
+            node = node->hnext;
+        }
+    }
+    // a device number reused under some other name is another device
+    if (node && strcmp(source->name, node->name)) {
+        free(node_cut(info, node));
+        node = NULL;
+    }
+    return node;
+} // end: node_find
+
+
 static struct dev_node *node_get (
         struct diskstats_info *info,
         const char *name)
@@ -380,43 +675,60 @@ static struct dev_node *node_get (
             break;
         node = node->next;
     }
-    if (node) {
-        /* if this disk or partition has somehow gotten stale, we'll lose
-           it and then pretend it was never actually found ...
-         [ we test against both stamps in case a 'read' was avoided ] */
-        if (node->stamped != info->old_stamp
-        && (node->stamped != info->new_stamp)) {
-            free(node_cut(info, node));
-            node = NULL;
-        }
+    if (node && node_stale(info, node)) {
+        free(node_cut(info, node));
+        node = NULL;
     }
     return node;
 } // end: node_get
 
 
+static void node_sweep (
+        struct diskstats_info *info)
+{
+    struct dev_node *node = info->nodes, *next;
+
+    /* whatever wasn't in this read is gone, lest a device that returns
+       (maybe under a new number) be found twice by name ... */
+    while (node) {
+        next = node->next;
+        if (node->stamped != info->new_stamp)
+            free(node_cut(info, node));
+        node = next;
+    }
+} // end: node_sweep
+
+
 static int node_update (
         struct diskstats_info *info,
         struct dev_node *source)
 {
-    struct dev_node *target = node_get(info, source->name);
+    struct dev_node *target = node_find(info, source);
 
     if (!target) {
+        if (!info->disks.scanned && sysblock_scan_failed(info))
+            return 0;        // here, errno was set to ENOMEM
         if (!(target = malloc(sizeof(struct dev_node))))
             return 0;
         memcpy(target, source, sizeof(struct dev_node));
         // let's not distort the deltas when a new node is created ...
         memcpy(&target->old, &target->new, sizeof(struct dev_data));
-        node_classify(target);
+        target->old_stamped = target->stamped;
+        node_classify(info, target);
+        if (node_hash_add_failed(info, target)) {
+            free(target);
+            return 0;
+        }
         node_add(info, target);
         return 1;
     }
     // remember history from last time around ...
-    memcpy(&source->old, &target->new, sizeof(struct dev_data));
-    // preserve some stuff from the existing node struct ...
-    source->type = target->type;
-    source->next = target->next;
+    memcpy(&target->old, &target->new, sizeof(struct dev_data));
     // finally 'update' the existing node struct ...
-    memcpy(target, source, sizeof(struct dev_node));
+    memcpy(&target->new, &source->new, sizeof(struct dev_data));
+    target->old_stamped = target->stamped;
+    target->stamped = source->stamped;
+    target->fields = source->fields;
     return 1;
 } // end: node_update
 
@@ -498,6 +810,65 @@ static inline int diskstats_items_check_failed (
 } // end: diskstats_items_check_failed
 
 
+static inline unsigned long long diskstats_clock (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * NSECS_PER_SEC + ts.tv_nsec;
+} // end: diskstats_clock
+
+
+/*
+ * diskstats_parse_failed:
+ *
+ * Fill a node from one line of /proc/diskstats, which will have 14
+ * fields, 18 (with discards, since 4.18) or 20 (with flushes, 5.5).
+ * Any more which some later kernel adds are ignored.
+ *
+ * Returns: 0 on success, 1 on error
+ */
+static int diskstats_parse_failed (
+        char *buf,
+        struct dev_node *node)
+{
+    unsigned long *vals[DISKSTATS_MAX_VALS] = {
+        &node->new.reads,    &node->new.reads_merged,    &node->new.read_sectors,    &node->new.read_time,
+        &node->new.writes,   &node->new.writes_merged,   &node->new.write_sectors,   &node->new.write_time,
+        &node->new.io_inprogress, &node->new.io_time,    &node->new.io_wtime,
+        &node->new.discards, &node->new.discards_merged, &node->new.discard_sectors, &node->new.discard_time,
+        &node->new.flushes,  &node->new.flush_time };
+    char *p = buf, *end;
+    size_t len;
+    int n;
+
+    node->major = strtol(p, &end, 10);
+    if (end == p)
+        return 1;
+    node->minor = strtol(p = end, &end, 10);
+    if (end == p)
+        return 1;
+    p = end + strspn(end, " \t");
+    if (!(len = strcspn(p, " \t\n")) || len > DISKSTATS_NAME_LEN)
+        return 1;
+    memcpy(node->name, p, len);
+    node->name[len] = '\0';
+    p += len;
+
+    for (n = 0; n < DISKSTATS_MAX_VALS; n++) {
+        *vals[n] = strtoul(p, &end, 10);
+        if (end == p)
+            break;
+        p = end;
+    }
+    // the 11 counters in all formats are the least we'll accept
+    if (n < 11)
+        return 1;
+    node->fields = 3 + n;
+    return 0;
+} // end: diskstats_parse_failed
+
+
 /*
  * diskstats_read_failed:
  *
@@ -511,43 +882,25 @@ static inline int diskstats_items_check_failed (
 static int diskstats_read_failed (
         struct diskstats_info *info)
 {
-    static const char *fmtstr = "%d %d %" STRINGIFY(DISKSTATS_NAME_LEN) \
-        "s %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu";
     char buf[DISKSTATS_LINE_LEN];
     struct dev_node node;
-    int rc;
 
     if (!info->diskstats_fp
-    && (!(info->diskstats_fp = fopen(DISKSTATS_FILE, "r"))))
+    && (!(info->diskstats_fp = replay_fopen(DISKSTATS_FILE))))
         return 1;
 
     if (fseek(info->diskstats_fp, 0L, SEEK_SET) == -1)
         return 1;
 
     info->old_stamp = info->new_stamp;
-    info->new_stamp = time(NULL);
+    info->new_stamp = diskstats_clock();
+    info->disks.scanned = 0;
 
     while (fgets(buf, DISKSTATS_LINE_LEN, info->diskstats_fp)) {
         // clear out the soon to be 'current'values
         memset(&node, 0, sizeof(struct dev_node));
 
-        rc = sscanf(buf, fmtstr
-            , &node.major
-            , &node.minor
-            , &node.name[0]
-            , &node.new.reads
-            , &node.new.reads_merged
-            , &node.new.read_sectors
-            , &node.new.read_time
-            , &node.new.writes
-            , &node.new.writes_merged
-            , &node.new.write_sectors
-            , &node.new.write_time
-            , &node.new.io_inprogress
-            , &node.new.io_time
-            , &node.new.io_wtime);
-
-        if (rc != 14) {
+        if (diskstats_parse_failed(buf, &node)) {
             errno = ERANGE;
             return 1;
         }
@@ -555,6 +908,7 @@ static int diskstats_read_failed (
         if (!node_update(info, &node))
             return 1;        // here, errno was set to ENOMEM
     }
+    node_sweep(info);
 
     return 0;
 } // end: diskstats_read_failed
@@ -782,6 +1136,8 @@ PROCPS_EXPORT int procps_diskstats_unref (
             node = p->next;
             free(p);
         }
+        free((*info)->hash.buckets);
+        sysblock_free(&(*info)->disks);
         if ((*info)->select_ext.extents)
             diskstats_extents_free_all((&(*info)->select_ext));
         if ((*info)->select_ext.items)
@@ -815,7 +1171,6 @@ PROCPS_EXPORT struct diskstats_result *procps_diskstats_get (
         enum diskstats_item item)
 {
     struct dev_node *node;
-    time_t cur_secs;
 
     errno = EINVAL;
     if (info == NULL)
@@ -826,8 +1181,7 @@ PROCPS_EXPORT struct diskstats_result *procps_diskstats_get (
 
     /* we will NOT read the diskstat file with every call - rather, we'll offer
        a granularity of 1 second between reads ... */
-    cur_secs = time(NULL);
-    if (1 <= cur_secs - info->new_stamp) {
+    if (NSECS_PER_SEC <= diskstats_clock() - info->new_stamp) {
         if (diskstats_read_failed(info))
             return NULL;
     }
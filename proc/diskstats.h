@@ -59,7 +59,34 @@ enum diskstats_item {
     DISKSTATS_DELTA_WRITE_SECTORS,  //    s_int         "
     DISKSTATS_DELTA_WRITE_TIME,     //    s_int         "
     DISKSTATS_DELTA_IO_TIME,        //    s_int         "
-    DISKSTATS_DELTA_WEIGHTED_TIME   //    s_int         "
+    DISKSTATS_DELTA_WEIGHTED_TIME,  //    s_int         "
+
+    DISKSTATS_FIELDS,               //    s_int        /proc/diskstats, 14, 18 or 20
+    DISKSTATS_DISCARDS,             //   ul_int        /proc/diskstats, 0 if < 18 fields
+    DISKSTATS_DISCARDS_MERGED,      //   ul_int         "
+    DISKSTATS_DISCARD_SECTORS,      //   ul_int         "
+    DISKSTATS_DISCARD_TIME,         //   ul_int         "
+    DISKSTATS_FLUSHES,              //   ul_int        /proc/diskstats, 0 if < 20 fields
+    DISKSTATS_FLUSH_TIME,           //   ul_int         "
+
+    DISKSTATS_DELTA_DISCARDS,       //    s_int        derived from above
+    DISKSTATS_DELTA_DISCARDS_MERGED,//    s_int         "
+    DISKSTATS_DELTA_DISCARD_SECTORS,//    s_int         "
+    DISKSTATS_DELTA_DISCARD_TIME,   //    s_int         "
+    DISKSTATS_DELTA_FLUSHES,        //    s_int         "
+    DISKSTATS_DELTA_FLUSH_TIME,     //    s_int         "
+
+    DISKSTATS_STAMP_NSECS,          //  ull_int        CLOCK_MONOTONIC, when read
+    DISKSTATS_DELTA_NSECS,          //  ull_int        derived from above
+
+    DISKSTATS_RATE_READS,           //     real        derived, per second
+    DISKSTATS_RATE_READ_SECTORS,    //     real         "
+    DISKSTATS_RATE_WRITES,          //     real         "
+    DISKSTATS_RATE_WRITE_SECTORS,   //     real         "
+    DISKSTATS_RATE_DISCARDS,        //     real         "
+    DISKSTATS_RATE_DISCARD_SECTORS, //     real         "
+    DISKSTATS_RATE_FLUSHES,         //     real         "
+    DISKSTATS_UTILIZATION           //     real        derived, % of time busy
 };
 
 enum diskstats_sort_order {
@@ -71,9 +98,11 @@ enum diskstats_sort_order {
 struct diskstats_result {
     enum diskstats_item item;
     union {
-        signed int     s_int;
-        unsigned long  ul_int;
-        char          *str;
+        signed int          s_int;
+        unsigned long       ul_int;
+        unsigned long long  ull_int;
+        double              real;
+        char               *str;
     } result;
 };
 
@@ -0,0 +1,288 @@
+/*
+ * keyhash.c - perfect hashing for the keys of a 'key value' /proc file
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "procps-private.h"
+#include "keyhash.h"
+
+/*
+ * The keys of /proc/meminfo and /proc/vmstat are fixed when we're built,
+ * so we 'hash and displace' them once into a table with no collisions.
+ * Each key's 64 bit hash picks a bucket, and each bucket a displacement
+ * which (with the other half of that hash) gives every one of its keys a
+ * slot of its own.  Finding a key is then one hash and one compare.
+ *
+ * Better still, the kernel will present those keys in the same order on
+ * every read.  Once the key found on each line is remembered, that next
+ * read need only confirm the same key is there.
+ */
+
+#define KH_MAXDISP   0xffff            // largest displacement we'll try
+#define KH_MAXSLOTS  0x10000           // and largest table we'll try
+
+struct keyhash {
+    const struct keyhash_key *keys;
+    int numkeys;
+    int numbuckets;
+    unsigned mask;                     // table slots - 1, a power of 2
+    unsigned short *disps;             // for each bucket
+    unsigned short *slots;             // key index + 1, else 0
+    short *layout;                     // key index for each line, else -1
+    int numlines;
+    int maxlines;
+};
+
+
+static inline uint64_t keyhash_hash (
+        const char *str,
+        int len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (len--) {
+        h ^= (unsigned char)*str++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+} // end: keyhash_hash
+
+
+static inline unsigned keyhash_slot (
+        const struct keyhash *h,
+        uint64_t hash,
+        unsigned disp)
+{
+    return ((uint32_t)hash + disp * ((uint32_t)(hash >> 32) | 1)) & h->mask;
+} // end: keyhash_slot
+
+
+static int keyhash_place_failed (
+        struct keyhash *h,
+        const uint64_t *hashes,
+        const int *order,
+        const int *starts,
+        int biggest)
+{
+    unsigned tried[64];
+    int b, i, k, n;
+    unsigned d;
+
+    if (biggest > MAXTABLE(tried))
+        return 1;
+    memset(h->slots, 0, (h->mask + 1) * sizeof(unsigned short));
+
+    // the fullest buckets are hardest to place, so they go first
+    for (n = biggest; n > 0; n--) {
+        for (b = 0; b < h->numbuckets; b++) {
+            if (starts[b + 1] - starts[b] != n)
+                continue;
+            for (d = 0; d <= KH_MAXDISP; d++) {
+                for (i = 0; i < n; i++) {
+                    k = order[starts[b] + i];
+                    tried[i] = keyhash_slot(h, hashes[k], d);
+                    if (h->slots[tried[i]])
+                        break;
+                    // claimed for now, and released should it not all fit
+                    h->slots[tried[i]] = k + 1;
+                }
+                if (i == n)
+                    break;
+                while (i--)
+                    h->slots[tried[i]] = 0;
+            }
+            if (d > KH_MAXDISP)
+                return 1;
+            h->disps[b] = d;
+        }
+    }
+    return 0;
+} // end: keyhash_place_failed
+
+
+struct keyhash *keyhash_create (
+        const struct keyhash_key *keys,
+        int numkeys)
+{
+    struct keyhash *h;
+    uint64_t *hashes = NULL;
+    int *order = NULL, *starts = NULL;
+    unsigned nslots;
+    int b, i, biggest, failed = 1;
+
+    if (numkeys < 1 || numkeys >= KH_MAXSLOTS / 2) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(h = calloc(1, sizeof(struct keyhash))))
+        return NULL;
+    h->keys = keys;
+    h->numkeys = numkeys;
+    h->numbuckets = numkeys / 4 + 1;
+
+    if (!(hashes = malloc(numkeys * sizeof(uint64_t)))
+    || (!(order = malloc(numkeys * sizeof(int))))
+    || (!(starts = calloc(h->numbuckets + 1, sizeof(int))))
+    || (!(h->disps = calloc(h->numbuckets, sizeof(unsigned short)))))
+        goto end;
+
+    // group the key indexes by bucket, with starts[b] the first of each
+    for (i = 0; i < numkeys; i++) {
+        hashes[i] = keyhash_hash(keys[i].name, keys[i].len);
+        starts[hashes[i] % h->numbuckets + 1]++;
+    }
+    for (b = 0, biggest = 0; b < h->numbuckets; b++) {
+        if (starts[b + 1] > biggest)
+            biggest = starts[b + 1];
+        starts[b + 1] += starts[b];
+    }
+    for (i = numkeys - 1; i >= 0; i--)
+        order[--starts[hashes[i] % h->numbuckets + 1]] = i;
+    for (b = 0; b < h->numbuckets; b++)
+        starts[b] = starts[b + 1];
+    starts[b] = numkeys;
+
+    // start at about half full, then double until every bucket finds room
+    for (nslots = 2; nslots < (unsigned)numkeys * 2; nslots <<= 1)
+        ;
+    for ( ; nslots <= KH_MAXSLOTS; nslots <<= 1) {
+        free(h->slots);
+        if (!(h->slots = malloc(nslots * sizeof(unsigned short))))
+            goto end;
+        h->mask = nslots - 1;
+        if (!keyhash_place_failed(h, hashes, order, starts, biggest)) {
+            failed = 0;
+            break;
+        }
+    }
+    if (failed)
+        errno = EINVAL;
+end:
+    free(starts);
+    free(order);
+    free(hashes);
+    if (failed) {
+        keyhash_destroy(h);
+        return NULL;
+    }
+    return h;
+} // end: keyhash_create
+
+
+void keyhash_destroy (
+        struct keyhash *h)
+{
+    if (!h)
+        return;
+    free(h->layout);
+    free(h->slots);
+    free(h->disps);
+    free(h);
+} // end: keyhash_destroy
+
+
+int keyhash_find (
+        const struct keyhash *h,
+        const char *str,
+        int len)
+{
+    const struct keyhash_key *key;
+    uint64_t hash;
+    int k;
+
+    hash = keyhash_hash(str, len);
+    k = h->slots[keyhash_slot(h, hash, h->disps[hash % h->numbuckets])];
+    if (!k)
+        return -1;
+    key = &h->keys[--k];
+    if (key->len != len || memcmp(key->name, str, len))
+        return -1;
+    return k;
+} // end: keyhash_find
+
+
+static void keyhash_learn (
+        struct keyhash *h,
+        int line,
+        int k)
+{
+    short *p;
+    int n;
+
+    if (line >= h->maxlines) {
+        n = h->maxlines ? h->maxlines * 2 : 64;
+        if (n <= line || n > SHRT_MAX || !(p = realloc(h->layout, n * sizeof(short))))
+            return;
+        h->layout = p;
+        h->maxlines = n;
+    }
+    while (h->numlines < line)
+        h->layout[h->numlines++] = -1;
+    h->layout[line] = k;
+    if (h->numlines == line)
+        h->numlines++;
+} // end: keyhash_learn
+
+
+void keyhash_parse (
+        struct keyhash *h,
+        char *buf,
+        int size,
+        char delim,
+        void *data)
+{
+    const struct keyhash_key *key;
+    char *head, *tail, *end;
+    unsigned long value;
+    int line, k;
+
+    head = buf;
+    end = buf + size;
+
+    for (line = 0; head < end; line++) {
+        k = -1;
+        if (line < h->numlines && (k = h->layout[line]) >= 0) {
+            key = &h->keys[k];
+            if (end - head > key->len
+            && head[key->len] == delim
+            && !memcmp(head, key->name, key->len))
+                head += key->len + 1;
+            else
+                k = -1;
+        }
+        if (k < 0) {
+            if (!(tail = memchr(head, delim, end - head)))
+                break;
+            k = keyhash_find(h, head, tail - head);
+            keyhash_learn(h, line, k);
+            head = tail + 1;
+        }
+        if (k >= 0) {
+            value = strtoul(head, &tail, 10);
+            *(unsigned long *)((char *)data + h->keys[k].offset) = value;
+            head = tail;
+        }
+        if (!(tail = memchr(head, '\n', end - head)))
+            break;
+        head = tail + 1;
+    }
+} // end: keyhash_parse
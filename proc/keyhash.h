@@ -0,0 +1,48 @@
+/*
+ * keyhash.h - perfect hashing for the keys of a 'key value' /proc file
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PROCPS_PROC_KEYHASH_H
+#define PROCPS_PROC_KEYHASH_H
+
+#include <stddef.h>
+
+// One of the keys known to some file, with where its value is stored
+// (as an unsigned long) relative to the start of the caller's structure.
+struct keyhash_key {
+    const char *name;
+    unsigned short len;
+    unsigned short offset;
+};
+
+#define KEYHASH_KEY(k,s,f) { STRINGIFY(k), sizeof(STRINGIFY(k)) - 1, offsetof(s, f) }
+
+struct keyhash;
+
+// The keys table must outlive the hash, and the names in it be unique.
+struct keyhash *keyhash_create (const struct keyhash_key *keys, int numkeys);
+void keyhash_destroy (struct keyhash *h);
+
+// The index of that key exactly len bytes long at str, else -1.
+int keyhash_find (const struct keyhash *h, const char *str, int len);
+
+// Stores the values of those lines (of 'key<delim>value') in buf whose
+// key is known.  The order of keys is remembered from one call to the
+// next, so that when it's unchanged each line costs but a memcmp.
+void keyhash_parse (struct keyhash *h, char *buf, int size, char delim, void *data);
+
+#endif
@@ -21,7 +21,6 @@
 
 #include <errno.h>
 #include <fcntl.h>
-#include <search.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,7 +31,9 @@
 #include <sys/types.h>
 
 #include <proc/procps-private.h>
+#include <proc/keyhash.h>
 #include <proc/meminfo.h>
+#include <proc/record.h>
 
 
 #define MEMINFO_FILE  "/proc/meminfo"
@@ -133,7 +134,7 @@ struct meminfo_info {
     int numitems;
     enum meminfo_item *items;
     struct stacks_extent *extents;
-    struct hsearch_data hashtab;
+    struct keyhash *keys;
     struct meminfo_result get_this;
     time_t sav_secs;
 };
@@ -540,22 +541,10 @@ static inline int meminfo_items_check_failed (
 } // end: meminfo_items_check_failed
 
 
-static int meminfo_make_hash_failed (
-        struct meminfo_info *info)
-{
- #define htVAL(f) e.key = STRINGIFY(f); e.data = &info->hist.new. f; \
-  if (!hsearch_r(e, ENTER, &ep, &info->hashtab)) return 1;
- #define htXTRA(k,f) e.key = STRINGIFY(k); e.data = &info->hist.new. f; \
-  if (!hsearch_r(e, ENTER, &ep, &info->hashtab)) return 1;
-    ENTRY e, *ep;
-    size_t n;
-
-    // will also include those derived fields (more is better)
-    n = sizeof(struct meminfo_data) / sizeof(unsigned long);
-    // we'll follow the hsearch recommendation of an extra 25%
-    if (!hcreate_r(n + (n / 4), &info->hashtab))
-        return 1;
-
+// every key we know of (and more is better), in no particular order
+ #define htVAL(f) KEYHASH_KEY(f, struct meminfo_data, f),
+ #define htXTRA(k,f) KEYHASH_KEY(k, struct meminfo_data, f),
+static const struct keyhash_key meminfo_keys[] = {
     htVAL(Active)
     htXTRA(Active(anon), Active_anon)
     htXTRA(Active(file), Active_file)
@@ -616,11 +605,9 @@ static int meminfo_make_hash_failed (
     htVAL(VmallocUsed)
     htVAL(Writeback)
     htVAL(WritebackTmp)
-
-    return 0;
+};
  #undef htVAL
  #undef htXTRA
-} // end: meminfo_make_hash_failed
 
 
 /*
@@ -636,9 +623,7 @@ static int meminfo_read_failed (
     so we can focus the field names ... */
  #define mHr(f) info->hist.new. f
     char buf[MEMINFO_BUFF];
-    char *head, *tail;
     int size;
-    unsigned long *valptr;
     signed long mem_used;
 
     // remember history from last time around
@@ -646,9 +631,19 @@ static int meminfo_read_failed (
     // clear out the soon to be 'current' values
     memset(&info->hist.new, 0, sizeof(struct meminfo_data));
 
-    if (-1 == info->meminfo_fd
-    && (-1 == (info->meminfo_fd = open(MEMINFO_FILE, O_RDONLY))))
-        return 1;
+    if (replay_active()) {
+        if ((size = replay_read(MEMINFO_FILE, buf, sizeof(buf)-1)) < 0)
+            return 1;
+        goto have_size;
+    }
+
+    if (-1 == info->meminfo_fd) {
+        char path[PROCPS_ROOTMAX + 32];
+
+        procps_rootf(path, sizeof(path), MEMINFO_FILE);
+        if (-1 == (info->meminfo_fd = open(path, O_RDONLY)))
+            return 1;
+    }
 
     if (lseek(info->meminfo_fd, 0L, SEEK_SET) == -1)
         return 1;
@@ -661,34 +656,14 @@ static int meminfo_read_failed (
         }
         break;
     }
+have_size:
     if (size == 0) {
         errno = EIO;
         return 1;
     }
     buf[size] = '\0';
 
-    head = buf;
-
-    for (;;) {
-        static __thread ENTRY e;  // keep coverity off our backs (e.data)
-        ENTRY *ep;
-
-        if (!(tail = strchr(head, ':')))
-            break;
-        *tail = '\0';
-        valptr = NULL;
-
-        e.key = head;
-        if (hsearch_r(e, FIND, &ep, &info->hashtab))
-            valptr = ep->data;
-        head = tail + 1;
-        if (valptr)
-            *valptr = strtoul(head, NULL, 10);
-
-        if (!(tail = strchr(head, '\n')))
-            break;
-        head = tail + 1;
-    }
+    keyhash_parse(info->keys, buf, size, ':', &info->hist.new);
 
     if (0 == mHr(MemAvailable))
         mHr(MemAvailable) = mHr(MemFree);
@@ -818,7 +793,7 @@ PROCPS_EXPORT int procps_meminfo_new (
     p->refcount = 1;
     p->meminfo_fd = -1;
 
-    if (meminfo_make_hash_failed(p)) {
+    if (!(p->keys = keyhash_create(meminfo_keys, MAXTABLE(meminfo_keys)))) {
         free(p);
         return -errno;
     }
@@ -866,7 +841,7 @@ PROCPS_EXPORT int procps_meminfo_unref (
             meminfo_extents_free_all((*info));
         if ((*info)->items)
             free((*info)->items);
-        hdestroy_r(&(*info)->hashtab);
+        keyhash_destroy((*info)->keys);
 
         free(*info);
         *info = NULL;
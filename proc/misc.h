@@ -50,6 +50,10 @@ unsigned int procps_pid_length (void);
 
 int procps_linux_version(void);
 
+   // Where the proc and sys filesystems are found (see LIBPROC_ROOT)
+int procps_root_set (const char *dir);
+const char *procps_root_get (void);
+
 
 // //////////////////////////////////////////////////////////////////
 // Runtime Particulars //////////////////////////////////////////////
@@ -17,12 +17,16 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
 #include <proc/misc.h>
 #include "proc/procps-private.h"
+#include "proc/readproc.h"
 
 #define NSPATHLEN 64
 
@@ -37,6 +41,62 @@ static const char *ns_names[] = {
     [PROCPS_NS_UTS]    = "uts"
 };
 
+    // the above, as relative to some /proc/# directory
+static const char *ns_paths[] = {
+    [PROCPS_NS_CGROUP] = "ns/cgroup",
+    [PROCPS_NS_IPC]    = "ns/ipc",
+    [PROCPS_NS_MNT]    = "ns/mnt",
+    [PROCPS_NS_NET]    = "ns/net",
+    [PROCPS_NS_PID]    = "ns/pid",
+    [PROCPS_NS_TIME]   = "ns/time",
+    [PROCPS_NS_USER]   = "ns/user",
+    [PROCPS_NS_UTS]    = "ns/uts"
+};
+
+
+/*
+ * ns_read_at:
+ *
+ * Find those namespaces (a PROCPS_NS_xxx bit for each) wanted for
+ * the process whose /proc/# directory is open as dirfd.  Each link
+ * reads as "type:[inode]", sparing a stat of the namespace itself.
+ * Those not wanted, or not available, are set to zero.
+ *
+ * Returns: the number of namespaces found
+ */
+int ns_read_at (
+        int dirfd,
+        unsigned want,
+        struct procps_ns *nsp)
+{
+    char buf[NSPATHLEN], *p, *end;
+    struct stat st;
+    ssize_t len;
+    int i, found = 0;
+
+    for (i = 0; i < PROCPS_NS_COUNT; i++) {
+        nsp->ns[i] = 0;
+        if (!(want & (1u << i)))
+            continue;
+        if (0 < (len = readlinkat(dirfd, ns_paths[i], buf, sizeof(buf) - 1))) {
+            buf[len] = '\0';
+            if ((p = strchr(buf, '['))
+            && (nsp->ns[i] = strtoul(p + 1, &end, 10))
+            && *end == ']') {
+                found++;
+                continue;
+            }
+        }
+        // should the link's format ever change, the old way still works
+        if (0 == fstatat(dirfd, ns_paths[i], &st, 0)) {
+            nsp->ns[i] = (unsigned long)st.st_ino;
+            found++;
+        } else
+            nsp->ns[i] = 0;
+    }
+    return found;
+}
+
 
 /*
  * procps_ns_get_name:
@@ -93,21 +153,22 @@ PROCPS_EXPORT int procps_ns_read_pid(
         const int pid,
         struct procps_ns *nsp)
 {
-    char path[NSPATHLEN+1];
-    struct stat st;
-    int i;
+    char path[PROCPS_ROOTMAX + NSPATHLEN];
+    int fd, i;
 
     if (nsp == NULL)
         return -EINVAL;
     if (pid < 1)
         return -EINVAL;
 
-    for (i=0; i < PROCPS_NS_COUNT; i++) {
-        snprintf(path, NSPATHLEN, "/proc/%d/ns/%s", pid, ns_names[i]);
-        if (0 == stat(path, &st))
-            nsp->ns[i] = (unsigned long)st.st_ino;
-        else
+    // one path walk, rather than one for each of the namespaces
+    procps_rootf(path, sizeof(path), "/proc/%d", pid);
+    if (-1 == (fd = open(path, O_PATH | O_DIRECTORY | O_CLOEXEC))) {
+        for (i=0; i < PROCPS_NS_COUNT; i++)
             nsp->ns[i] = 0;
+        return 0;
     }
+    ns_read_at(fd, (1u << PROCPS_NS_COUNT) - 1, nsp);
+    close(fd);
     return 0;
 }
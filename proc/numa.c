@@ -18,11 +18,15 @@
  */
 
 #ifndef NUMA_DISABLE
+#include <dirent.h>
 #include <dlfcn.h>
 #endif
+#include <stdio.h>
 #include <stdlib.h>
 
+#include "misc.h"
 #include "numa.h"
+#include "procps-private.h"
 
 /*
  * We're structured so that if numa_init() is NOT called or that ./configure |
@@ -48,6 +52,37 @@ static int null_node_of_cpu (int n) { (void)n; return -1; }
  #ifdef PRETEND_NUMA
 static int fake_max_node (void) { return 3; }
 static int fake_node_of_cpu (int n) { return (1 == (n % 4)) ? 0 : (n % 4); }
+ #else
+/* ------------------------------------------------------------------------- +
+   with a root prefix (see procps_root_set), libnuma would still describe    |
+   this machine, so the sysfs beneath that root is then consulted directly.  |
+   the highest 'node#' under the node directory is the maximum node and the  |
+   'node#' link within a cpu's own directory is that cpu's node.             | */
+static int root_node_scan (const char *path) {
+    struct dirent *ent;
+    DIR *dir;
+    int n, max = -1;
+
+    if (!(dir = opendir(path)))
+        return -1;
+    while ((ent = readdir(dir)))
+        if (1 == sscanf(ent->d_name, "node%d", &n) && n > max)
+            max = n;
+    closedir(dir);
+    return max;
+}
+static int root_max_node (void) {
+    char path[PROCPS_ROOTMAX + 64];
+
+    procps_rootf(path, sizeof(path), "/sys/devices/system/node");
+    return root_node_scan(path);
+}
+static int root_node_of_cpu (int cpu) {
+    char path[PROCPS_ROOTMAX + 64];
+
+    procps_rootf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    return root_node_scan(path);
+}
  #endif
 #endif
 
@@ -67,6 +102,12 @@ void numa_init (void) {
 
 #ifndef NUMA_DISABLE
  #ifndef PRETEND_NUMA
+    if (procps_root_get()) {
+        numa_max_node = root_max_node;
+        numa_node_of_cpu = root_node_of_cpu;
+        initialized = 1;
+        return;
+    }
     // we'll try for the most recent version, then a version we know works...
     if ((libnuma_handle = dlopen("libnuma.so", RTLD_LAZY))
     || (libnuma_handle = dlopen("libnuma.so.1", RTLD_LAZY))) {
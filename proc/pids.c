@@ -26,19 +26,27 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include <proc/devname.h>
 #include <proc/misc.h>
 #include <proc/numa.h>
+#include <proc/pwcache.h>
 #include <proc/readproc.h>
+#include <proc/record.h>
+#include <proc/snapshot.h>
 #include <proc/wchan.h>
 
 #include <proc/procps-private.h>
@@ -52,6 +60,7 @@
 #define STACKS_GROW  128               // amount reap stack allocations grow
 #define NEWOLD_INIT  1024              // amount for initial hist allocation
 #define NEWOLD_GROW  128               // amt by which hist allocations grow
+#define SNAP_MAXAGE  3000              // LIBPROC_SNAPSHOT's default max age (msecs)
 
 /* ------------------------------------------------------------------------- +
    this provision can be used to ensure that our Item_table was synchronized |
@@ -76,6 +85,44 @@ struct fetch_support {
     struct pids_counts counts;         // actual counts pointed to by 'results'
 };
 
+struct columns_support {
+    int n_cols;                        // number of columns allocated
+    int n_alloc;                       // number of rows in each of the above
+    int active;                        // filled, row by row, during this reap
+    char *types;                       // each column's union member, as COL_xxx
+    struct pids_columns results;       // those columns for return to caller
+};
+
+struct sort_support {
+    void *buf;                         // scratch space for keys & pointers
+    size_t siz;                        // bytes allocated in the above
+};
+
+struct incr_support {
+    int enabled;                       // procps_pids_reap is incremental
+    struct pids_stack **anchor;        // prior reap's stacks, reused if unchanged
+    int n_alloc;                       // number of above pointers allocated
+    struct pids_stack *stack;          // current task's prior stack (or NULL)
+    char *reuse;                       // by item position, results to reuse
+};
+
+struct snap_support {
+    struct snapshot *pub;              // procps_pids_publish_snapshot's region
+    struct snapshot *sub;              // procps_pids_attach_snapshot's region
+    int maxage;                        // oldest snapshot to be used (msecs)
+    int hidden;                        // LIBPROC_HIDE_KERNEL, for the above
+    struct recording *rec;             // procps_pids_record's file
+    int live;                          // this reap is served by a snapshot
+    int replay;                        //  or, by LIBPROC_REPLAY instead
+};
+
+struct stats_support {
+    int enabled;                       // procps_pids_stats (or LIBPROC_STATS) used
+    struct pids_stats totals;          // since the last procps_pids_stats
+    struct readproc_tally tally;       // readproc's share of the above
+    FILE *log;                         // LIBPROC_STATS's file (if any)
+};
+
 struct pids_info {
     int refcount;
     int maxitems;                      // includes 'logical_end' delimiter
@@ -89,6 +136,9 @@ struct pids_info {
     proc_t*(*read_something)(PROCTAB*, proc_t*); // readproc/readeither via which
     unsigned pgs2k_shift;              // to convert some proc vaules
     unsigned oldflags;                 // the old library PROC_FILL flagss
+    unsigned statuskeys;               // those /proc/#/status lines we need
+    unsigned long long statfields;     // those /proc/#/stat fields we need
+    unsigned nsfields;                 // those /proc/#/ns/* links we need
     PROCTAB *fetch_PT;                 // oldlib interface for 'select' & 'reap'
     unsigned long hertz;               // for the 'TIME' & 'UTILIZATION' calculations
     unsigned long long boot_tics;      // for TIME_ELAPSED & 'UTILIZATION' calculations
@@ -98,6 +148,17 @@ struct pids_info {
     int seterr;                        // an ENOMEM encountered during assign
     proc_t get_proc;                   // the proc_t used by procps_pids_get
     proc_t fetch_proc;                 // the proc_t used by pids_stacks_fetch
+    struct fdcache *fdcache;           // fds retained between 'reap' cycles
+    int fdcache_max;                   // fd budget for the above (or zero)
+    int nscache;                       // the above also retains namespaces
+    struct pids_parallel *par;         // workers for procps_pids_reap_parallel
+    struct columns_support cols;       // support for procps_pids_reap_columns
+    struct sort_support sort;          // scratch for procps_pids_sort & _multi
+    struct incr_support incr;          // support for procps_pids_incremental
+    struct snap_support snap;          // support for those procps_pids_xxx_snapshot
+    struct stats_support stats;        // support for procps_pids_stats
+    struct strarena *arena;            // where a reap's strings are carved
+    struct strarena *strings;          // the above, but only while reaping
 };
 
 
@@ -105,12 +166,21 @@ struct pids_info {
 
 #define freNAME(t) free_pids_ ## t
 
-static void freNAME(str) (struct pids_result *R) {
-    if (R->result.str) free(R->result.str);
+    // strings carved from the arena are reclaimed en masse, not via free
+static void freNAME(str) (struct pids_info *I, struct pids_result *R) {
+    if (R->result.str && !strarena_owns(I->arena, R->result.str))
+        free(R->result.str);
+}
+
+    // (a vector's pointers share their strings' allocation, wherever that is,
+    //  and may well have been overwritten if they came from the arena)
+static void freNAME(strv) (struct pids_info *I, struct pids_result *R) {
+    if (R->result.strv && !strarena_owns(I->arena, R->result.strv) && *R->result.strv)
+        free(*R->result.strv);
 }
 
-static void freNAME(strv) (struct pids_result *R) {
-    if (R->result.strv && *R->result.strv) free(*R->result.strv);
+static inline char *pids_strdup (struct pids_info *I, const char *str) {
+    return I->strings ? strarena_strdup(I->strings, str) : strdup(str);
 }
 
 
@@ -125,22 +195,22 @@ static void freNAME(strv) (struct pids_result *R) {
     R->result. t = (long)(P-> x) << I -> pgs2k_shift; }
 /* strdup of a static char array */
 #define DUP_set(e,x) setDECL(e) { \
-    freNAME(str)(R); \
-    if (!(R->result.str = strdup(P-> x))) I->seterr = 1; }
+    freNAME(str)(I, R); \
+    if (!(R->result.str = pids_strdup(I, P-> x))) I->seterr = 1; }
 /* regular assignment copy */
 #define REG_set(e,t,x) setDECL(e) { \
     (void)I; R->result. t = P-> x; }
 /* take ownership of a normal single string if possible, else return
    some sort of hint that they duplicated this char * item ... */
 #define STR_set(e,x) setDECL(e) { \
-    freNAME(str)(R); \
+    freNAME(str)(I, R); \
     if (NULL != P-> x) { R->result.str = P-> x; P-> x = NULL; } \
-    else { R->result.str = strdup("[ duplicate " STRINGIFY(e) " ]"); \
+    else { R->result.str = pids_strdup(I, "[ duplicate " STRINGIFY(e) " ]"); \
       if (!R->result.str) I->seterr = 1; } }
 /* take ownership of true vectorized strings if possible, else return
    some sort of hint that they duplicated this char ** item ... */
 #define VEC_set(e,x) setDECL(e) { \
-    freNAME(strv)(R); \
+    freNAME(strv)(I, R); \
     if (NULL != P-> x) { R->result.strv = P-> x;  P-> x = NULL; } \
     else { R->result.strv = vectorize_this_str("[ duplicate " STRINGIFY(e) " ]"); \
       if (!R->result.strv) I->seterr = 1; } }
@@ -159,6 +229,7 @@ REG_set(AUTOGRP_NICE,     s_int,   autogrp_nice)
 STR_set(CGNAME,                    cgname)
 STR_set(CGROUP,                    cgroup)
 VEC_set(CGROUP_V,                  cgroup_v)
+setDECL(CHANGED)          { (void)P; R->result.s_int = !I->incr.stack; }
 STR_set(CMD,                       cmd)
 STR_set(CMDLINE,                   cmdline)
 VEC_set(CMDLINE_V,                 cmdline_v)
@@ -286,8 +357,8 @@ setDECL(TIME_ALL_C)     { R->result.real = ((double)P->utime + P->stime + P->cut
 setDECL(TIME_ELAPSED)   { double t = I->boot_tics - P->start_time; if (t > 0) R->result.real = t / I->hertz; }
 setDECL(TIME_START)     { R->result.real = (double)P->start_time / I->hertz; }
 REG_set(TTY,              s_int,   tty)
-setDECL(TTY_NAME)       { char buf[64]; freNAME(str)(R); dev_to_tty(buf, sizeof(buf), P->tty, P->tid, ABBREV_DEV); if (!(R->result.str = strdup(buf))) I->seterr = 1; }
-setDECL(TTY_NUMBER)     { char buf[64]; freNAME(str)(R); dev_to_tty(buf, sizeof(buf), P->tty, P->tid, ABBREV_DEV|ABBREV_TTY|ABBREV_PTS); if (!(R->result.str = strdup(buf))) I->seterr = 1; }
+setDECL(TTY_NAME)       { char buf[64]; freNAME(str)(I, R); dev_to_tty(buf, sizeof(buf), P->tty, P->tid, ABBREV_DEV); if (!(R->result.str = pids_strdup(I, buf))) I->seterr = 1; }
+setDECL(TTY_NUMBER)     { char buf[64]; freNAME(str)(I, R); dev_to_tty(buf, sizeof(buf), P->tty, P->tid, ABBREV_DEV|ABBREV_TTY|ABBREV_PTS); if (!(R->result.str = pids_strdup(I, buf))) I->seterr = 1; }
 setDECL(UTILIZATION)    { double t = I->boot_tics - P->start_time; if (t > 0) R->result.real = ((P->utime + P->stime) * 100.0f) / t; }
 setDECL(UTILIZATION_C)  { double t = I->boot_tics - P->start_time; if (t > 0) R->result.real = ((P->utime + P->stime + P->cutime + P->cstime) * 100.0f) / t; }
 REG_set(VM_DATA,          ul_int,  vm_data)
@@ -303,7 +374,7 @@ REG_set(VM_STACK,         ul_int,  vm_stack)
 REG_set(VM_SWAP,          ul_int,  vm_swap)
 setDECL(VM_USED)        { (void)I; R->result.ul_int = P->vm_swap + P->vm_rss; }
 REG_set(VSIZE_BYTES,      ul_int,  vsize)
-setDECL(WCHAN_NAME)     { freNAME(str)(R); if (!(R->result.str = strdup(lookup_wchan(P->tid)))) I->seterr = 1;; }
+setDECL(WCHAN_NAME)     { (void)I; R->result.str = (char *)P->wchan_name; }
 
 #undef setDECL
 #undef CVT_set
@@ -315,63 +386,200 @@ setDECL(WCHAN_NAME)     { freNAME(str)(R); if (!(R->result.str = strdup(lookup_w
 
 // ___ Sorting Support ||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-struct sort_parms {
-    int offset;
-    enum pids_sort_order order;
-};
+        /*
+         * Numeric items are sorted via an LSD radix sort on 64 bit keys
+         * extracted just once per stack, while strings get a merge sort.
+         * Both are stable, which is what allows successive sorts (or the
+         * keys in procps_pids_sort_multi) to act as one multi-key sort. */
+
+#define RADIX_MIN  64                  // fewer than this, insertion sort wins
+#define MERGE_RUN  16                  // merge sort's initial insertion runs
 
 #define srtNAME(t) sort_pids_ ## t
 #define srtDECL(t) static int srtNAME(t) \
-    (const struct pids_stack **A, const struct pids_stack **B, struct sort_parms *P)
-
-#define NUM_srt(T) srtDECL(T) { \
-    const struct pids_result *a = (*A)->head + P->offset; \
-    const struct pids_result *b = (*B)->head + P->offset; \
-    return P->order * (a->result. T - b->result. T); }
-
-#define REG_srt(T) srtDECL(T) { \
-    const struct pids_result *a = (*A)->head + P->offset; \
-    const struct pids_result *b = (*B)->head + P->offset; \
-    if ( a->result. T > b->result. T ) return P->order > 0 ?  1 : -1; \
-    if ( a->result. T < b->result. T ) return P->order > 0 ? -1 :  1; \
+    (struct sort_support *S, struct pids_stack **stacks, int n, int offset, enum pids_sort_order order)
+
+#define cmpNAME(t) cmp_pids_ ## t
+#define cmpDECL(t) static inline int cmpNAME(t) \
+    (const struct pids_stack *A, const struct pids_stack *B, int offset)
+
+
+static void *pids_sort_scratch (
+        struct sort_support *S,
+        size_t siz)
+{
+    void *p;
+
+    if (S->siz < siz) {
+        if (!(p = realloc(S->buf, siz)))
+            return NULL;
+        S->buf = p;
+        S->siz = siz;
+    }
+    return S->buf;
+} // end: pids_sort_scratch
+
+
+static void pids_radix_sort (
+        struct pids_stack **stacks,
+        uint64_t *key,
+        int n)
+{
+    unsigned cnt[8][256];
+    uint64_t *key2 = key + n, *kt;
+    struct pids_stack **ptr = stacks, **ptr2 = (struct pids_stack **)(key2 + n), **pt;
+    unsigned *c, sum, t;
+    int i, j, pass, shift;
+
+    if (n < RADIX_MIN) {
+        for (i = 1; i < n; i++) {
+            uint64_t k = key[i];
+            struct pids_stack *p = ptr[i];
+            for (j = i; j > 0 && key[j - 1] > k; j--) {
+                key[j] = key[j - 1];
+                ptr[j] = ptr[j - 1];
+            }
+            key[j] = k;
+            ptr[j] = p;
+        }
+        return;
+    }
+    memset(cnt, 0, sizeof(cnt));
+    for (i = 0; i < n; i++)
+        for (pass = 0; pass < 8; pass++)
+            cnt[pass][(key[i] >> (pass << 3)) & 0xff]++;
+
+    for (pass = 0; pass < 8; pass++) {
+        shift = pass << 3;
+        c = cnt[pass];
+        // when every key shares this byte, there's nothing to distribute
+        if (c[(key[0] >> shift) & 0xff] == (unsigned)n)
+            continue;
+        for (sum = 0, i = 0; i < 256; i++) {
+            t = c[i];
+            c[i] = sum;
+            sum += t;
+        }
+        for (i = 0; i < n; i++) {
+            j = c[(key[i] >> shift) & 0xff]++;
+            key2[j] = key[i];
+            ptr2[j] = ptr[i];
+        }
+        kt = key; key = key2; key2 = kt;
+        pt = ptr; ptr = ptr2; ptr2 = pt;
+    }
+    if (ptr != stacks)
+        memcpy(stacks, ptr, sizeof(void *) * n);
+} // end: pids_radix_sort
+
+
+    // floating point bits, rearranged so as to order just like integers
+static inline uint64_t pids_real_key (double d) {
+    uint64_t u;
+
+    memcpy(&u, &d, sizeof(u));
+    return (u >> 63) ? ~u : u | (1ULL << 63);
+}
+
+#define RDX_srt(T, KEY) srtDECL(T) { \
+    uint64_t *key, flip = (order > 0) ? 0 : ~0ULL; \
+    int i; \
+    if (!(key = pids_sort_scratch(S, n * (2 * sizeof(uint64_t) + sizeof(void *))))) \
+        return -1; \
+    for (i = 0; i < n; i++) { \
+        const struct pids_result *r = stacks[i]->head + offset; \
+        key[i] = (KEY) ^ flip; } \
+    pids_radix_sort(stacks, key, n); \
     return 0; }
 
-NUM_srt(s_ch)
-NUM_srt(s_int)
+#define SGN_key(T)  ((uint64_t)(int64_t)r->result. T ^ (1ULL << 63))
+#define UNS_key(T)  ((uint64_t)r->result. T)
+
+RDX_srt(s_ch,    SGN_key(s_ch))
+RDX_srt(s_int,   SGN_key(s_int))
+
+RDX_srt(u_int,   UNS_key(u_int))
+RDX_srt(ul_int,  UNS_key(ul_int))
+RDX_srt(ull_int, UNS_key(ull_int))
 
-REG_srt(u_int)
-REG_srt(ul_int)
-REG_srt(ull_int)
+RDX_srt(real,    pids_real_key(r->result.real))
 
-REG_srt(real)
 
-srtDECL(str) {
-    const struct pids_result *a = (*A)->head + P->offset;
-    const struct pids_result *b = (*B)->head + P->offset;
-    return P->order * strcoll(a->result.str, b->result.str);
+cmpDECL(str) {
+    return strcoll(A->head[offset].result.str, B->head[offset].result.str);
 }
 
-srtDECL(strv) {
-    const struct pids_result *a = (*A)->head + P->offset;
-    const struct pids_result *b = (*B)->head + P->offset;
-    if (!a->result.strv || !b->result.strv) return 0;
-    return P->order * strcoll((*a->result.strv), (*b->result.strv));
+cmpDECL(strv) {
+    char **a = A->head[offset].result.strv, **b = B->head[offset].result.strv;
+    if (!a || !b) return 0;
+    return strcoll(*a, *b);
 }
 
-srtDECL(strvers) {
-    const struct pids_result *a = (*A)->head + P->offset;
-    const struct pids_result *b = (*B)->head + P->offset;
-    return P->order * strverscmp(a->result.str, b->result.str);
+cmpDECL(strvers) {
+    return strverscmp(A->head[offset].result.str, B->head[offset].result.str);
 }
 
+    // with a constant 'cmp', each caller gets its very own copy of this guy
+static inline int pids_merge_sort (
+        struct sort_support *S,
+        struct pids_stack **stacks,
+        int n,
+        int offset,
+        enum pids_sort_order order,
+        int (*cmp)(const struct pids_stack *, const struct pids_stack *, int))
+{
+    struct pids_stack **src = stacks, **dst, **tmp, *p;
+    int i, j, k, o, w, mid, end;
+
+    if (!(dst = pids_sort_scratch(S, n * sizeof(void *))))
+        return -1;
+
+    for (i = 0; i < n; i += MERGE_RUN) {
+        end = (i + MERGE_RUN < n) ? i + MERGE_RUN : n;
+        for (j = i + 1; j < end; j++) {
+            p = src[j];
+            for (k = j; k > i && order * cmp(src[k - 1], p, offset) > 0; k--)
+                src[k] = src[k - 1];
+            src[k] = p;
+        }
+    }
+    for (w = MERGE_RUN; w < n; w <<= 1) {
+        for (i = 0; i < n; i += w << 1) {
+            mid = (i + w < n) ? i + w : n;
+            end = (i + (w << 1) < n) ? i + (w << 1) : n;
+            for (o = j = i, k = mid; o < end; o++) {
+                // taking from the left when equal is what keeps us stable
+                if (k >= end || (j < mid && order * cmp(src[j], src[k], offset) <= 0))
+                    dst[o] = src[j++];
+                else
+                    dst[o] = src[k++];
+            }
+        }
+        tmp = src; src = dst; dst = tmp;
+    }
+    if (src != stacks)
+        memcpy(stacks, src, sizeof(void *) * n);
+    return 0;
+} // end: pids_merge_sort
+
+#define MRG_srt(T) srtDECL(T) { \
+    return pids_merge_sort(S, stacks, n, offset, order, cmpNAME(T)); }
+
+MRG_srt(str)
+MRG_srt(strv)
+MRG_srt(strvers)
+
 srtDECL(noop) {
-    (void)A; (void)B; (void)P;
+    (void)S; (void)stacks; (void)n; (void)offset; (void)order;
     return 0;
 }
 
-#undef srtDECL
-#undef NUM_srt
-#undef REG_srt
+#undef cmpNAME
+#undef cmpDECL
+#undef RDX_srt
+#undef SGN_key
+#undef UNS_key
+#undef MRG_srt
 
 
 // ___ Controlling Table ||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -390,6 +598,7 @@ srtDECL(noop) {
 #define f_status   PROC_FILLSTATUS
 #define f_systemd  PROC_FILLSYSTEMD
 #define f_usr      PROC_FILLUSR
+#define f_wchan    PROC_FILLWCHAN
    // these next three will yield true verctorized strings
 #define v_arg      PROC_FILLARG
 #define v_cgroup   PROC_FILLCGROUP
@@ -404,10 +613,70 @@ srtDECL(noop) {
 #define x_supgrp   PROC_FILL_SUPGRP
    // placed here so an 'f' prefix wouldn't make 'em first
 #define z_autogrp  PROC_FILLAUTOGRP
+   // those /proc/#/status lines needed when f_status (or f_either) applies
+#define k_groups   PROC_STATUS_Groups
+#define k_gid      PROC_STATUS_Gid
+#define k_ids      PROC_STATUS_IDS
+#define k_name     PROC_STATUS_Name
+#define k_ppid     PROC_STATUS_PPid
+#define k_sigs     PROC_STATUS_SIGS
+#define k_state    PROC_STATUS_State
+#define k_uid      PROC_STATUS_Uid
+#define k_anon     PROC_STATUS_RssAnon
+#define k_data     PROC_STATUS_VmData
+#define k_exe      PROC_STATUS_VmExe
+#define k_file     PROC_STATUS_RssFile
+#define k_lck      PROC_STATUS_VmLck
+#define k_lib      PROC_STATUS_VmLib
+#define k_rss      PROC_STATUS_VmRSS
+#define k_shmem    PROC_STATUS_RssShmem
+#define k_size     PROC_STATUS_VmSize
+#define k_stk      PROC_STATUS_VmStk
+#define k_swap     PROC_STATUS_VmSwap
+#define k_used   ( PROC_STATUS_VmRSS | PROC_STATUS_VmSwap )
+   // those /proc/#/stat fields needed when f_stat (or f_either) applies
+#define t_blkio    PROC_STAT_blkio_tics
+#define t_cpu      PROC_STAT_processor
+#define t_ecode    PROC_STAT_end_code
+#define t_eip      PROC_STAT_kstk_eip
+#define t_esp      PROC_STAT_kstk_esp
+#define t_exit     PROC_STAT_exit_signal
+#define t_flags    PROC_STAT_flags
+#define t_guest    PROC_STAT_gtime
+#define t_guestc ( PROC_STAT_gtime | PROC_STAT_cgtime )
+#define t_maj      PROC_STAT_maj_flt
+#define t_majc   ( PROC_STAT_maj_flt | PROC_STAT_cmaj_flt )
+#define t_min      PROC_STAT_min_flt
+#define t_minc   ( PROC_STAT_min_flt | PROC_STAT_cmin_flt )
+#define t_nice     PROC_STAT_nice
+#define t_nlwp     PROC_STAT_nlwp
+#define t_pgrp     PROC_STAT_pgrp
+#define t_ppid     PROC_STAT_ppid
+#define t_prio     PROC_STAT_priority
+#define t_rlim     PROC_STAT_rss_rlim
+#define t_rss      PROC_STAT_rss
+#define t_rtprio   PROC_STAT_rtprio
+#define t_sched    PROC_STAT_sched
+#define t_scode    PROC_STAT_start_code
+#define t_sess     PROC_STAT_session
+#define t_stack    PROC_STAT_start_stack
+#define t_start    PROC_STAT_start_time
+#define t_state    PROC_STAT_state
+#define t_stime    PROC_STAT_stime
+#define t_stimec ( PROC_STAT_stime | PROC_STAT_cstime )
+#define t_tics   ( PROC_STAT_utime | PROC_STAT_stime )
+#define t_ticsc  ( t_tics | PROC_STAT_cutime | PROC_STAT_cstime )
+#define t_tpgid    PROC_STAT_tpgid
+#define t_tty      PROC_STAT_tty
+#define t_util   ( t_tics | t_start )
+#define t_utilc  ( t_ticsc | t_start )
+#define t_utime    PROC_STAT_utime
+#define t_utimec ( PROC_STAT_utime | PROC_STAT_cutime )
+#define t_vsize    PROC_STAT_vsize
 
 typedef void (*SET_t)(struct pids_info *, struct pids_result *, proc_t *);
-typedef void (*FRE_t)(struct pids_result *);
-typedef int  (*QSR_t)(const void *, const void *, void *);
+typedef void (*FRE_t)(struct pids_info *, struct pids_result *);
+typedef int  (*SRT_t)(struct sort_support *, struct pids_stack **, int, int, enum pids_sort_order);
 
 #ifdef ITEMTABLE_DEBUG
 #define RS(e) (SET_t)setNAME(e), PIDS_ ## e, STRINGIFY(PIDS_ ## e)
@@ -415,7 +684,7 @@ typedef int  (*QSR_t)(const void *, const void *, void *);
 #define RS(e) (SET_t)setNAME(e)
 #endif
 #define FF(t) (FRE_t)freNAME(t)
-#define QS(t) (QSR_t)srtNAME(t)
+#define QS(t) (SRT_t)srtNAME(t)
 #define TS(t) STRINGIFY(t)
 #define TS_noop ""
 
@@ -430,171 +699,174 @@ static struct {
     char    *enum2str;            // enumerator name as a char* string
 #endif
     unsigned oldflags;            // PROC_FILLxxxx flags for this item
+    unsigned statkeys;            // PROC_STATUS_xxx lines for this item
+    unsigned long long statflds;  // PROC_STAT_xxx fields for this item
     FRE_t    freefunc;            // free function for strings storage
-    QSR_t    sortfunc;            // sort cmp func for a specific type
+    SRT_t    sortfunc;            // sort func for a specific type
     int      needhist;            // a result requires history support
     char    *type2str;            // the result type as a string value
 } Item_table[] = {
-/*    setsfunc               oldflags    freefunc   sortfunc       needhist  type2str
-      ---------------------  ----------  ---------  -------------  --------  ----------- */
-    { RS(noop),              0,          NULL,      QS(noop),      0,        TS_noop     }, // user only, never altered
-    { RS(extra),             0,          NULL,      QS(ull_int),   0,        TS_noop     }, // user only, reset to zero
-
-    { RS(ADDR_CODE_END),     f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(ADDR_CODE_START),   f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(ADDR_CURR_EIP),     f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(ADDR_CURR_ESP),     f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(ADDR_STACK_START),  f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(AUTOGRP_ID),        z_autogrp,  NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(AUTOGRP_NICE),      z_autogrp,  NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(CGNAME),            x_cgroup,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(CGROUP),            x_cgroup,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(CGROUP_V),          v_cgroup,   FF(strv),  QS(strv),      0,        TS(strv)    },
-    { RS(CMD),               f_either,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(CMDLINE),           x_cmdline,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(CMDLINE_V),         v_arg,      FF(strv),  QS(strv),      0,        TS(strv)    },
-    { RS(ENVIRON),           x_environ,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(ENVIRON_V),         v_env,      FF(strv),  QS(strv),      0,        TS(strv)    },
-    { RS(EXE),               f_exe,      FF(str),   QS(str),       0,        TS(str)     },
-    { RS(EXIT_SIGNAL),       f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(FLAGS),             f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(FLT_MAJ),           f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(FLT_MAJ_C),         f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(FLT_MAJ_DELTA),     f_stat,     NULL,      QS(s_int),     +1,       TS(s_int)   },
-    { RS(FLT_MIN),           f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(FLT_MIN_C),         f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(FLT_MIN_DELTA),     f_stat,     NULL,      QS(s_int),     +1,       TS(s_int)   },
-    { RS(ID_EGID),           0,          NULL,      QS(u_int),     0,        TS(u_int)   }, // oldflags: free w/ simple_read
-    { RS(ID_EGROUP),         f_grp,      NULL,      QS(str),       0,        TS(str)     },
-    { RS(ID_EUID),           0,          NULL,      QS(u_int),     0,        TS(u_int)   }, // oldflags: free w/ simple_read
-    { RS(ID_EUSER),          f_usr,      NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
-    { RS(ID_FGID),           f_status,   NULL,      QS(u_int),     0,        TS(u_int)   },
-    { RS(ID_FGROUP),         x_ogroup,   NULL,      QS(str),       0,        TS(str)     },
-    { RS(ID_FUID),           f_status,   NULL,      QS(u_int),     0,        TS(u_int)   },
-    { RS(ID_FUSER),          x_ouser,    NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
-    { RS(ID_LOGIN),          f_login,    NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(ID_PGRP),           f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(ID_PID),            0,          NULL,      QS(s_int),     0,        TS(s_int)   }, // oldflags: free w/ simple_nextpid
-    { RS(ID_PPID),           f_either,   NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(ID_RGID),           f_status,   NULL,      QS(u_int),     0,        TS(u_int)   },
-    { RS(ID_RGROUP),         x_ogroup,   NULL,      QS(str),       0,        TS(str)     },
-    { RS(ID_RUID),           f_status,   NULL,      QS(u_int),     0,        TS(u_int)   },
-    { RS(ID_RUSER),          x_ouser,    NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
-    { RS(ID_SESSION),        f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(ID_SGID),           f_status,   NULL,      QS(u_int),     0,        TS(u_int)   },
-    { RS(ID_SGROUP),         x_ogroup,   NULL,      QS(str),       0,        TS(str)     },
-    { RS(ID_SUID),           f_status,   NULL,      QS(u_int),     0,        TS(u_int)   },
-    { RS(ID_SUSER),          x_ouser,    NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
-    { RS(ID_TGID),           0,          NULL,      QS(s_int),     0,        TS(s_int)   }, // oldflags: free w/ simple_nextpid
-    { RS(ID_TID),            0,          NULL,      QS(s_int),     0,        TS(s_int)   }, // oldflags: free w/ simple_nexttid
-    { RS(ID_TPGID),          f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(IO_READ_BYTES),     f_io,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(IO_READ_CHARS),     f_io,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(IO_READ_OPS),       f_io,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(IO_WRITE_BYTES),    f_io,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(IO_WRITE_CBYTES),   f_io,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(IO_WRITE_CHARS),    f_io,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(IO_WRITE_OPS),      f_io,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(LXCNAME),           f_lxc,      NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
-    { RS(MEM_CODE),          f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_CODE_PGS),      f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_DATA),          f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_DATA_PGS),      f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_RES),           f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_RES_PGS),       f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_SHR),           f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_SHR_PGS),       f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_VIRT),          f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(MEM_VIRT_PGS),      f_statm,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NICE),              f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(NLWP),              f_either,   NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(NS_CGROUP),         f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NS_IPC),            f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NS_MNT),            f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NS_NET),            f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NS_PID),            f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NS_TIME),           f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NS_USER),           f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(NS_UTS),            f_ns,       NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(OOM_ADJ),           f_oom,      NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(OOM_SCORE),         f_oom,      NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(PRIORITY),          f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(PRIORITY_RT),       f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(PROCESSOR),         f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(PROCESSOR_NODE),    f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(RSS),               f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(RSS_RLIM),          f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SCHED_CLASS),       f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(SD_MACH),           f_systemd,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SD_OUID),           f_systemd,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SD_SEAT),           f_systemd,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SD_SESS),           f_systemd,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SD_SLICE),          f_systemd,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SD_UNIT),           f_systemd,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SD_UUNIT),          f_systemd,  FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SIGBLOCKED),        f_status,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SIGCATCH),          f_status,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SIGIGNORE),         f_status,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SIGNALS),           f_status,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SIGPENDING),        f_status,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SMAP_ANONYMOUS),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_HUGE_ANON),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_HUGE_FILE),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_HUGE_SHMEM),   f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_HUGE_TLBPRV),  f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_HUGE_TLBSHR),  f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_LAZY_FREE),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_LOCKED),       f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_PRV_CLEAN),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_PRV_DIRTY),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_PRV_TOTAL),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_PSS),          f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_PSS_ANON),     f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_PSS_FILE),     f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_PSS_SHMEM),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_REFERENCED),   f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_RSS),          f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_SHR_CLEAN),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_SHR_DIRTY),    f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_SWAP),         f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(SMAP_SWAP_PSS),     f_smaps,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(STATE),             f_either,   NULL,      QS(s_ch),      0,        TS(s_ch)    },
-    { RS(SUPGIDS),           f_status,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(SUPGROUPS),         x_supgrp,   FF(str),   QS(str),       0,        TS(str)     },
-    { RS(TICS_ALL),          f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_ALL_C),        f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_ALL_DELTA),    f_stat,     NULL,      QS(u_int),     +1,       TS(u_int)   },
-    { RS(TICS_BEGAN),        f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_BLKIO),        f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_GUEST),        f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_GUEST_C),      f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_SYSTEM),       f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_SYSTEM_C),     f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_USER),         f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TICS_USER_C),       f_stat,     NULL,      QS(ull_int),   0,        TS(ull_int) },
-    { RS(TIME_ALL),          f_stat,     NULL,      QS(real),      0,        TS(real)    },
-    { RS(TIME_ALL_C),        f_stat,     NULL,      QS(real),      0,        TS(real)    },
-    { RS(TIME_ELAPSED),      f_stat,     NULL,      QS(real),      0,        TS(real)    },
-    { RS(TIME_START),        f_stat,     NULL,      QS(real),      0,        TS(real)    },
-    { RS(TTY),               f_stat,     NULL,      QS(s_int),     0,        TS(s_int)   },
-    { RS(TTY_NAME),          f_stat,     FF(str),   QS(strvers),   0,        TS(str)     },
-    { RS(TTY_NUMBER),        f_stat,     FF(str),   QS(strvers),   0,        TS(str)     },
-    { RS(UTILIZATION),       f_stat,     NULL,      QS(real),      0,        TS(real)    },
-    { RS(UTILIZATION_C),     f_stat,     NULL,      QS(real),      0,        TS(real)    },
-    { RS(VM_DATA),           f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_EXE),            f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_LIB),            f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_RSS),            f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_RSS_ANON),       f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_RSS_FILE),       f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_RSS_LOCKED),     f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_RSS_SHARED),     f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_SIZE),           f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_STACK),          f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_SWAP),           f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VM_USED),           f_status,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(VSIZE_BYTES),       f_stat,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
-    { RS(WCHAN_NAME),        0,          FF(str),   QS(str),       0,        TS(str)     }, // oldflags: tid already free
+/*    setsfunc               oldflags    statkeys   statflds   freefunc   sortfunc       needhist  type2str
+      ---------------------  ----------  ---------  ---------  ---------  -------------  --------  ----------- */
+    { RS(noop),              0,          0,         0,         NULL,      QS(noop),      0,        TS_noop     }, // user only, never altered
+    { RS(extra),             0,          0,         0,         NULL,      QS(ull_int),   0,        TS_noop     }, // user only, reset to zero
+
+    { RS(ADDR_CODE_END),     f_stat,     0,         t_ecode,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(ADDR_CODE_START),   f_stat,     0,         t_scode,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(ADDR_CURR_EIP),     f_stat,     0,         t_eip,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(ADDR_CURR_ESP),     f_stat,     0,         t_esp,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(ADDR_STACK_START),  f_stat,     0,         t_stack,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(AUTOGRP_ID),        z_autogrp,  0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(AUTOGRP_NICE),      z_autogrp,  0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(CGNAME),            x_cgroup,   0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(CGROUP),            x_cgroup,   0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(CGROUP_V),          v_cgroup,   0,         0,         FF(strv),  QS(strv),      0,        TS(strv)    },
+    { RS(CMD),               f_either,   k_name,    0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(CMDLINE),           x_cmdline,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(CMDLINE_V),         v_arg,      0,         0,         FF(strv),  QS(strv),      0,        TS(strv)    },
+    { RS(ENVIRON),           x_environ,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(ENVIRON_V),         v_env,      0,         0,         FF(strv),  QS(strv),      0,        TS(strv)    },
+    { RS(EXE),               f_exe,      0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(EXIT_SIGNAL),       f_stat,     0,         t_exit,    NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(FLAGS),             f_stat,     0,         t_flags,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(FLT_MAJ),           f_stat,     0,         t_maj,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(FLT_MAJ_C),         f_stat,     0,         t_majc,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(FLT_MAJ_DELTA),     f_stat,     0,         t_maj,     NULL,      QS(s_int),     +1,       TS(s_int)   },
+    { RS(FLT_MIN),           f_stat,     0,         t_min,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(FLT_MIN_C),         f_stat,     0,         t_minc,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(FLT_MIN_DELTA),     f_stat,     0,         t_min,     NULL,      QS(s_int),     +1,       TS(s_int)   },
+    { RS(ID_EGID),           0,          0,         0,         NULL,      QS(u_int),     0,        TS(u_int)   }, // oldflags: free w/ simple_read
+    { RS(ID_EGROUP),         f_grp,      0,         0,         NULL,      QS(str),       0,        TS(str)     },
+    { RS(ID_EUID),           0,          0,         0,         NULL,      QS(u_int),     0,        TS(u_int)   }, // oldflags: free w/ simple_read
+    { RS(ID_EUSER),          f_usr,      0,         0,         NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
+    { RS(ID_FGID),           f_status,   k_gid,     0,         NULL,      QS(u_int),     0,        TS(u_int)   },
+    { RS(ID_FGROUP),         x_ogroup,   k_gid,     0,         NULL,      QS(str),       0,        TS(str)     },
+    { RS(ID_FUID),           f_status,   k_uid,     0,         NULL,      QS(u_int),     0,        TS(u_int)   },
+    { RS(ID_FUSER),          x_ouser,    k_uid,     0,         NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
+    { RS(ID_LOGIN),          f_login,    0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(ID_PGRP),           f_stat,     0,         t_pgrp,    NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(ID_PID),            0,          0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   }, // oldflags: free w/ simple_nextpid
+    { RS(ID_PPID),           f_either,   k_ppid,    t_ppid,    NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(ID_RGID),           f_status,   k_gid,     0,         NULL,      QS(u_int),     0,        TS(u_int)   },
+    { RS(ID_RGROUP),         x_ogroup,   k_gid,     0,         NULL,      QS(str),       0,        TS(str)     },
+    { RS(ID_RUID),           f_status,   k_uid,     0,         NULL,      QS(u_int),     0,        TS(u_int)   },
+    { RS(ID_RUSER),          x_ouser,    k_uid,     0,         NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
+    { RS(ID_SESSION),        f_stat,     0,         t_sess,    NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(ID_SGID),           f_status,   k_gid,     0,         NULL,      QS(u_int),     0,        TS(u_int)   },
+    { RS(ID_SGROUP),         x_ogroup,   k_gid,     0,         NULL,      QS(str),       0,        TS(str)     },
+    { RS(ID_SUID),           f_status,   k_uid,     0,         NULL,      QS(u_int),     0,        TS(u_int)   },
+    { RS(ID_SUSER),          x_ouser,    k_uid,     0,         NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
+    { RS(ID_TGID),           0,          0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   }, // oldflags: free w/ simple_nextpid
+    { RS(ID_TID),            0,          0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   }, // oldflags: free w/ simple_nexttid
+    { RS(ID_TPGID),          f_stat,     0,         t_tpgid,   NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(IO_READ_BYTES),     f_io,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(IO_READ_CHARS),     f_io,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(IO_READ_OPS),       f_io,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(IO_WRITE_BYTES),    f_io,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(IO_WRITE_CBYTES),   f_io,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(IO_WRITE_CHARS),    f_io,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(IO_WRITE_OPS),      f_io,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(LXCNAME),           f_lxc,      0,         0,         NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ cached string
+    { RS(MEM_CODE),          f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_CODE_PGS),      f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_DATA),          f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_DATA_PGS),      f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_RES),           f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_RES_PGS),       f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_SHR),           f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_SHR_PGS),       f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_VIRT),          f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(MEM_VIRT_PGS),      f_statm,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NICE),              f_stat,     0,         t_nice,    NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(NLWP),              f_either,   k_ids,     t_nlwp,    NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(NS_CGROUP),         f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NS_IPC),            f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NS_MNT),            f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NS_NET),            f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NS_PID),            f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NS_TIME),           f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NS_USER),           f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(NS_UTS),            f_ns,       0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(OOM_ADJ),           f_oom,      0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(OOM_SCORE),         f_oom,      0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(PRIORITY),          f_stat,     0,         t_prio,    NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(PRIORITY_RT),       f_stat,     0,         t_rtprio,  NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(PROCESSOR),         f_stat,     0,         t_cpu,     NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(PROCESSOR_NODE),    f_stat,     0,         t_cpu,     NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(RSS),               f_stat,     0,         t_rss,     NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(RSS_RLIM),          f_stat,     0,         t_rlim,    NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SCHED_CLASS),       f_stat,     0,         t_sched,   NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(SD_MACH),           f_systemd,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SD_OUID),           f_systemd,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SD_SEAT),           f_systemd,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SD_SESS),           f_systemd,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SD_SLICE),          f_systemd,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SD_UNIT),           f_systemd,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SD_UUNIT),          f_systemd,  0,         0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SIGBLOCKED),        f_status,   k_sigs,    0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SIGCATCH),          f_status,   k_sigs,    0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SIGIGNORE),         f_status,   k_sigs,    0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SIGNALS),           f_status,   k_sigs,    0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SIGPENDING),        f_status,   k_sigs,    0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SMAP_ANONYMOUS),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_HUGE_ANON),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_HUGE_FILE),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_HUGE_SHMEM),   f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_HUGE_TLBPRV),  f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_HUGE_TLBSHR),  f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_LAZY_FREE),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_LOCKED),       f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_PRV_CLEAN),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_PRV_DIRTY),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_PRV_TOTAL),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_PSS),          f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_PSS_ANON),     f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_PSS_FILE),     f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_PSS_SHMEM),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_REFERENCED),   f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_RSS),          f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_SHR_CLEAN),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_SHR_DIRTY),    f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_SWAP),         f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(SMAP_SWAP_PSS),     f_smaps,    0,         0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(STATE),             f_either,   k_state,   t_state,   NULL,      QS(s_ch),      0,        TS(s_ch)    },
+    { RS(SUPGIDS),           f_status,   k_groups,  0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(SUPGROUPS),         x_supgrp,   k_groups,  0,         FF(str),   QS(str),       0,        TS(str)     },
+    { RS(TICS_ALL),          f_stat,     0,         t_tics,    NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_ALL_C),        f_stat,     0,         t_ticsc,   NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_ALL_DELTA),    f_stat,     0,         t_tics,    NULL,      QS(u_int),     +1,       TS(u_int)   },
+    { RS(TICS_BEGAN),        f_stat,     0,         t_start,   NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_BLKIO),        f_stat,     0,         t_blkio,   NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_GUEST),        f_stat,     0,         t_guest,   NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_GUEST_C),      f_stat,     0,         t_guestc,  NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_SYSTEM),       f_stat,     0,         t_stime,   NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_SYSTEM_C),     f_stat,     0,         t_stimec,  NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_USER),         f_stat,     0,         t_utime,   NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TICS_USER_C),       f_stat,     0,         t_utimec,  NULL,      QS(ull_int),   0,        TS(ull_int) },
+    { RS(TIME_ALL),          f_stat,     0,         t_tics,    NULL,      QS(real),      0,        TS(real)    },
+    { RS(TIME_ALL_C),        f_stat,     0,         t_ticsc,   NULL,      QS(real),      0,        TS(real)    },
+    { RS(TIME_ELAPSED),      f_stat,     0,         t_start,   NULL,      QS(real),      0,        TS(real)    },
+    { RS(TIME_START),        f_stat,     0,         t_start,   NULL,      QS(real),      0,        TS(real)    },
+    { RS(TTY),               f_stat,     0,         t_tty,     NULL,      QS(s_int),     0,        TS(s_int)   },
+    { RS(TTY_NAME),          f_stat,     0,         t_tty,     FF(str),   QS(strvers),   0,        TS(str)     },
+    { RS(TTY_NUMBER),        f_stat,     0,         t_tty,     FF(str),   QS(strvers),   0,        TS(str)     },
+    { RS(UTILIZATION),       f_stat,     0,         t_util,    NULL,      QS(real),      0,        TS(real)    },
+    { RS(UTILIZATION_C),     f_stat,     0,         t_utilc,   NULL,      QS(real),      0,        TS(real)    },
+    { RS(VM_DATA),           f_status,   k_data,    0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_EXE),            f_status,   k_exe,     0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_LIB),            f_status,   k_lib,     0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_RSS),            f_status,   k_rss,     0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_RSS_ANON),       f_status,   k_anon,    0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_RSS_FILE),       f_status,   k_file,    0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_RSS_LOCKED),     f_status,   k_lck,     0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_RSS_SHARED),     f_status,   k_shmem,   0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_SIZE),           f_status,   k_size,    0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_STACK),          f_status,   k_stk,     0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_SWAP),           f_status,   k_swap,    0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VM_USED),           f_status,   k_used,    0,         NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(VSIZE_BYTES),       f_stat,     0,         t_vsize,   NULL,      QS(ul_int),    0,        TS(ul_int)  },
+    { RS(WCHAN_NAME),        f_wchan,    0,         0,         NULL,      QS(str),       0,        TS(str)     }, // freefunc NULL w/ shared string
+    { RS(CHANGED),           0,          0,         0,         NULL,      QS(s_int),     0,        TS(s_int)   }, // oldflags: free w/ incremental reap
 };
 
     /* please note,
@@ -622,6 +894,7 @@ enum pids_item PIDS_logical_end = MAXTABLE(Item_table);
 //#undef f_status                 // needed later
 #undef f_systemd
 #undef f_usr
+#undef f_wchan
 #undef v_arg
 #undef v_cgroup
 #undef v_env
@@ -632,13 +905,71 @@ enum pids_item PIDS_logical_end = MAXTABLE(Item_table);
 #undef x_ouser
 #undef x_supgrp
 #undef z_autogrp
+#undef k_groups
+#undef k_gid
+#undef k_ids
+#undef k_name
+#undef k_ppid
+#undef k_sigs
+#undef k_state
+#undef k_uid
+#undef k_anon
+#undef k_data
+#undef k_exe
+#undef k_file
+#undef k_lck
+#undef k_lib
+#undef k_rss
+#undef k_shmem
+#undef k_size
+#undef k_stk
+#undef k_swap
+#undef k_used
+#undef t_blkio
+#undef t_cpu
+#undef t_ecode
+#undef t_eip
+#undef t_esp
+#undef t_exit
+#undef t_flags
+#undef t_guest
+#undef t_guestc
+#undef t_maj
+#undef t_majc
+#undef t_min
+#undef t_minc
+#undef t_nice
+#undef t_nlwp
+#undef t_pgrp
+#undef t_ppid
+#undef t_prio
+#undef t_rlim
+#undef t_rss
+#undef t_rtprio
+#undef t_sched
+#undef t_scode
+#undef t_sess
+#undef t_stack
+#undef t_start
+#undef t_state
+#undef t_stime
+#undef t_stimec
+#undef t_tics
+#undef t_ticsc
+#undef t_tpgid
+#undef t_tty
+#undef t_util
+#undef t_utilc
+#undef t_utime
+#undef t_utimec
+#undef t_vsize
 
 
 // ___ History Support Private Functions ||||||||||||||||||||||||||||||||||||||
 //   ( stolen from top when he wasn't looking ) -------------------------------
 
-#define HHASH_SIZE  4096
-#define _HASH_PID_(K) (K & (HHASH_SIZE - 1))
+#define HHASH_INIT  8192               // initial hash slots (a power of 2)
+#define _HASH_PID_(K,M) (((unsigned)(K) * 0x9E3779B1u) >> 7 & (M))
 
 #define Hr(x)  info->hist->x           // 'hist ref', minimize stolen impact
 
@@ -648,86 +979,197 @@ typedef struct HST_t {
     TIC_t tics;                        // last frame's tics count
     unsigned long maj, min;            // last frame's maj/min_flt counts
     int pid;                           // record 'key'
-    int lnk;                           // next on hash chain
+    TIC_t began;                       // last frame's start_time (pid reuse)
+    unsigned long rss, vsize;          // last frame's rss & vsize
+    char state;                        // last frame's state
+    struct pids_stack *stack;          // last frame's stack (incremental only)
 } HST_t;
 
 
+        /*
+         * The hash tables are open addressed, with Robin Hood insertion
+         * keeping probe sequences short even when pid_max is huge.  Any
+         * slot is occupied only if its epoch matches that of its table,
+         * so a whole table can be emptied by just bumping that epoch. */
+typedef struct HSL_t {
+    int pid;                           // record 'key'
+    int idx;                           // that record's index in PHist_xxx
+    unsigned epoch;                    // slot valid when equal table's epoch
+} HSL_t;
+
+struct history_hash {
+    HSL_t   *slots;                    // the actual hash table
+    unsigned mask;                     // number of slots - 1
+    unsigned epoch;                    // current generation of valid slots
+    int      count;                    // slots occupied this generation
+};
+
+
 struct history_info {
     int    num_tasks;                  // used as index (tasks tallied)
     int    HHist_siz;                  // max number of HST_t structs
     HST_t *PHist_sav;                  // alternating 'old/new' HST_t anchors
     HST_t *PHist_new;
-    int    HHash_one [HHASH_SIZE];     // the actual hash tables
-    int    HHash_two [HHASH_SIZE];     // (accessed via PHash_sav/PHash_new)
-    int    HHash_nul [HHASH_SIZE];     // an 'empty' hash table image
-    int   *PHash_sav;                  // alternating 'old/new' hash tables
-    int   *PHash_new;                  // (aka. the 'one/two' actual tables)
+    struct history_hash HHash_one;     // the actual hash tables
+    struct history_hash HHash_two;     // (accessed via PHash_sav/PHash_new)
+    struct history_hash *PHash_sav;    // alternating 'old/new' hash tables
+    struct history_hash *PHash_new;    // (aka. the 'one/two' actual tables)
 };
 
 
-static void pids_config_history (
-        struct pids_info *info)
+static int pids_hash_alloc (
+        struct history_hash *hash,
+        unsigned numslots)
 {
-    int i;
+    HSL_t *slots;
+
+    if (!(slots = calloc(numslots, sizeof(HSL_t))))
+        return 0;
+    free(hash->slots);
+    hash->slots = slots;
+    hash->mask = numslots - 1;
+    hash->epoch = 1;                   // a calloc'd epoch zero is never valid
+    hash->count = 0;
+    return 1;
+} // end: pids_hash_alloc
+
 
-    for (i = 0; i < HHASH_SIZE; i++)   // make the 'empty' table image
-        Hr(HHash_nul[i]) = -1;
-    memcpy(Hr(HHash_one), Hr(HHash_nul), sizeof(Hr(HHash_nul)));
-    memcpy(Hr(HHash_two), Hr(HHash_nul), sizeof(Hr(HHash_nul)));
-    Hr(PHash_sav) = Hr(HHash_one);     // alternating 'old/new' hash tables
-    Hr(PHash_new) = Hr(HHash_two);
+static int pids_config_history (
+        struct pids_info *info)
+{
+    if (!pids_hash_alloc(&Hr(HHash_one), HHASH_INIT)
+    || (!pids_hash_alloc(&Hr(HHash_two), HHASH_INIT)))
+        return 0;
+    Hr(PHash_sav) = &Hr(HHash_one);    // alternating 'old/new' hash tables
+    Hr(PHash_new) = &Hr(HHash_two);
+    return 1;
 } // end: pids_config_history
 
 
+static void pids_free_history (
+        struct pids_info *info)
+{
+    free(Hr(HHash_one.slots));
+    free(Hr(HHash_two.slots));
+    free(Hr(PHist_sav));
+    free(Hr(PHist_new));
+    free(info->hist);
+} // end: pids_free_history
+
+
 static inline HST_t *pids_histget (
         struct pids_info *info,
         int pid)
 {
-    int V = Hr(PHash_sav[_HASH_PID_(pid)]);
+    struct history_hash *hash = Hr(PHash_sav);
+    unsigned pos = _HASH_PID_(pid, hash->mask), dist = 0;
+    HSL_t *s;
 
-    while (-1 < V) {
-        if (Hr(PHist_sav[V].pid) == pid)
-            return &Hr(PHist_sav[V]);
-        V = Hr(PHist_sav[V].lnk);
+    if (info->stats.enabled)
+        info->stats.totals.hist_lookups++;
+    for (;;) {
+        if (info->stats.enabled)
+            info->stats.totals.hist_probes++;
+        s = &hash->slots[pos];
+        if (s->epoch != hash->epoch)
+            return NULL;
+        if (s->pid == pid)
+            return &Hr(PHist_sav[s->idx]);
+        // were it here, we'd have displaced this one (Robin Hood's promise)
+        if (((pos - _HASH_PID_(s->pid, hash->mask)) & hash->mask) < dist)
+            return NULL;
+        pos = (pos + 1) & hash->mask;
+        ++dist;
     }
-    return NULL;
 } // end: pids_histget
 
 
-static inline void pids_histput (
+static inline void pids_hash_insert (
+        struct history_hash *hash,
+        HSL_t this)
+{
+    unsigned pos = _HASH_PID_(this.pid, hash->mask), dist = 0, sdist;
+    HSL_t *s, t;
+
+    this.epoch = hash->epoch;
+    for (;;) {
+        s = &hash->slots[pos];
+        if (s->epoch != hash->epoch) {
+            *s = this;
+            break;
+        }
+        // the poorer (more distant from home) record gets this slot
+        sdist = (pos - _HASH_PID_(s->pid, hash->mask)) & hash->mask;
+        if (sdist < dist) {
+            t = *s;
+            *s = this;
+            this = t;
+            dist = sdist;
+        }
+        pos = (pos + 1) & hash->mask;
+        ++dist;
+    }
+    hash->count++;
+} // end: pids_hash_insert
+
+
+    // double a table's size, when it has become 3/4 full, re-inserting all
+static int pids_hash_grow (
+        struct history_hash *hash)
+{
+    struct history_hash new = { NULL, 0, 0, 0 };
+    unsigned i;
+
+    if (!pids_hash_alloc(&new, (hash->mask + 1) << 1))
+        return 0;
+    for (i = 0; i <= hash->mask; i++)
+        if (hash->slots[i].epoch == hash->epoch)
+            pids_hash_insert(&new, hash->slots[i]);
+    free(hash->slots);
+    *hash = new;
+    return 1;
+} // end: pids_hash_grow
+
+
+static inline int pids_histput (
         struct pids_info *info,
         unsigned this)
 {
-    int V = _HASH_PID_(Hr(PHist_new[this].pid));
+    struct history_hash *hash = Hr(PHash_new);
+    HSL_t slot;
 
-    Hr(PHist_new[this].lnk) = Hr(PHash_new[V]);
-    Hr(PHash_new[V] = this);
+    if ((unsigned)hash->count + 1 > ((hash->mask + 1) >> 2) * 3) {
+        if (!pids_hash_grow(hash))
+            return 0;
+        info->stats.tally.allocs++;
+    }
+    slot.pid = Hr(PHist_new[this].pid);
+    slot.idx = this;
+    pids_hash_insert(hash, slot);
+    return 1;
 } // end: pids_histput
 
-#undef _HASH_PID_
-
 
-static inline int pids_make_hist (
+        /*
+         * This guy only reads the 'sav' history, so it can be safely
+         * called by many parallel reap workers at the same time. */
+static inline void pids_calc_hist (
         struct pids_info *info,
+        HST_t *this,
         proc_t *p)
 {
     TIC_t tics;
     HST_t *h;
-    int slot = info->hist->num_tasks;
-
-    if (slot + 1 >= Hr(HHist_siz)) {
-        Hr(HHist_siz) += NEWOLD_GROW;
-        Hr(PHist_sav) = realloc(Hr(PHist_sav), sizeof(HST_t) * Hr(HHist_siz));
-        Hr(PHist_new) = realloc(Hr(PHist_new), sizeof(HST_t) * Hr(HHist_siz));
-        if (!Hr(PHist_sav) || !Hr(PHist_new))
-            return 0;
-    }
-    Hr(PHist_new[slot].pid)  = p->tid;
-    Hr(PHist_new[slot].maj)  = p->maj_flt;
-    Hr(PHist_new[slot].min)  = p->min_flt;
-    Hr(PHist_new[slot].tics) = tics = (p->utime + p->stime);
 
-    pids_histput(info, slot);
+    this->pid  = p->tid;
+    this->maj  = p->maj_flt;
+    this->min  = p->min_flt;
+    this->tics = tics = (p->utime + p->stime);
+    this->began = p->start_time;
+    this->rss   = p->rss;
+    this->vsize = p->vsize;
+    this->state = p->state;
+    this->stack = NULL;
 
     if ((h = pids_histget(info, p->tid))) {
         tics -= h->tics;
@@ -737,12 +1179,84 @@ static inline int pids_make_hist (
     /* here we're saving elapsed tics, which will include any
        tasks not previously seen via that pids_histget() guy! */
     p->pcpu = tics;
+} // end: pids_calc_hist
 
-    info->hist->num_tasks++;
-    return 1;
+
+static inline HST_t *pids_next_hist (
+        struct pids_info *info)
+{
+    int slot = info->hist->num_tasks;
+
+    if (slot + 1 >= Hr(HHist_siz)) {
+        Hr(HHist_siz) += NEWOLD_GROW;
+        Hr(PHist_sav) = realloc(Hr(PHist_sav), sizeof(HST_t) * Hr(HHist_siz));
+        Hr(PHist_new) = realloc(Hr(PHist_new), sizeof(HST_t) * Hr(HHist_siz));
+        if (!Hr(PHist_sav) || !Hr(PHist_new))
+            return NULL;
+        info->stats.tally.allocs += 2;
+    }
+    return &Hr(PHist_new[slot]);
+} // end: pids_next_hist
+
+
+static inline int pids_make_hist (
+        struct pids_info *info,
+        proc_t *p)
+{
+    HST_t *this;
+
+    if (!(this = pids_next_hist(info)))
+        return 0;
+    pids_calc_hist(info, this, p);
+    return pids_histput(info, info->hist->num_tasks++);
 } // end: pids_make_hist
 
 
+        /*
+         * An incremental reap is about to go looking at the prior cycle's
+         * results, so this guy decides if those still apply to some task.
+         * If so, everything beyond a stat file can then be skipped. */
+static int pids_hist_unchanged (
+        void *data,
+        const proc_t *p)
+{
+    struct pids_info *info = data;
+    HST_t *h;
+
+    info->incr.stack = NULL;
+    if (!(h = pids_histget(info, p->tid))
+    || !h->stack
+    || h->tics  != p->utime + p->stime
+    || h->rss   != p->rss
+    || h->vsize != p->vsize
+    || h->state != p->state
+    || h->began != p->start_time)
+        return 0;
+    info->incr.stack = h->stack;
+    return 1;
+} // end: pids_hist_unchanged
+
+
+    // those stacks which history references will no longer be valid
+static void pids_forget_stacks (
+        struct pids_info *info)
+{
+    int i;
+
+    for (i = 0; i < info->hist->num_tasks; i++)
+        Hr(PHist_new[i].stack) = NULL;
+} // end: pids_forget_stacks
+
+
+    // an incremental reap must know where each task's results were placed
+static inline void pids_hist_stack (
+        struct pids_info *info,
+        struct pids_stack *stack)
+{
+    Hr(PHist_new[info->hist->num_tasks - 1].stack) = stack;
+} // end: pids_hist_stack
+
+
 static inline void pids_toggle_history (
         struct pids_info *info)
 {
@@ -755,7 +1269,15 @@ static inline void pids_toggle_history (
     v = Hr(PHash_sav);
     Hr(PHash_sav) = Hr(PHash_new);
     Hr(PHash_new) = v;
-    memcpy(Hr(PHash_new), Hr(HHash_nul), sizeof(Hr(HHash_nul)));
+    // a new epoch empties that table, unless it wrapped (ok, after 4 billion)
+    Hr(PHash_new->count) = 0;
+    if (0 == ++Hr(PHash_new->epoch)) {
+        memset(Hr(PHash_new->slots), 0, sizeof(HSL_t) * (Hr(PHash_new->mask) + 1));
+        Hr(PHash_new->epoch) = 1;
+    }
+    // and it had better be as large as the one which will soon be its peer
+    if (Hr(PHash_new->mask) < Hr(PHash_sav->mask))
+        pids_hash_alloc(Hr(PHash_new), Hr(PHash_sav->mask) + 1);
 
     info->hist->num_tasks = 0;
 } // end: pids_toggle_history
@@ -765,89 +1287,184 @@ static inline void pids_toggle_history (
 static void pids_unref_rpthash (
         struct pids_info *info)
 {
-    int i, j, pop, total_occupied, maxdepth, maxdepth_sav, numdepth
-        , cross_foot, sz = HHASH_SIZE * (int)sizeof(int)
-        , hsz = (int)sizeof(HST_t) * Hr(HHist_siz);
-    int depths[HHASH_SIZE];
-
-    for (i = 0, total_occupied = 0, maxdepth = 0; i < HHASH_SIZE; i++) {
-        int V = Hr(PHash_new[i]);
-        j = 0;
-        if (-1 < V) {
-            ++total_occupied;
-            while (-1 < V) {
-                V = Hr(PHist_new[V].lnk);
-                if (-1 < V) j++;
-            }
-        }
-        depths[i] = j;
-        if (maxdepth < j) maxdepth = j;
+    struct history_hash *hash = Hr(PHash_new);
+    unsigned i, dist, maxdist = 0, numslots = hash->mask + 1;
+    unsigned long totdist = 0;
+    int hsz = (int)sizeof(HST_t) * Hr(HHist_siz)
+      , sz = (int)(numslots * sizeof(HSL_t));
+    int depths[8] = { 0 };
+
+    for (i = 0; i < numslots; i++) {
+        if (hash->slots[i].epoch != hash->epoch)
+            continue;
+        dist = (i - _HASH_PID_(hash->slots[i].pid, hash->mask)) & hash->mask;
+        if (maxdist < dist) maxdist = dist;
+        totdist += dist;
+        ++depths[dist < 7 ? dist : 7];
     }
-    maxdepth_sav = maxdepth;
 
     fprintf(stderr,
         "\n    History Memory Costs:"
         "\n\tHST_t size = %d, total allocated = %d,"
         "\n\tthus PHist_new & PHist_sav consumed %dk (%d) total bytes."
         "\n"
-        "\n\tTwo hash tables provide for %d entries each + 1 extra 'empty' image,"
-        "\n\tthus %dk (%d) bytes per table for %dk (%d) total bytes."
-        "\n"
-        "\n\tGrand total = %dk (%d) bytes."
+        "\n\tThe current hash table provides %u slots,"
+        "\n\tthus %dk (%d) bytes (its peer will be about the same)."
         "\n"
         "\n    Hash Results Report:"
-        "\n\tTotal hashed = %d"
-        "\n\tLevel-0 hash entries = %d (%d%% occupied)"
-        "\n\tMax Depth = %d"
+        "\n\tTotal hashed = %d (%d%% load factor)"
+        "\n\tMax Displacement = %u, Average = %.2f"
         "\n\n"
         , (int)sizeof(HST_t),  Hr(HHist_siz)
         , hsz / 1024, hsz
-        , HHASH_SIZE
-        , sz / 1024, sz, (sz * 3) / 1024, sz * 3
-        , (hsz + (sz * 3)) / 1024, hsz + (sz * 3)
-        , info->hist->num_tasks
-        , total_occupied, (total_occupied * 100) / HHASH_SIZE
-        , maxdepth);
-
-    if (total_occupied) {
-        for (pop = total_occupied, cross_foot = 0; maxdepth; maxdepth--) {
-            for (i = 0, numdepth = 0; i < HHASH_SIZE; i++)
-                if (depths[i] == maxdepth) ++numdepth;
-            if (numdepth) fprintf(stderr,
-                "\t %5d (%3d%%) hash table entries at depth %d\n"
-                , numdepth, (numdepth * 100) / total_occupied, maxdepth);
-            pop -= numdepth;
-            cross_foot += numdepth;
-            if (0 == pop && cross_foot == total_occupied) break;
-        }
-        if (pop) {
-            fprintf(stderr, "\t %5d (%3d%%) unchained entries (at depth 0)\n"
-                , pop, (pop * 100) / total_occupied);
-            cross_foot += pop;
-        }
-        fprintf(stderr,
-            "\t -----\n"
-            "\t %5d total entries occupied\n", cross_foot);
-
-        if (maxdepth_sav > 1) {
-            fprintf(stderr, "\n    PIDs at max depth: ");
-            for (i = 0; i < HHASH_SIZE; i++)
-                if (depths[i] == maxdepth_sav) {
-                    j = Hr(PHash_new[i]);
-                    fprintf(stderr, "\n\tpos %4d:  %05d", i, Hr(PHist_new[j].pid));
-                    while (-1 < j) {
-                        j = Hr(PHist_new[j].lnk);
-                        if (-1 < j) fprintf(stderr, ", %05d", Hr(PHist_new[j].pid));
-                    }
-                }
-            fprintf(stderr, "\n");
-        }
+        , numslots
+        , sz / 1024, sz
+        , hash->count, (int)(((long)hash->count * 100) / numslots)
+        , maxdist, hash->count ? (double)totdist / hash->count : 0.0);
+
+    if (hash->count) {
+        for (i = 0; i < 8; i++)
+            if (depths[i]) fprintf(stderr,
+                "\t %7d (%3d%%) entries displaced %s%u\n"
+                , depths[i], (depths[i] * 100) / hash->count
+                , i < 7 ? "" : ">= ", i);
     }
 } // end: pids_unref_rpthash
 #endif // UNREF_RPTHASH
 
+#undef _HASH_PID_
 #undef Hr
-#undef HHASH_SIZE
+#undef HHASH_INIT
+
+
+// ___ Column Reap Support ||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+        /*
+         * Each column is allocated for the largest of the result union's
+         * members so that a change of items never requires us to discard
+         * a buffer merely because its element size has now grown.  Then,
+         * any column can be reused by whatever item next lands there. */
+#define COLUMN_SIZ  sizeof(((struct pids_result *)0)->result)
+
+static int pids_columns_alloc (
+        struct pids_info *info,
+        int numcols,
+        int numrows)
+{
+    struct columns_support *c = &info->cols;
+    struct pids_column *p;
+    int i, n;
+
+    if (c->n_cols < numcols) {
+        if (!(p = realloc(c->results.cols, sizeof(struct pids_column) * numcols)))
+            return 0;
+        memset(p + c->n_cols, 0, sizeof(struct pids_column) * (numcols - c->n_cols));
+        c->results.cols = p;
+        c->n_cols = numcols;
+        // those new columns need the same number of rows as all the others
+        c->n_alloc = 0;
+    }
+    if (c->n_alloc < numrows) {
+        n = numrows + STACKS_GROW;
+        for (i = 0; i < c->n_cols; i++) {
+            void *v = realloc(c->results.cols[i].vals.ull_int, COLUMN_SIZ * n);
+            if (!v) {
+                // some are now bigger, some not, so we'll try again next time
+                c->n_alloc = 0;
+                return 0;
+            }
+            c->results.cols[i].vals.ull_int = v;
+        }
+        c->n_alloc = n;
+    }
+    return 1;
+} // end: pids_columns_alloc
+
+
+enum col_type { COL_s_ch, COL_s_int, COL_u_int, COL_ul_int, COL_ull_int, COL_str, COL_strv, COL_real };
+
+static int pids_columns_prep (
+        struct pids_info *info)
+{
+    struct columns_support *c = &info->cols;
+    int numcols = info->curitems - 1;
+    const char *type;
+    char *p;
+    int i;
+
+    // sized for as many rows as there are stacks, most reaps never grow it
+    if (!pids_columns_alloc(info, numcols, info->fetch.n_alloc ? info->fetch.n_alloc : STACKS_INIT))
+        return 0;
+    if (!(p = realloc(c->types, numcols)))
+        return 0;
+    c->types = p;
+    for (i = 0; i < numcols; i++) {
+        c->results.cols[i].item = info->items[i];
+        type = Item_table[info->items[i]].type2str;
+        if      (!strcmp(type, "s_ch"))    c->types[i] = COL_s_ch;
+        else if (!strcmp(type, "s_int"))   c->types[i] = COL_s_int;
+        else if (!strcmp(type, "u_int"))   c->types[i] = COL_u_int;
+        else if (!strcmp(type, "ul_int"))  c->types[i] = COL_ul_int;
+        else if (!strcmp(type, "str"))     c->types[i] = COL_str;
+        else if (!strcmp(type, "strv"))    c->types[i] = COL_strv;
+        else if (!strcmp(type, "real"))    c->types[i] = COL_real;
+        else /* ull_int, noop & extra */   c->types[i] = COL_ull_int;
+    }
+    c->results.rows = &info->fetch.results;
+    c->results.numrows = 0;
+    c->results.numcols = numcols;
+    return 1;
+} // end: pids_columns_prep
+
+
+    /* called with each stack as it's filled, while it's still in cache,
+       so that the columns need no separate pass over every stack later */
+static int pids_columns_row (
+        struct pids_info *info,
+        struct pids_stack *stack,
+        int row)
+{
+ #define colCPY(t) col->vals.t[row] = stack->head[i].result.t; break
+    struct columns_support *c = &info->cols;
+    struct pids_column *col;
+    int i;
+
+    if (row >= c->n_alloc
+    && (!pids_columns_alloc(info, c->results.numcols, row + 1)))
+        return 0;
+    for (i = 0; i < c->results.numcols; i++) {
+        col = &c->results.cols[i];
+        switch (c->types[i]) {
+            case COL_s_ch:    colCPY(s_ch);
+            case COL_s_int:   colCPY(s_int);
+            case COL_u_int:   colCPY(u_int);
+            case COL_ul_int:  colCPY(ul_int);
+            case COL_str:     colCPY(str);
+            case COL_strv:    colCPY(strv);
+            case COL_real:    colCPY(real);
+            default:          colCPY(ull_int);
+        }
+    }
+    c->results.numrows = row + 1;
+    return 1;
+ #undef colCPY
+} // end: pids_columns_row
+
+
+static void pids_columns_free (
+        struct pids_info *info)
+{
+    struct columns_support *c = &info->cols;
+    int i;
+
+    for (i = 0; i < c->n_cols; i++)
+        free(c->results.cols[i].vals.ull_int);
+    free(c->results.cols);
+    free(c->types);
+    memset(c, 0, sizeof(struct columns_support));
+} // end: pids_columns_free
+
+#undef COLUMN_SIZ
 
 
 // ___ Standard Private Functions |||||||||||||||||||||||||||||||||||||||||||||
@@ -871,7 +1488,51 @@ static inline int pids_assign_results (
 } // end: pids_assign_results
 
 
+        /*
+         * Like the above, but for a task found unchanged since the last
+         * incremental reap.  Only those results derived from stat will be
+         * set anew, while all the others are taken from its prior stack. */
+static inline int pids_reuse_results (
+        struct pids_info *info,
+        struct pids_stack *stack,
+        proc_t *p)
+{
+    struct pids_result *this = stack->head;
+    struct pids_result *prior = info->incr.stack->head;
+    int i;
+
+    info->seterr = 0;
+    for (i = 0; ; i++, ++this, ++prior) {
+        enum pids_item item = this->item;
+        if (item >= PIDS_logical_end)
+            break;
+        if (info->incr.reuse[i]) {
+            if (Item_table[item].freefunc)
+                Item_table[item].freefunc(info, this);
+            this->result = prior->result;
+            // any string is now owned by this stack, not the prior one
+            prior->result.ull_int = 0;
+            // but those from the arena won't outlive the next reap, unless
+            // they're copied to this reap's generation (still cheaper than
+            // reading the /proc file anew, though)
+            if (info->strings && this->result.str
+            && strarena_owns(info->arena, this->result.str)) {
+                if (Item_table[item].freefunc == free_pids_str)
+                    this->result.str = strarena_strdup(info->strings, this->result.str);
+                else if (Item_table[item].freefunc == free_pids_strv)
+                    this->result.strv = strarena_strvdup(info->strings, this->result.strv);
+                if (!this->result.str)
+                    info->seterr = 1;
+            }
+        } else
+            Item_table[item].setsfunc(info, this, p);
+    }
+    return !info->seterr;
+} // end: pids_reuse_results
+
+
 static inline void pids_cleanup_stack (
+        struct pids_info *info,
         struct pids_result *this)
 {
     for (;;) {
@@ -879,7 +1540,7 @@ static inline void pids_cleanup_stack (
         if (item >= PIDS_logical_end)
             break;
         if (Item_table[item].freefunc)
-            Item_table[item].freefunc(this);
+            Item_table[item].freefunc(info, this);
         this->result.ull_int = 0;
         ++this;
     }
@@ -894,7 +1555,7 @@ static inline void pids_cleanup_stacks_all (
 
     while (ext) {
         for (i = 0; ext->stacks[i]; i++)
-            pids_cleanup_stack(ext->stacks[i]->head);
+            pids_cleanup_stack(info, ext->stacks[i]->head);
         ext = ext->next;
     };
 } // end: pids_cleanup_stacks_all
@@ -993,23 +1654,75 @@ static inline void pids_libflags_set (
         struct pids_info *info)
 {
     enum pids_item e;
+    unsigned either = 0;
     int i;
 
-    info->oldflags = info->history_yes = 0;
+    info->oldflags = info->history_yes = info->statuskeys = info->nsfields = 0;
+    info->statfields = PROC_STAT_BASE;
     for (i = 0; i < info->curitems; i++) {
         if (((e = info->items[i])) >= PIDS_logical_end)
             break;
         info->oldflags |= Item_table[e].oldflags;
         info->history_yes |= Item_table[e].needhist;
+        info->statfields |= Item_table[e].statflds;
+        if (e >= PIDS_NS_CGROUP && e <= PIDS_NS_UTS)
+            info->nsfields |= 1u << (e - PIDS_NS_CGROUP);
+        if (Item_table[e].oldflags & f_either)
+            either |= Item_table[e].statkeys;
+        else
+            info->statuskeys |= Item_table[e].statkeys;
+    }
+    // an incremental reap relies on stat (and history) to recognize change
+    if (info->incr.enabled) {
+        info->oldflags |= f_stat;
+        info->history_yes = 1;
     }
+    // while cached namespaces need stat's start_time to prove them current
+    if (info->nscache && (info->oldflags & PROC_FILLNS))
+        info->oldflags |= f_stat;
     if (info->oldflags & f_either) {
         if (!(info->oldflags & (f_stat | f_status)))
             info->oldflags |= f_stat;
     }
+    // an f_either item is satisfied by stat, whenever that's been read
+    if (!(info->oldflags & f_stat))
+        info->statuskeys |= either;
     return;
 } // end: pids_libflags_set
 
 
+        /*
+         * The stacks from our last reap become the source of any results
+         * reused, while those from the reap prior to that will be refilled.
+         * Then we decide which of the results can be reused at all. */
+static int pids_incr_prep (
+        struct pids_info *info)
+{
+    struct pids_stack **anchor = info->fetch.anchor;
+    int n_alloc = info->fetch.n_alloc;
+    enum pids_item e;
+    char *reuse;
+    int i;
+
+    info->fetch.anchor = info->incr.anchor;
+    info->fetch.n_alloc = info->incr.n_alloc;
+    info->incr.anchor = anchor;
+    info->incr.n_alloc = n_alloc;
+
+    if (!(reuse = realloc(info->incr.reuse, info->curitems)))
+        return 0;
+    info->incr.reuse = reuse;
+    for (i = 0; i < info->curitems; i++) {
+        if ((e = info->items[i]) >= PIDS_logical_end)
+            break;
+        // a noop is user owned, and whatever isn't from stat is kept as is
+        reuse[i] = (e == PIDS_noop
+            || (Item_table[e].oldflags & ~(f_stat | f_either)));
+    }
+    return 1;
+} // end: pids_incr_prep
+
+
 static inline void pids_oldproc_close (
         PROCTAB **this)
 {
@@ -1025,6 +1738,9 @@ static inline void pids_oldproc_close (
 static inline int pids_oldproc_open (
         PROCTAB **this,
         unsigned flags,
+        unsigned keys,
+        unsigned long long fields,
+        unsigned ns,
         ...)
 {
     va_list vl;
@@ -1032,19 +1748,21 @@ static inline int pids_oldproc_open (
     int num = 0;
 
     if (*this == NULL) {
-        va_start(vl, flags);
+        va_start(vl, ns);
         ids = va_arg(vl, int*);
         if (flags & PROC_UID) num = va_arg(vl, int);
         va_end(vl);
         if (NULL == (*this = openproc(flags, ids, num)))
             return 0;
     }
+    (*this)->statuskeys = keys;
+    (*this)->statfields = fields;
+    (*this)->nsfields = ns;
     return 1;
 } // end: pids_oldproc_open
 
 
-static inline int pids_proc_tally (
-        struct pids_info *info,
+static inline void pids_proc_count (
         struct pids_counts *counts,
         proc_t *p)
 {
@@ -1072,6 +1790,15 @@ static inline int pids_proc_tally (
             break;
     }
     ++counts->total;
+} // end: pids_proc_count
+
+
+static inline int pids_proc_tally (
+        struct pids_info *info,
+        struct pids_counts *counts,
+        proc_t *p)
+{
+    pids_proc_count(counts, p);
 
     if (info->history_yes)
         return pids_make_hist(info, p);
@@ -1090,23 +1817,51 @@ static inline int pids_proc_tally (
  *
  * Returns an array of pointers representing the 'heads' of each new stack.
  */
-static struct stacks_extent *pids_stacks_alloc (
+    // where some item is found within a stack, or -1 if it's not present
+static int pids_sort_offset (
         struct pids_info *info,
-        int maxstacks)
+        struct pids_stack *stack,
+        enum pids_item sortitem)
 {
-    struct stacks_extent *p_blob;
-    struct pids_stack **p_vect;
-    struct pids_stack *p_head;
-    size_t vect_size, head_size, list_size, blob_size;
-    void *v_head, *v_list;
-    int i;
+    struct pids_result *p;
+    int offset;
 
-    vect_size  = sizeof(void *) * maxstacks;                   // size of the addr vectors |
-    vect_size += sizeof(void *);                               // plus NULL addr delimiter |
-    head_size  = sizeof(struct pids_stack);                    // size of that head struct |
-    list_size  = sizeof(struct pids_result) * info->maxitems;  // any single results stack |
-    blob_size  = sizeof(struct stacks_extent);                 // the extent anchor itself |
-    blob_size += vect_size;                                    // plus room for addr vects |
+    // a pids_item is currently unsigned, but we'll protect our future
+    if (sortitem < 0  || sortitem >= PIDS_logical_end)
+        return -1;
+    offset = 0;
+    p = stack->head;
+    for (;;) {
+        if (p->item == sortitem)
+            break;
+        ++offset;
+        if (offset >= info->curitems)
+            return -1;
+        if (p->item >= PIDS_logical_end)
+            return -1;
+        ++p;
+    }
+    return offset;
+} // end: pids_sort_offset
+
+
+static struct stacks_extent *pids_stacks_alloc (
+        struct pids_info *info,
+        int maxstacks)
+{
+    struct stacks_extent *p_blob;
+    struct pids_stack **p_vect;
+    struct pids_stack *p_head;
+    size_t vect_size, head_size, list_size, blob_size;
+    void *v_head, *v_list;
+    int i;
+
+    vect_size  = sizeof(void *) * maxstacks;                   // size of the addr vectors |
+    vect_size += sizeof(void *);                               // plus NULL addr delimiter |
+    head_size  = sizeof(struct pids_stack);                    // size of that head struct |
+    list_size  = sizeof(struct pids_result) * info->maxitems;  // any single results stack |
+    blob_size  = sizeof(struct stacks_extent);                 // the extent anchor itself |
+    blob_size += vect_size;                                    // plus room for addr vects |
     blob_size += head_size * maxstacks;                        // plus room for head thing |
     blob_size += list_size * maxstacks;                        // plus room for our stacks |
 
@@ -1115,6 +1870,7 @@ static struct stacks_extent *pids_stacks_alloc (
              contiguous for every stack since they are accessed through relative position. | */
     if (NULL == (p_blob = calloc(1, blob_size)))
         return NULL;
+    info->stats.tally.allocs++;
 
     p_blob->next = info->extents;                              // push this extent onto... |
     info->extents = p_blob;                                    // ...some existing extents |
@@ -1135,6 +1891,18 @@ static struct stacks_extent *pids_stacks_alloc (
 } // end: pids_stacks_alloc
 
 
+    // the next task from a snapshot or recording, if we're using one, else /proc
+static inline proc_t *pids_read_one (
+        struct pids_info *info)
+{
+    if (info->snap.live)
+        return info->snap.replay
+            ? replay_next(&info->fetch_proc)
+            : snapshot_next(info->snap.sub, &info->fetch_proc);
+    return info->read_something(info->fetch_PT, &info->fetch_proc);
+} // end: pids_read_one
+
+
 static int pids_stacks_fetch (
         struct pids_info *info)
 {
@@ -1142,22 +1910,50 @@ static int pids_stacks_fetch (
  #define n_inuse  info->fetch.n_inuse
  #define n_saved  info->fetch.n_alloc_save
     struct stacks_extent *ext;
-
+    struct pids_stack *stack;
+    struct snapshot *pub = NULL;
+    struct recording *rec = NULL;
+    int n;
+
+    // any ttys not yet named might have come into being since last time
+    devname_refresh();
+    // only a reap of everything in /proc (never a select) is passed along
+    if (!info->snap.live && !(info->fetch_PT->flags & (PROC_PID | PROC_UID))) {
+        pub = info->snap.pub;
+        rec = info->snap.rec;
+    }
     // initialize stuff -----------------------------------
     if (!info->fetch.anchor) {
-        if (!(info->fetch.anchor = calloc(STACKS_INIT, sizeof(void *))))
+        n = 0;
+        // a quick count of /proc spares many a STACKS_GROW with huge systems
+        if (info->snap.live)
+            n = info->snap.live + STACKS_GROW;
+        else if (!(info->fetch_PT->flags & PROC_PID))
+            n = pidscan_count(info->fetch_PT->procpath) + STACKS_GROW;
+        if (n < STACKS_INIT)
+            n = STACKS_INIT;
+        if (!(info->fetch.anchor = calloc(n, sizeof(void *))))
             return -1;
-        if (!(ext = pids_stacks_alloc(info, STACKS_INIT)))
+        if (!(ext = pids_stacks_alloc(info, n)))
             return -1;       // here, errno was set to ENOMEM
-        memcpy(info->fetch.anchor, ext->stacks, sizeof(void *) * STACKS_INIT);
-        n_alloc = STACKS_INIT;
+        memcpy(info->fetch.anchor, ext->stacks, sizeof(void *) * n);
+        n_alloc = n;
     }
     pids_toggle_history(info);
     memset(&info->fetch.counts, 0, sizeof(struct pids_counts));
 
     // iterate stuff --------------------------------------
     n_inuse = 0;
-    while (info->read_something(info->fetch_PT, &info->fetch_proc)) {
+    if (pub && !snapshot_begin(pub, info->fetch_PT->flags, info->statfields))
+        return -1;
+    if (rec)
+        recording_begin(rec);
+    while (pids_read_one(info)) {
+        // these copies must precede those STR_set & VEC_set thefts
+        if (pub && !snapshot_add(pub, &info->fetch_proc))
+            return -1;       // here, errno was set to ENOMEM
+        if (rec && !recording_add(rec, &info->fetch_proc))
+            return -1;       // here, errno was set to ENOMEM
         if (!(n_inuse < n_alloc)) {
             n_alloc += STACKS_GROW;
             if (!(info->fetch.anchor = realloc(info->fetch.anchor, sizeof(void *) * n_alloc))
@@ -1167,9 +1963,17 @@ static int pids_stacks_fetch (
         }
         if (!pids_proc_tally(info, &info->fetch.counts, &info->fetch_proc))
             return -1;       // here, errno was set to ENOMEM
-        if (!pids_assign_results(info, info->fetch.anchor[n_inuse++], &info->fetch_proc))
+        stack = info->fetch.anchor[n_inuse++];
+        if (!(info->incr.stack
+          ? pids_reuse_results(info, stack, &info->fetch_proc)
+          : pids_assign_results(info, stack, &info->fetch_proc)))
+            return -1;       // here, errno was set to ENOMEM
+        if (info->incr.enabled)
+            pids_hist_stack(info, stack);
+        if (info->cols.active && !pids_columns_row(info, stack, n_inuse - 1))
             return -1;       // here, errno was set to ENOMEM
     }
+    info->incr.stack = NULL;
     /* while the possibility is extremely remote, the readproc.c (read_something) |
        simple_readproc and simple_readtask guys could have encountered this error |
        in which case they would have returned a NULL, thus ending our while loop. | */
@@ -1196,6 +2000,504 @@ static int pids_stacks_fetch (
 } // end: pids_stacks_fetch
 
 
+// ___ Snapshot Support |||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+/*
+ * A publisher's reaps are each copied into a shared memory region, which
+ * any number of attached readers then use in place of /proc.  A reader's
+ * reap returns to /proc should that snapshot be too old or lack something
+ * that it needs.  Either way, the results are the same.
+ *
+ * Reaps may also be appended to a recording.  With LIBPROC_REPLAY, every
+ * reap is then served from such a recording instead, with no return to
+ * /proc.  Whatever items were not recorded will simply be empty. */
+
+    // the latest snapshot, if it suits, or else zero (we'll use /proc),
+    // but when replaying a recording, its tasks (or -1, an error)
+static int pids_snap_load (
+        struct pids_info *info,
+        enum pids_fetch_type which)
+{
+    struct snap_meta want = {
+        .flags = info->oldflags, .statuskeys = info->statuskeys,
+        .statfields = info->statfields, .nsfields = info->nsfields,
+        .which = which, .hidden = info->snap.hidden };
+    int n;
+
+    if ((info->snap.replay = replay_active()))
+        return replay_load(info->arena, which, NULL != getenv("LIBPROC_HIDE_KERNEL"));
+    if (!info->snap.sub)
+        return 0;
+    n = snapshot_load(info->snap.sub, info->arena, &want, info->snap.maxage);
+    errno = 0;
+    return n;
+} // end: pids_snap_load
+
+
+    // make what pids_stacks_fetch staged visible to any readers and/or
+    // add it to the recording
+static int pids_snap_commit (
+        struct pids_info *info,
+        enum pids_fetch_type which)
+{
+    struct snap_meta have = {
+        .flags = info->fetch_PT->flags, .statuskeys = info->statuskeys,
+        .statfields = info->statfields, .nsfields = info->nsfields,
+        .which = which, .hidden = info->fetch_PT->hide_kernel };
+
+    if (info->snap.pub && !snapshot_commit(info->snap.pub, &have))
+        return 0;
+    if (info->snap.rec && !recording_commit(info->snap.rec, which, have.hidden))
+        return 0;
+    return 1;
+} // end: pids_snap_commit
+
+
+// ___ Statistics Support |||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+/*
+ * Once procps_pids_stats has been called (or LIBPROC_STATS is set), every
+ * reap, select and get is timed and readproc tallies what it opened, read
+ * and parsed on our behalf.  Until then, it costs a test or two per task. */
+
+    // zero, unless statistics are wanted
+static inline unsigned long long pids_stats_clock (
+        struct pids_info *info)
+{
+    struct timespec ts;
+
+    if (!info->stats.enabled)
+        return 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+} // end: pids_stats_clock
+
+
+    // totals + tally as our caller would see them
+static void pids_stats_fill (
+        struct stats_support *S,
+        struct pids_stats *out)
+{
+    *out = S->totals;
+    out->opens         = S->tally.opens;
+    out->reads         = S->tally.reads;
+    out->bytes         = S->tally.bytes;
+    out->parse_stat    = S->tally.nsecs[RP_COST_STAT];
+    out->parse_status  = S->tally.nsecs[RP_COST_STATUS];
+    out->parse_statm   = S->tally.nsecs[RP_COST_STATM];
+    out->parse_smaps   = S->tally.nsecs[RP_COST_SMAPS];
+    out->parse_vectors = S->tally.nsecs[RP_COST_VECTORS];
+    out->pw_hits       = S->tally.pw_hits;
+    out->pw_misses     = S->tally.pw_misses;
+    out->allocs        = S->tally.allocs;
+} // end: pids_stats_fill
+
+
+    // what a parallel reap worker counted is added to our own
+static void pids_stats_merge (
+        struct stats_support *S,
+        struct stats_support *w)
+{
+    int i;
+
+    S->totals.hist_lookups += w->totals.hist_lookups;
+    S->totals.hist_probes  += w->totals.hist_probes;
+    S->tally.opens     += w->tally.opens;
+    S->tally.reads     += w->tally.reads;
+    S->tally.bytes     += w->tally.bytes;
+    S->tally.allocs    += w->tally.allocs;
+    S->tally.pw_hits   += w->tally.pw_hits;
+    S->tally.pw_misses += w->tally.pw_misses;
+    for (i = 0; i < RP_COST_count; i++)
+        S->tally.nsecs[i] += w->tally.nsecs[i];
+} // end: pids_stats_merge
+
+
+    // account for one reap, select or get (begun at 'beg')
+static void pids_stats_done (
+        struct pids_info *info,
+        unsigned long long beg,
+        int tasks)
+{
+    struct pids_stats s;
+
+    if (!info->stats.enabled)
+        return;
+    info->stats.totals.calls++;
+    info->stats.totals.tasks += (tasks > 0) ? tasks : 0;
+    info->stats.totals.nsecs += pids_stats_clock(info) - beg;
+    if (!info->stats.log)
+        return;
+    pids_stats_fill(&info->stats, &s);
+    fprintf(info->stats.log
+        , "calls %llu tasks %llu nsecs %llu opens %llu reads %llu bytes %llu"
+          " stat %llu status %llu statm %llu smaps %llu vectors %llu"
+          " pw_hits %llu pw_misses %llu hist_lookups %llu hist_probes %llu"
+          " allocs %llu sorts %llu sort_nsecs %llu\n"
+        , s.calls, s.tasks, s.nsecs, s.opens, s.reads, s.bytes
+        , s.parse_stat, s.parse_status, s.parse_statm, s.parse_smaps, s.parse_vectors
+        , s.pw_hits, s.pw_misses, s.hist_lookups, s.hist_probes
+        , s.allocs, s.sorts, s.sort_nsecs);
+    fflush(info->stats.log);
+} // end: pids_stats_done
+
+
+// ___ Parallel Reap Support ||||||||||||||||||||||||||||||||||||||||||||||||||
+
+/*
+ * With procps_pids_reap_parallel, the /proc directory is read just once, by
+ * the caller's thread, and then split into contiguous slices.  Each worker
+ * reads its slice through its own PROCTAB and proc_t (readproc.c keeps its
+ * buffers as __thread) into its own stacks, plus any history that would be
+ * needed.  Then, once all have finished, the caller merges those results in
+ * slice order so they're identical to what procps_pids_reap would return.
+ *
+ * The caller's thread serves as worker zero, with the remainder persisting
+ * (waiting on a condition variable) until the pids_info is unref'd. */
+
+struct pids_worker {
+    struct pids_parallel *par;         // (for the thread's benefit)
+    pthread_t thread;
+    struct pids_info ctx;              // private copy, for Item_table setsfunc
+    PROCTAB *PT;                       // oldlib interface for this slice
+    proc_t proc;                       // the proc_t used by pids_worker_fetch
+    pid_t *pids;                       // this slice (zero terminated)
+    int numpids;                       // number of pids in the above
+    struct fdcache *fdcache;           // a share of the pids_info fd budget
+    struct pids_stack **anchor;        // stacks filled by this worker
+    int n_alloc;                       // number of above pointers allocated
+    int n_inuse;                       // number of above pointers occupied
+    HST_t *hist;                       // hist (if needed) parallel to anchor
+    int hist_siz;                      // number of above HST_t allocated
+    struct pids_counts counts;         // this worker's share of the tally
+    int rc;                            // < 0 when some error was encountered
+};
+
+struct pids_parallel {
+    struct pids_info *info;            // the real (shared) context
+    int numthreads;                    // workers, counting the caller's thread
+    struct pids_worker *workers;
+    pthread_mutex_t lock;              // protects all of the following + extents
+    pthread_cond_t go;                 // signaled by caller, gen was bumped
+    pthread_cond_t done;               // signaled by worker, busy is now zero
+    unsigned gen;                      // reap generation number
+    int busy;                          // workers yet to complete the reap
+    int quit;                          // workers must exit
+    pid_t *scan;                       // tgids from our /proc readdir
+    pid_t *slices;                     // scan + a zero after each slice
+    int scan_siz;                      // number of above pid_t allocated
+};
+
+
+static int pids_worker_grow (
+        struct pids_worker *w,
+        int numstacks)
+{
+    struct stacks_extent *ext;
+
+    if (!(w->anchor = realloc(w->anchor, sizeof(void *) * (w->n_alloc + numstacks))))
+        return 0;
+    w->ctx.stats.tally.allocs++;
+    // the extents anchor is shared so this is serialized ...
+    pthread_mutex_lock(&w->par->lock);
+    ext = pids_stacks_alloc(w->par->info, numstacks);
+    pthread_mutex_unlock(&w->par->lock);
+    if (!ext)
+        return 0;
+    memcpy(w->anchor + w->n_alloc, ext->stacks, sizeof(void *) * numstacks);
+    w->n_alloc += numstacks;
+    return 1;
+} // end: pids_worker_grow
+
+
+static int pids_worker_fetch (
+        struct pids_worker *w)
+{
+    struct pids_info *info = &w->ctx;
+    int n;
+
+    w->n_inuse = 0;
+    memset(&w->counts, 0, sizeof(struct pids_counts));
+    // with the slice size known, the stacks needed can be had in one gulp
+    if (w->n_alloc < w->numpids
+    && !pids_worker_grow(w, w->numpids - w->n_alloc))
+        return -1;
+    if (!pids_oldproc_open(&w->PT, info->oldflags | PROC_PID | PROC_PIDSCAN, info->statuskeys, info->statfields, info->nsfields, w->pids))
+        return -1;
+    w->PT->fdcache = w->fdcache;
+    if (info->stats.enabled)
+        w->PT->tally = &info->stats.tally;
+
+    while (info->read_something(w->PT, &w->proc)) {
+        n = w->n_inuse;
+        if (!(n < w->n_alloc)
+        && !pids_worker_grow(w, STACKS_GROW))
+            goto oops;
+        pids_proc_count(&w->counts, &w->proc);
+        if (info->history_yes) {
+            if (!(n < w->hist_siz)) {
+                if (!(w->hist = realloc(w->hist, sizeof(HST_t) * (w->hist_siz + NEWOLD_GROW))))
+                    goto oops;
+                info->stats.tally.allocs++;
+                w->hist_siz += NEWOLD_GROW;
+            }
+            pids_calc_hist(info, &w->hist[n], &w->proc);
+        }
+        if (!pids_assign_results(info, w->anchor[n], &w->proc))
+            goto oops;
+        w->n_inuse++;
+    }
+    if (errno == ENOMEM)
+        goto oops;
+    pids_oldproc_close(&w->PT);
+    return w->n_inuse;
+oops:
+    pids_oldproc_close(&w->PT);
+    return -1;          // here, errno was set to ENOMEM
+} // end: pids_worker_fetch
+
+
+static void *pids_worker_thread (
+        void *arg)
+{
+    struct pids_worker *w = arg;
+    struct pids_parallel *par = w->par;
+    unsigned gen = 0;
+
+    pthread_mutex_lock(&par->lock);
+    for (;;) {
+        while (par->gen == gen && !par->quit)
+            pthread_cond_wait(&par->go, &par->lock);
+        if (par->quit)
+            break;
+        gen = par->gen;
+        pthread_mutex_unlock(&par->lock);
+
+        errno = 0;
+        w->rc = pids_worker_fetch(w);
+
+        pthread_mutex_lock(&par->lock);
+        if (--par->busy == 0)
+            pthread_cond_signal(&par->done);
+    }
+    pthread_mutex_unlock(&par->lock);
+    // our results are gone with the pool, as must be the buffers and
+    // caches (names, drivers and wait channels) this thread accumulated
+    readproc_thread_free();
+    pwcache_thread_free();
+    devname_thread_free();
+    wchan_thread_free();
+    return NULL;
+} // end: pids_worker_thread
+
+
+static void pids_parallel_fdfree (
+        struct pids_parallel *par)
+{
+    int i;
+
+    for (i = 0; par && i < par->numthreads; i++) {
+        fdcache_free(par->workers[i].fdcache);
+        par->workers[i].fdcache = NULL;
+    }
+} // end: pids_parallel_fdfree
+
+
+static void pids_parallel_free (
+        struct pids_info *info)
+{
+    struct pids_parallel *par = info->par;
+    int i;
+
+    if (!par)
+        return;
+    pthread_mutex_lock(&par->lock);
+    par->quit = 1;
+    pthread_cond_broadcast(&par->go);
+    pthread_mutex_unlock(&par->lock);
+    // the workers' stacks live among info->extents, so need not be free'd
+    for (i = 0; i < par->numthreads; i++) {
+        if (i)
+            pthread_join(par->workers[i].thread, NULL);
+        free(par->workers[i].anchor);
+        free(par->workers[i].hist);
+    }
+    pids_parallel_fdfree(par);
+    pthread_mutex_destroy(&par->lock);
+    pthread_cond_destroy(&par->go);
+    pthread_cond_destroy(&par->done);
+    free(par->workers);
+    free(par->scan);
+    free(par->slices);
+    free(par);
+    info->par = NULL;
+} // end: pids_parallel_free
+
+
+static int pids_parallel_new (
+        struct pids_info *info,
+        int numthreads)
+{
+    struct pids_parallel *par;
+    sigset_t all, old;
+    int i, rc = 0;
+
+    if (!(par = calloc(1, sizeof(struct pids_parallel)))
+    || !(par->workers = calloc(numthreads, sizeof(struct pids_worker)))) {
+        free(par);
+        return -ENOMEM;
+    }
+    par->info = info;
+    pthread_mutex_init(&par->lock, NULL);
+    pthread_cond_init(&par->go, NULL);
+    pthread_cond_init(&par->done, NULL);
+    info->par = par;
+
+    // the caller's signal handlers should never run on one of our threads
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    par->workers[0].par = par;
+    for (i = 1; i < numthreads; i++) {
+        par->workers[i].par = par;
+        if ((rc = pthread_create(&par->workers[i].thread, NULL, pids_worker_thread, &par->workers[i])))
+            break;
+        par->numthreads = i;
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    // those threads created must still be joined, so count the caller too
+    par->numthreads++;
+    if (rc) {
+        pids_parallel_free(info);
+        return -rc;
+    }
+    return 0;
+} // end: pids_parallel_new
+
+
+static int pids_parallel_scan (
+        struct pids_parallel *par)
+{
+    struct pidscan ps = { -1, 0, 0, NULL };
+    char path[PROCPATHLEN];
+    pid_t *p, pid;
+    int i, n = 0, beg, end;
+
+    procps_rootf(path, sizeof(path), "/proc");
+    if (pidscan_open(&ps, path) == -1)
+        goto oops;
+    while ((pid = pidscan_next(&ps, NULL))) {
+        if (n >= par->scan_siz) {
+            if (!(p = realloc(par->scan, sizeof(pid_t) * (par->scan_siz + STACKS_GROW))))
+                goto oops;
+            par->scan = p;
+            if (!(p = realloc(par->slices, sizeof(pid_t) * (par->scan_siz + STACKS_GROW + par->numthreads))))
+                goto oops;
+            par->slices = p;
+            par->scan_siz += STACKS_GROW;
+        }
+        par->scan[n++] = pid;
+    }
+    pidscan_close(&ps);
+
+    // contiguous slices keep the /proc (ie. serial) order and the fdcache warm
+    for (i = 0, p = par->slices; i < par->numthreads; i++) {
+        beg = (long)n * i / par->numthreads;
+        end = (long)n * (i + 1) / par->numthreads;
+        par->workers[i].pids = p;
+        par->workers[i].numpids = end - beg;
+        memcpy(p, par->scan + beg, sizeof(pid_t) * (end - beg));
+        p += end - beg;
+        *p++ = 0;
+    }
+    return n;
+oops:
+    pidscan_close(&ps);
+    return -1;
+} // end: pids_parallel_scan
+
+
+static int pids_parallel_fetch (
+        struct pids_info *info)
+{
+ #define n_saved  info->fetch.n_alloc_save
+    struct pids_parallel *par = info->par;
+    struct pids_worker *w;
+    int i, j, n_inuse, fdmax;
+    HST_t *h;
+
+    if (0 > pids_parallel_scan(par))
+        return -1;
+    pids_toggle_history(info);
+    devname_refresh();
+
+    fdmax = info->fdcache_max / par->numthreads;
+    for (i = 0; i < par->numthreads; i++) {
+        w = &par->workers[i];
+        if ((fdmax || info->nscache) && !w->fdcache)
+            w->fdcache = fdcache_new(fdmax, info->nscache);
+        memcpy(&w->ctx, info, sizeof(struct pids_info));
+        // each worker counts just its own share, later added to ours
+        memset(&w->ctx.stats.totals, 0, sizeof(struct pids_stats));
+        memset(&w->ctx.stats.tally, 0, sizeof(struct readproc_tally));
+    }
+    // off they go, while we do our share as worker zero ...
+    pthread_mutex_lock(&par->lock);
+    par->busy = par->numthreads - 1;
+    par->gen++;
+    pthread_cond_broadcast(&par->go);
+    pthread_mutex_unlock(&par->lock);
+
+    errno = 0;
+    par->workers[0].rc = pids_worker_fetch(&par->workers[0]);
+
+    pthread_mutex_lock(&par->lock);
+    while (par->busy)
+        pthread_cond_wait(&par->done, &par->lock);
+    pthread_mutex_unlock(&par->lock);
+
+    // merge stuff, in slice order -------------------------
+    memset(&info->fetch.counts, 0, sizeof(struct pids_counts));
+    for (i = 0, n_inuse = 0; i < par->numthreads; i++) {
+        w = &par->workers[i];
+        if (w->rc < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        info->fetch.counts.total    += w->counts.total;
+        info->fetch.counts.running  += w->counts.running;
+        info->fetch.counts.sleeping += w->counts.sleeping;
+        info->fetch.counts.stopped  += w->counts.stopped;
+        info->fetch.counts.zombied  += w->counts.zombied;
+        info->fetch.counts.other    += w->counts.other;
+        n_inuse += w->n_inuse;
+        if (info->stats.enabled)
+            pids_stats_merge(&info->stats, &w->ctx.stats);
+    }
+    if (n_saved < n_inuse + 1) {
+        n_saved = n_inuse + 1;
+        if (!(info->fetch.results.stacks = realloc(info->fetch.results.stacks, sizeof(void *) * n_saved)))
+            return -1;
+    }
+    for (i = 0, n_inuse = 0; i < par->numthreads; i++) {
+        w = &par->workers[i];
+        memcpy(info->fetch.results.stacks + n_inuse, w->anchor, sizeof(void *) * w->n_inuse);
+        n_inuse += w->n_inuse;
+        for (j = 0; info->history_yes && j < w->n_inuse; j++) {
+            if (!(h = pids_next_hist(info)))
+                return -1;
+            *h = w->hist[j];
+            if (!pids_histput(info, info->hist->num_tasks++))
+                return -1;
+        }
+        fdcache_sweep(w->fdcache);
+    }
+    info->fetch.results.stacks[n_inuse] = NULL;
+
+    return n_inuse;     // callers beware, this might be zero !
+ #undef n_saved
+} // end: pids_parallel_fetch
+
+
 // ___ Public Functions |||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
 // --- standard required functions --------------------------------------------
@@ -1214,7 +2516,8 @@ PROCPS_EXPORT int procps_pids_new (
         int numitems)
 {
     struct pids_info *p;
-    int pgsz;
+    const char *env, *age;
+    int pgsz, maxage;
 
 #ifdef ITEMTABLE_DEBUG
     int i, failed = 0;
@@ -1291,7 +2594,13 @@ PROCPS_EXPORT int procps_pids_new (
         return -ENOMEM;
     }
     p->hist->HHist_siz = NEWOLD_INIT;
-    pids_config_history(p);
+    if (!pids_config_history(p)
+    || (!(p->arena = strarena_new()))) {
+        pids_free_history(p);
+        free(p->items);
+        free(p);
+        return -ENOMEM;
+    }
 
     pgsz = getpagesize();
     while (pgsz > 1024) { pgsz >>= 1; p->pgs2k_shift++; }
@@ -1301,6 +2610,22 @@ PROCPS_EXPORT int procps_pids_new (
 
     p->fetch.results.counts = &p->fetch.counts;
 
+    // any value other than empty names a file to be appended after each reap
+    if ((env = getenv("LIBPROC_STATS"))) {
+        p->stats.enabled = 1;
+        if (*env)
+            p->stats.log = fopen(env, "ae");
+    }
+
+    // a snapshot is optional, so any problem with one is simply ignored
+    if ((env = getenv("LIBPROC_SNAPSHOT")) && *env) {
+        maxage = SNAP_MAXAGE;
+        if ((age = getenv("LIBPROC_SNAPSHOT_MAXAGE")) && *age)
+            maxage = atoi(age);
+        if (maxage >= 0)
+            procps_pids_attach_snapshot(p, env, maxage);
+    }
+
     p->refcount = 1;
     *info = p;
     return 0;
@@ -1342,7 +2667,7 @@ PROCPS_EXPORT int procps_pids_unref (
             struct stacks_extent *nextext, *ext = (*info)->otherexts;
             while (ext) {
                 nextext = ext->next;
-                pids_cleanup_stack(ext->stacks[0]->head);
+                pids_cleanup_stack(*info, ext->stacks[0]->head);
                 free(ext);
                 ext = nextext;
             };
@@ -1354,11 +2679,21 @@ PROCPS_EXPORT int procps_pids_unref (
 
         if ((*info)->items)
             free((*info)->items);
-        if ((*info)->hist) {
-            free((*info)->hist->PHist_sav);
-            free((*info)->hist->PHist_new);
-            free((*info)->hist);
-        }
+        if ((*info)->hist)
+            pids_free_history(*info);
+        if ((*info)->fdcache)
+            fdcache_free((*info)->fdcache);
+        strarena_free((*info)->arena);
+        pids_parallel_free(*info);
+        pids_columns_free(*info);
+        free((*info)->sort.buf);
+        free((*info)->incr.anchor);
+        free((*info)->incr.reuse);
+        snapshot_close((*info)->snap.pub);
+        snapshot_close((*info)->snap.sub);
+        recording_close((*info)->snap.rec);
+        if ((*info)->stats.log)
+            fclose((*info)->stats.log);
 
         if ((*info)->get_ext)
            pids_oldproc_close(&(*info)->get_PT);
@@ -1380,8 +2715,10 @@ PROCPS_EXPORT struct pids_stack *fatal_proc_unmounted (
         int return_self)
 {
     struct pids_fetch *fetched;
+    char path[PROCPATHLEN], buf[16];
     unsigned tid;
     proc_t self;
+    ssize_t n;
 
     /* this is very likely the *only* newlib function where the
        context (pids_info) of NULL will ever be permitted */
@@ -1390,6 +2727,15 @@ PROCPS_EXPORT struct pids_stack *fatal_proc_unmounted (
         return NULL;
 
     tid = getpid();
+    /* beneath some root prefix, our pid may differ (another namespace)
+       or not exist at all (just files), so we're what 'self' names */
+    if (procps_root_get()) {
+        procps_rootf(path, sizeof(path), "/proc/self");
+        if ((n = readlink(path, buf, sizeof(buf) - 1)) > 0) {
+            buf[n] = '\0';
+            tid = strtoul(buf, NULL, 10);
+        }
+    }
     if (!(fetched = procps_pids_select(info, &tid, 1, PIDS_SELECT_PID)))
         return NULL;
     return fetched->stacks[0];
@@ -1400,6 +2746,7 @@ PROCPS_EXPORT struct pids_stack *procps_pids_get (
         struct pids_info *info,
         enum pids_fetch_type which)
 {
+    unsigned long long beg;
     double up_secs;
 
     errno = EINVAL;
@@ -1411,16 +2758,18 @@ PROCPS_EXPORT struct pids_stack *procps_pids_get (
        expected 'reset' will have been called -- but just in case ... */
     if (!info->curitems)
         return NULL;
+    beg = pids_stats_clock(info);
 
     if (!info->get_ext) {
         if (!(info->get_ext = pids_stacks_alloc(info, 1)))
             return NULL;     // here, errno was overridden with ENOMEM
 fresh_start:
-        if (!pids_oldproc_open(&info->get_PT, info->oldflags))
+        if (!pids_oldproc_open(&info->get_PT, info->oldflags, info->statuskeys, info->statfields, info->nsfields))
             return NULL;     // here, errno was overridden with ENOMEM/others
         info->get_type = which;
         info->read_something = which ? readeither : readproc;
     }
+    info->get_PT->tally = info->stats.enabled ? &info->stats.tally : NULL;
 
     if (info->get_type != which) {
         pids_oldproc_close(&info->get_PT);
@@ -1434,10 +2783,13 @@ fresh_start:
     if (0 >= procps_uptime(&up_secs, NULL))
         info->boot_tics = up_secs * info->hertz;
 
-    if (NULL == info->read_something(info->get_PT, &info->get_proc))
+    if (NULL == info->read_something(info->get_PT, &info->get_proc)) {
+        pids_stats_done(info, beg, 0);
         return NULL;
+    }
     if (!pids_assign_results(info, info->get_ext->stacks[0], &info->get_proc))
         return NULL;
+    pids_stats_done(info, beg, 1);
     return info->get_ext->stacks[0];
 } // end: procps_pids_get
 
@@ -1453,8 +2805,9 @@ PROCPS_EXPORT struct pids_fetch *procps_pids_reap (
         struct pids_info *info,
         enum pids_fetch_type which)
 {
+    unsigned long long beg;
     double up_secs;
-    int rc;
+    int rc, n;
 
     errno = EINVAL;
     if (info == NULL)
@@ -1466,10 +2819,33 @@ PROCPS_EXPORT struct pids_fetch *procps_pids_reap (
     if (!info->curitems)
         return NULL;
     errno = 0;
+    beg = pids_stats_clock(info);
 
-    if (!pids_oldproc_open(&info->fetch_PT, info->oldflags))
+    if ((info->fdcache_max || info->nscache) && !info->fdcache) {
+        // any parallel workers' fds would otherwise count against the budget
+        pids_parallel_fdfree(info->par);
+        info->fdcache = fdcache_new(info->fdcache_max, info->nscache);
+    }
+    if (info->incr.enabled && !pids_incr_prep(info))
+        return NULL;         // here, errno was set to ENOMEM
+    // strings come from one arena generation, with the last reap's in the other
+    strarena_flip(info->arena);
+    if (0 > (n = pids_snap_load(info, which)))
         return NULL;
-    info->read_something = which ? readeither : readproc;
+    if (!(info->snap.live = n)) {
+        if (!pids_oldproc_open(&info->fetch_PT, info->oldflags, info->statuskeys, info->statfields, info->nsfields))
+            return NULL;
+        info->fetch_PT->fdcache = info->fdcache;
+        if (info->incr.enabled) {
+            info->fetch_PT->unchanged = pids_hist_unchanged;
+            info->fetch_PT->unchanged_data = info;
+        }
+        info->fetch_PT->strarena = info->arena;
+        if (info->stats.enabled)
+            info->fetch_PT->tally = &info->stats.tally;
+        info->read_something = which ? readeither : readproc;
+    }
+    info->strings = info->arena;
 
     /* when in a namespace with proc mounted subset=pid,
        we will be restricted to process information only */
@@ -1478,13 +2854,311 @@ PROCPS_EXPORT struct pids_fetch *procps_pids_reap (
         info->boot_tics = up_secs * info->hertz;
 
     rc = pids_stacks_fetch(info);
+    info->strings = NULL;
+    if (info->snap.live) {
+        info->snap.live = 0;
+        pids_stats_done(info, beg, rc);
+        return (rc > 0) ? &info->fetch.results : NULL;
+    }
+    // only a complete scan can say which of the fds kept are now useless
+    if (rc > 0)
+        fdcache_sweep(info->fdcache);
+    if (rc > 0 && (info->snap.pub || info->snap.rec) && !pids_snap_commit(info, which))
+        rc = -1;
 
     pids_oldproc_close(&info->fetch_PT);
+    pids_stats_done(info, beg, rc);
     // we better have found at least 1 pid
     return (rc > 0) ? &info->fetch.results : NULL;
 } // end: procps_pids_reap
 
 
+/* procps_pids_reap_columns():
+ *
+ * Harvest all the available tasks/threads just like procps_pids_reap,
+ * additionally arranging those results as one dense array per item
+ * (each in the order of the original stacks), convenient for scanning
+ * or aggregating any single item across all tasks.  Each row is copied
+ * into those arrays as its stack is filled, not in some later pass.
+ *
+ * Returns: pointer to a pids_columns struct on success, NULL on error.
+ */
+PROCPS_EXPORT struct pids_columns *procps_pids_reap_columns (
+        struct pids_info *info,
+        enum pids_fetch_type which)
+{
+    struct pids_fetch *rows;
+
+    errno = EINVAL;
+    if (info == NULL || !info->curitems)
+        return NULL;
+    if (!pids_columns_prep(info)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    info->cols.active = 1;
+    rows = procps_pids_reap(info, which);
+    info->cols.active = 0;
+    if (!rows)
+        return NULL;
+    return &info->cols.results;
+} // end: procps_pids_reap_columns
+
+
+/* procps_pids_fdcache():
+ *
+ * Have procps_pids_reap retain up to maxfds open file descriptors from
+ * one cycle to the next, so that (for the most part) each task's files
+ * need only be re-read.  A maxfds of zero releases any fds now held.
+ *
+ * Returns: the fd budget actually established (which may be less than
+ *          requested) on success, negative errno on failure.
+ */
+PROCPS_EXPORT int procps_pids_fdcache (
+        struct pids_info *info,
+        int maxfds)
+{
+    struct rlimit rl;
+
+    if (info == NULL || maxfds < 0)
+        return -EINVAL;
+
+    if (info->fdcache) {
+        fdcache_free(info->fdcache);
+        info->fdcache = NULL;
+    }
+    pids_parallel_fdfree(info->par);
+    info->fdcache_max = 0;
+    if (maxfds == 0)
+        return 0;
+
+    // leave at least half of those fds permitted for the caller's own use
+    if (0 == getrlimit(RLIMIT_NOFILE, &rl)
+    && (rl.rlim_cur != RLIM_INFINITY)
+    && (rlim_t)maxfds > rl.rlim_cur / 2)
+        maxfds = rl.rlim_cur / 2;
+
+    errno = 0;
+    if (!(info->fdcache = fdcache_new(maxfds, info->nscache)))
+        return (errno == ENOMEM) ? -ENOMEM : -EINVAL;
+    info->fdcache_max = maxfds;
+    return maxfds;
+} // end: procps_pids_fdcache
+
+
+/* procps_pids_incremental():
+ *
+ * Have procps_pids_reap read each task's stat file first and, should
+ * that task appear unchanged since the prior reap, skip all its other
+ * files by reusing those results already obtained.  The PIDS_CHANGED
+ * item will then identify those tasks whose results were all refreshed.
+ *
+ * Returns: 0 on success, negative errno on failure.
+ */
+PROCPS_EXPORT int procps_pids_incremental (
+        struct pids_info *info,
+        int enable)
+{
+    if (info == NULL)
+        return -EINVAL;
+    if (enable && (info->snap.pub || info->snap.rec))
+        return -EBUSY;
+
+    info->incr.enabled = (enable != 0);
+    info->incr.stack = NULL;
+    pids_forget_stacks(info);
+    pids_libflags_set(info);
+    return 0;
+} // end: procps_pids_incremental
+
+
+/* procps_pids_nscache():
+ *
+ * Have procps_pids_reap remember each task's namespaces, so that the
+ * PIDS_NS_xxx items are read from /proc/#/ns just once for any given
+ * task (as identified by its pid plus start time).  A namespace changed
+ * by setns or unshare in some running task will thus go unnoticed.
+ *
+ * Returns: 0 on success, negative errno on failure.
+ */
+PROCPS_EXPORT int procps_pids_nscache (
+        struct pids_info *info,
+        int enable)
+{
+    if (info == NULL)
+        return -EINVAL;
+
+    // any existing entries (and their fds) are simply rebuilt next reap
+    if (info->fdcache) {
+        fdcache_free(info->fdcache);
+        info->fdcache = NULL;
+    }
+    pids_parallel_fdfree(info->par);
+    info->nscache = (enable != 0);
+    pids_libflags_set(info);
+    return 0;
+} // end: procps_pids_nscache
+
+
+/* procps_pids_publish_snapshot():
+ *
+ * Have each procps_pids_reap copy all it gathered into a shared memory
+ * region, from which any number of other processes can obtain the same
+ * results (see procps_pids_attach_snapshot) without visiting /proc.  A
+ * name lacking any '/' is placed in /dev/shm.  A NULL name ends it.
+ *
+ * Returns: 0 on success, negative errno on failure.
+ */
+PROCPS_EXPORT int procps_pids_publish_snapshot (
+        struct pids_info *info,
+        const char *name)
+{
+    if (info == NULL)
+        return -EINVAL;
+
+    snapshot_close(info->snap.pub);
+    info->snap.pub = NULL;
+    if (name == NULL)
+        return 0;
+    // an incremental reap would leave much of each unchanged task unread
+    if (info->snap.sub || info->incr.enabled)
+        return -EBUSY;
+    errno = 0;
+    if (!(info->snap.pub = snapshot_publish(name)))
+        return errno ? -errno : -ENOMEM;
+    return 0;
+} // end: procps_pids_publish_snapshot
+
+
+/* procps_pids_attach_snapshot():
+ *
+ * Have procps_pids_reap obtain its results from a snapshot published
+ * under this name (see procps_pids_publish_snapshot) rather than from
+ * /proc, whenever the snapshot is no older than maxage milliseconds (zero
+ * means any age) and has all that the current items require.  Otherwise
+ * /proc is read as usual.  A NULL name ends it.
+ *
+ * Returns: 0 on success, negative errno on failure.
+ */
+PROCPS_EXPORT int procps_pids_attach_snapshot (
+        struct pids_info *info,
+        const char *name,
+        int maxage)
+{
+    if (info == NULL || maxage < 0)
+        return -EINVAL;
+
+    snapshot_close(info->snap.sub);
+    info->snap.sub = NULL;
+    if (name == NULL)
+        return 0;
+    if (info->snap.pub || info->snap.rec)
+        return -EBUSY;
+    errno = 0;
+    if (!(info->snap.sub = snapshot_attach(name)))
+        return errno ? -errno : -ENOMEM;
+    info->snap.maxage = maxage;
+    info->snap.hidden = (NULL != getenv("LIBPROC_HIDE_KERNEL"));
+    return 0;
+} // end: procps_pids_attach_snapshot
+
+
+/* procps_pids_record():
+ *
+ * Have each procps_pids_reap append all it gathered to a recording (the
+ * file is created or truncated), along with the current contents of the
+ * /proc files read by the other collections.  A program later run with
+ * LIBPROC_REPLAY naming that file then sees those reaps in place of /proc.
+ * A NULL path ends it, completing the file.
+ *
+ * Returns: 0 on success, negative errno on failure.
+ */
+PROCPS_EXPORT int procps_pids_record (
+        struct pids_info *info,
+        const char *path)
+{
+    if (info == NULL)
+        return -EINVAL;
+
+    recording_close(info->snap.rec);
+    info->snap.rec = NULL;
+    if (path == NULL)
+        return 0;
+    // (as with procps_pids_publish_snapshot)
+    if (info->snap.sub || info->incr.enabled)
+        return -EBUSY;
+    errno = 0;
+    if (!(info->snap.rec = recording_create(path)))
+        return errno ? -errno : -ENOMEM;
+    return 0;
+} // end: procps_pids_record
+
+
+/* procps_pids_reap_parallel():
+ *
+ * Exactly like procps_pids_reap, but with the work divided among some
+ * number of threads (the caller's among them).  A numthreads of zero
+ * means one thread for every online processor.
+ *
+ * Returns: pointer to a pids_fetch struct on success, NULL on error.
+ */
+PROCPS_EXPORT struct pids_fetch *procps_pids_reap_parallel (
+        struct pids_info *info,
+        enum pids_fetch_type which,
+        int numthreads)
+{
+    unsigned long long beg;
+    double up_secs;
+    int rc;
+
+    errno = EINVAL;
+    if (info == NULL || numthreads < 0)
+        return NULL;
+    if (which != PIDS_FETCH_TASKS_ONLY && which != PIDS_FETCH_THREADS_TOO)
+        return NULL;
+    /* with items & numitems technically optional at 'new' time, it's
+       expected 'reset' will have been called -- but just in case ... */
+    if (!info->curitems)
+        return NULL;
+
+    if (numthreads == 0
+    && 1 > (numthreads = sysconf(_SC_NPROCESSORS_ONLN)))
+        numthreads = 1;
+    // a snapshot or recording is used only in the caller's thread
+    if (numthreads == 1 || info->snap.pub || info->snap.sub || info->snap.rec
+    || replay_active())
+        return procps_pids_reap(info, which);
+
+    if (info->par && info->par->numthreads != numthreads)
+        pids_parallel_free(info);
+    if (!info->par && (rc = pids_parallel_new(info, numthreads)) < 0) {
+        errno = -rc;
+        return NULL;
+    }
+    errno = 0;
+    beg = pids_stats_clock(info);
+
+    // each worker gets a share of the budget, so ours would be one too many
+    if (info->fdcache) {
+        fdcache_free(info->fdcache);
+        info->fdcache = NULL;
+    }
+    info->read_something = which ? readeither : readproc;
+
+    /* when in a namespace with proc mounted subset=pid,
+       we will be restricted to process information only */
+    info->boot_tics = 0;
+    if (0 >= procps_uptime(&up_secs, NULL))
+        info->boot_tics = up_secs * info->hertz;
+
+    rc = pids_parallel_fetch(info);
+    pids_stats_done(info, beg, rc);
+
+    // we better have found at least 1 pid
+    return (rc > 0) ? &info->fetch.results : NULL;
+} // end: procps_pids_reap_parallel
+
+
 PROCPS_EXPORT int procps_pids_reset (
         struct pids_info *info,
         enum pids_item *newitems,
@@ -1496,6 +3170,8 @@ PROCPS_EXPORT int procps_pids_reset (
         return -EINVAL;
 
     pids_cleanup_stacks_all(info);
+    // with all results now gone, there's nothing an incremental reap can reuse
+    pids_forget_stacks(info);
 
     /* shame on this caller, they didn't change anything. and unless they have
        altered the depth of the stacks we're not gonna change anything either! */
@@ -1517,6 +3193,13 @@ PROCPS_EXPORT int procps_pids_reset (
             free(info->fetch.anchor);
             info->fetch.anchor = NULL;
         }
+        if (info->incr.anchor) {
+            free(info->incr.anchor);
+            info->incr.anchor = NULL;
+            info->incr.n_alloc = 0;
+        }
+        // any parallel workers' stacks were among those extents just freed
+        pids_parallel_free(info);
         // allow for our PIDS_logical_end
         info->maxitems = newnumitems + 1;
         if (!(info->items = realloc(info->items, sizeof(enum pids_item) * info->maxitems)))
@@ -1551,6 +3234,7 @@ PROCPS_EXPORT struct pids_fetch *procps_pids_select (
         enum pids_select_type which)
 {
     unsigned ids[FILL_ID_MAX + 1];
+    unsigned long long beg;
     double up_secs;
     int rc;
 
@@ -1567,13 +3251,18 @@ PROCPS_EXPORT struct pids_fetch *procps_pids_select (
     if (!info->curitems)
         return NULL;
     errno = 0;
+    beg = pids_stats_clock(info);
 
     // this zero delimiter is really only needed with PIDS_SELECT_PID
     memcpy(ids, these, sizeof(unsigned) * numthese);
     ids[numthese] = 0;
 
-    if (!pids_oldproc_open(&info->fetch_PT, (info->oldflags | which), ids, numthese))
+    if (!pids_oldproc_open(&info->fetch_PT, (info->oldflags | which), info->statuskeys, info->statfields, info->nsfields, ids, numthese))
         return NULL;
+    strarena_flip(info->arena);
+    info->fetch_PT->strarena = info->strings = info->arena;
+    if (info->stats.enabled)
+        info->fetch_PT->tally = &info->stats.tally;
     info->read_something = (which & PIDS_FETCH_THREADS_TOO) ? readeither : readproc;
 
     /* when in a namespace with proc mounted subset=pid,
@@ -1583,8 +3272,10 @@ PROCPS_EXPORT struct pids_fetch *procps_pids_select (
         info->boot_tics = up_secs * info->hertz;
 
     rc = pids_stacks_fetch(info);
+    info->strings = NULL;
 
     pids_oldproc_close(&info->fetch_PT);
+    pids_stats_done(info, beg, rc);
     // no guarantee any pids/uids were found
     return (rc >= 0) ? &info->fetch.results : NULL;
 } // end: procps_pids_select
@@ -1607,41 +3298,107 @@ PROCPS_EXPORT struct pids_stack **procps_pids_sort (
         enum pids_item sortitem,
         enum pids_sort_order order)
 {
-    struct sort_parms parms;
-    struct pids_result *p;
+    unsigned long long beg;
     int offset;
 
     errno = EINVAL;
     if (info == NULL || stacks == NULL)
         return NULL;
-    // a pids_item is currently unsigned, but we'll protect our future
-    if (sortitem < 0  || sortitem >= PIDS_logical_end)
-        return NULL;
     if (order != PIDS_SORT_ASCEND && order != PIDS_SORT_DESCEND)
         return NULL;
     if (numstacked < 2)
         return stacks;
+    if (0 > (offset = pids_sort_offset(info, stacks[0], sortitem)))
+        return NULL;
+    errno = 0;
+    beg = pids_stats_clock(info);
 
-    offset = 0;
-    p = stacks[0]->head;
-    for (;;) {
-        if (p->item == sortitem)
-            break;
-        ++offset;
-        if (offset >= info->curitems)
+    if (Item_table[sortitem].sortfunc(&info->sort, stacks, numstacked, offset, order)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (info->stats.enabled) {
+        info->stats.totals.sorts++;
+        info->stats.totals.sort_nsecs += pids_stats_clock(info) - beg;
+    }
+    return stacks;
+} // end: procps_pids_sort
+
+
+/*
+ * procps_pids_sort_multi():
+ *
+ * Sort stacks anchored in the passed stack pointers array
+ * based on several sort enumerators, with keys[0] the most
+ * significant, each with its own specified order.
+ *
+ * Returns those same addresses sorted.
+ *
+ * Note: all of the stacks must be homogeneous (of equal length and content).
+ */
+PROCPS_EXPORT struct pids_stack **procps_pids_sort_multi (
+        struct pids_info *info,
+        struct pids_stack *stacks[],
+        int numstacked,
+        struct pids_sort_key *keys,
+        int numkeys)
+{
+    int offsets[numkeys > 0 ? numkeys : 1];
+    unsigned long long beg;
+    int i;
+
+    errno = EINVAL;
+    if (info == NULL || stacks == NULL || keys == NULL || numkeys < 1)
+        return NULL;
+    if (numstacked < 2)
+        return stacks;
+    // validate everything first, lest we return with a partial sort
+    for (i = 0; i < numkeys; i++) {
+        if (keys[i].order != PIDS_SORT_ASCEND && keys[i].order != PIDS_SORT_DESCEND)
             return NULL;
-        if (p->item >= PIDS_logical_end)
+        if (0 > (offsets[i] = pids_sort_offset(info, stacks[0], keys[i].item)))
             return NULL;
-        ++p;
     }
     errno = 0;
+    beg = pids_stats_clock(info);
 
-    parms.offset = offset;
-    parms.order = order;
-
-    qsort_r(stacks, numstacked, sizeof(void *), (QSR_t)Item_table[p->item].sortfunc, &parms);
+    // each sort is stable, so the least significant key must go first
+    for (i = numkeys - 1; i >= 0; i--) {
+        if (Item_table[keys[i].item].sortfunc(&info->sort, stacks, numstacked, offsets[i], keys[i].order)) {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    if (info->stats.enabled) {
+        info->stats.totals.sorts++;
+        info->stats.totals.sort_nsecs += pids_stats_clock(info) - beg;
+    }
     return stacks;
-} // end: procps_pids_sort
+} // end: procps_pids_sort_multi
+
+
+/*
+ * procps_pids_stats():
+ *
+ * Report what every reap, select and get has cost since the prior call
+ * (or since LIBPROC_STATS enabled the counting), then zero those totals.
+ * The first call enables the counting, so then mostly returns zeros.
+ *
+ * Returns: 0 on success, negative on error.
+ */
+PROCPS_EXPORT int procps_pids_stats (
+        struct pids_info *info,
+        struct pids_stats *stats)
+{
+    if (info == NULL)
+        return -EINVAL;
+    if (stats)
+        pids_stats_fill(&info->stats, stats);
+    memset(&info->stats.totals, 0, sizeof(struct pids_stats));
+    memset(&info->stats.tally, 0, sizeof(struct readproc_tally));
+    info->stats.enabled = 1;
+    return 0;
+} // end: procps_pids_stats
 
 
 // --- special debugging function(s) ------------------------------------------
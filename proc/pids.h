@@ -186,7 +186,8 @@ enum pids_item {
     PIDS_VM_SWAP,           //   ul_int        status: VmSwap
     PIDS_VM_USED,           //   ul_int        derived from status: VmRSS + VmSwap
     PIDS_VSIZE_BYTES,       //   ul_int        stat: vsize
-    PIDS_WCHAN_NAME         //      str        wchan
+    PIDS_WCHAN_NAME,        //      str        wchan
+    PIDS_CHANGED            //    s_int        derived from stat, 0 if results were reused
 };
                             //              *  while these are all expressed as seconds, each can be
                             //                 converted into tics/jiffies with no loss of precision
@@ -237,12 +238,62 @@ struct pids_fetch {
     struct pids_stack **stacks;
 };
 
+struct pids_column {
+    enum pids_item item;
+    union {
+        signed char         *s_ch;
+        signed int          *s_int;
+        unsigned int        *u_int;
+        unsigned long       *ul_int;
+        unsigned long long  *ull_int;
+        char               **str;
+        char             ***strv;
+        double              *real;
+    } vals;
+};
+
+struct pids_columns {
+    struct pids_fetch *rows;
+    int numrows;
+    int numcols;
+    struct pids_column *cols;
+};
+
+struct pids_sort_key {
+    enum pids_item item;
+    enum pids_sort_order order;
+};
+
+struct pids_stats {
+    unsigned long long calls;          // reaps + selects (+ gets)
+    unsigned long long tasks;          // tasks returned by the above
+    unsigned long long nsecs;          // time spent in the above
+    unsigned long long opens;          // files (and directories) opened
+    unsigned long long reads;          // read calls made on those
+    unsigned long long bytes;          // bytes those returned
+    unsigned long long parse_stat;     // nsecs reading + parsing /proc/#/stat
+    unsigned long long parse_status;   //   ditto, /proc/#/status
+    unsigned long long parse_statm;    //   ditto, /proc/#/statm
+    unsigned long long parse_smaps;    //   ditto, /proc/#/smaps_rollup
+    unsigned long long parse_vectors;  //   ditto, cmdline, environ + cgroup
+    unsigned long long pw_hits;        // user/group names already cached
+    unsigned long long pw_misses;      // user/group names looked up anew
+    unsigned long long hist_lookups;   // prior reap's history searched
+    unsigned long long hist_probes;    // hash slots examined by the above
+    unsigned long long allocs;         // heap allocations made
+    unsigned long long sorts;          // procps_pids_sort + _multi calls
+    unsigned long long sort_nsecs;     // time spent in the above
+};
+
 struct pids_info;
 
 
 #define PIDS_VAL( relative_enum, type, stack, info ) \
     stack -> head [ relative_enum ] . result . type
 
+#define PIDS_COL( relative_enum, type, columns, info ) \
+    columns -> cols [ relative_enum ] . vals . type
+
 
 int procps_pids_new   (struct pids_info **info, enum pids_item *items, int numitems);
 int procps_pids_ref   (struct pids_info  *info);
@@ -260,6 +311,40 @@ struct pids_fetch *procps_pids_reap (
     struct pids_info *info,
     enum pids_fetch_type which);
 
+struct pids_fetch *procps_pids_reap_parallel (
+    struct pids_info *info,
+    enum pids_fetch_type which,
+    int numthreads);
+
+struct pids_columns *procps_pids_reap_columns (
+    struct pids_info *info,
+    enum pids_fetch_type which);
+
+int procps_pids_fdcache (
+    struct pids_info *info,
+    int maxfds);
+
+int procps_pids_incremental (
+    struct pids_info *info,
+    int enable);
+
+int procps_pids_nscache (
+    struct pids_info *info,
+    int enable);
+
+int procps_pids_publish_snapshot (
+    struct pids_info *info,
+    const char *name);
+
+int procps_pids_attach_snapshot (
+    struct pids_info *info,
+    const char *name,
+    int maxage);
+
+int procps_pids_record (
+    struct pids_info *info,
+    const char *path);
+
 int procps_pids_reset (
     struct pids_info *info,
     enum pids_item *newitems,
@@ -278,6 +363,17 @@ struct pids_stack **procps_pids_sort (
     enum pids_item sortitem,
     enum pids_sort_order order);
 
+struct pids_stack **procps_pids_sort_multi (
+    struct pids_info *info,
+    struct pids_stack *stacks[],
+    int numstacked,
+    struct pids_sort_key *keys,
+    int numkeys);
+
+int procps_pids_stats (
+    struct pids_info *info,
+    struct pids_stats *stats);
+
 
 #ifdef XTRA_PROCPS_DEBUG
 # include "xtra-procps-debug.h"
@@ -18,6 +18,8 @@
 #ifndef PROCPS_PRIVATE_H
 #define PROCPS_PRIVATE_H
 
+#include <stddef.h>
+
 #define PROCPS_EXPORT __attribute__ ((visibility("default")))
 
 #define STRINGIFY_ARG(a)	#a
@@ -25,4 +27,13 @@
 
 #define MAXTABLE(t)		(int)(sizeof(t) / sizeof(t[0]))
 
+// The longest prefix procps_root_set will accept, so that any path buffer
+// this much larger than its /proc (or /sys) path can always hold the two.
+#define PROCPS_ROOTMAX		192
+
+// Format some absolute /proc (or /sys) path, beneath the root prefix when
+// there is one, returning the total length as would snprintf.
+int procps_rootf (char *buf, size_t siz, const char *fmt, ...)
+    __attribute__ ((format (printf, 3, 4)));
+
 #endif
@@ -20,9 +20,11 @@
  * License along with this library; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
-
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
 #include <stdlib.h>
 #include <pwd.h>
@@ -31,66 +33,304 @@
 #include "pwcache.h"
 #include "procps-private.h"
 
-// might as well fill cache lines... else we waste memory anyway
+/*
+ * Each thread has a cache for users and another for groups.  Both begin
+ * with 64 buckets and double whenever entries outnumber buckets, so that
+ * thousands of (container) ids never degrade into long chains.
+ *
+ * Two environment variables alter the cache's behavior:
+ *   LIBPROC_PWCACHE_ENUM - when present, the first lookup enumerates the
+ *     entire passwd (or group) database, via getpwent_r (getgrent_r), so
+ *     that later lookups for those ids never make an NSS round-trip.  Only
+ *     ids not seen that way fall back to a getpwuid_r (getgrgid_r).
+ *   LIBPROC_PWCACHE_TTL - the number of seconds after which every cached
+ *     name is considered stale and will be looked up (or enumerated) anew.
+ *     Absent (or zero), names are cached for the life of the thread.
+ *
+ * A name once returned remains valid for the life of its thread, since
+ * callers (readproc, pids) hold onto it.  Thus a name that has changed is
+ * given a new entry and the old one is merely orphaned, until the thread
+ * calls pwcache_thread_free just before it exits.
+ */
 
-#define HASHSIZE  64              /* power of 2 */
-#define HASH(x)   ((x) & (HASHSIZE - 1))
+#define PGC_BITS    6             /* initial hash size, as a power of 2 */
+#define PGC_SLAB    128           /* entries per allocation */
+#define PGC_ENUMAX  65536         /* most entries taken from an enumeration */
+
+#define HASH(c,id)  (((unsigned)(id) * 0x9E3779B1u) >> (32 - (c)->bits))
 
 static char ERRname[] = "?";
 
-static __thread struct pwbuf {
-    struct pwbuf *next;
-    uid_t uid;
+struct pgent {
+    struct pgent *next;
+    unsigned id;
+    unsigned gen;                 // if not the cache's, the name is stale
     char name[P_G_SZ];
-} *pwhash[HASHSIZE];
+};
 
-char *pwcache_get_user(uid_t uid) {
-    struct pwbuf **p;
-    struct passwd *pw;
-
-    p = &pwhash[HASH(uid)];
-    while (*p) {
-        if ((*p)->uid == uid)
-            return((*p)->name);
-        p = &(*p)->next;
+struct pgcache {
+    struct pgent **hash;
+    unsigned bits;
+    unsigned count;
+    unsigned gen;
+    time_t expires;               // when the gen advances, given a ttl
+    int primed;                   // this gen was enumerated (or tried)
+    struct pgent *slab;           // spare entries, carved as needed
+    int slabfree;
+    struct pgent *slabs;          // every slab, chained via its first entry
+};
+
+static __thread struct pgcache pwcache, grcache;
+
+static int cfg_enum;
+static time_t cfg_ttl;
+static pthread_once_t cfg_once = PTHREAD_ONCE_INIT;
+
+// get*ent_r still share a single position with every other thread
+static pthread_mutex_t enum_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the reentrant getpwuid_r/getgrgid_r need some scratch space of their own
+static __thread char *nssbuf;
+static __thread size_t nsssiz;
+
+static __thread unsigned long long *count_hits, *count_misses;
+#define COUNT(c) do { if (c) ++*(c); } while (0)
+
+static int nssbuf_grow (void) {
+    char *p;
+
+    if (!(p = realloc(nssbuf, nsssiz ? nsssiz * 2 : 4096)))
+        return 0;
+    nssbuf = p;
+    nsssiz = nsssiz ? nsssiz * 2 : 4096;
+    return 1;
+}
+
+
+static void pgc_config (void) {
+    const char *s;
+    long ttl;
+
+    cfg_enum = (NULL != getenv("LIBPROC_PWCACHE_ENUM"));
+    if ((s = getenv("LIBPROC_PWCACHE_TTL"))
+    && (ttl = strtol(s, NULL, 10)) > 0)
+        cfg_ttl = ttl;
+}
+
+
+static int pgc_grow (struct pgcache *c, unsigned bits) {
+    struct pgent **old = c->hash, **new, *e, *nxt;
+    unsigned i, n = old ? 1u << c->bits : 0;
+
+    if (!(new = calloc(1u << bits, sizeof(*new))))
+        return 0;
+    c->hash = new;
+    c->bits = bits;
+    for (i = 0; i < n; i++) {
+        for (e = old[i]; e; e = nxt) {
+            nxt = e->next;
+            e->next = new[HASH(c, e->id)];
+            new[HASH(c, e->id)] = e;
+        }
+    }
+    free(old);
+    return 1;
+}
+
+
+    // readies the cache for a lookup, aging it when there's a ttl
+static int pgc_ready (struct pgcache *c) {
+    time_t now;
+
+    if (!c->hash) {
+        pthread_once(&cfg_once, pgc_config);
+        if (!pgc_grow(c, PGC_BITS))
+            return 0;
     }
-    if (!(*p = (struct pwbuf *)malloc(sizeof(struct pwbuf))))
+    if (cfg_ttl && (now = time(NULL)) >= c->expires) {
+        c->gen++;
+        c->expires = now + cfg_ttl;
+        c->primed = 0;
+    }
+    return 1;
+}
+
+
+static struct pgent *pgc_find (struct pgcache *c, unsigned id) {
+    struct pgent *e;
+
+    for (e = c->hash[HASH(c, id)]; e; e = e->next)
+        if (e->id == id)
+            return e;
+    return NULL;
+}
+
+
+    // caches (or freshens) an id's name, which when NULL is the id itself
+static char *pgc_store (struct pgcache *c, unsigned id, const char *name) {
+    struct pgent **p, *e;
+    char buf[P_G_SZ];
+
+    if (!name || strlen(name) >= P_G_SZ) {
+        snprintf(buf, sizeof(buf), "%u", id);
+        name = buf;
+    }
+    for (p = &c->hash[HASH(c, id)]; *p; p = &(*p)->next) {
+        if ((*p)->id != id)
+            continue;
+        if (!strcmp((*p)->name, name)) {
+            (*p)->gen = c->gen;
+            return (*p)->name;
+        }
+        // it was renamed, but the old name may still be in use
+        *p = (*p)->next;
+        c->count--;
+        break;
+    }
+    // growth is just an optimization, so any failure is ignored
+    if (c->count >= (1u << c->bits))
+        pgc_grow(c, c->bits + 1);
+    if (!c->slabfree) {
+        if (!(c->slab = malloc(PGC_SLAB * sizeof(struct pgent))))
+            return ERRname;
+        c->slab[0].next = c->slabs;
+        c->slabs = c->slab;
+        c->slabfree = PGC_SLAB - 1;
+    }
+    e = &c->slab[c->slabfree--];
+    e->id = id;
+    e->gen = c->gen;
+    strcpy(e->name, name);
+    e->next = c->hash[HASH(c, id)];
+    c->hash[HASH(c, id)] = e;
+    c->count++;
+    return e->name;
+}
+
+
+static void pw_enumerate (struct pgcache *c) {
+    struct passwd pwd, *pw;
+    struct pgent *e;
+    int n = 0, rc;
+
+    c->primed = 1;
+    if (!nsssiz && !nssbuf_grow())
+        return;
+    pthread_mutex_lock(&enum_lock);
+    setpwent();
+    while (n < PGC_ENUMAX) {
+        pw = NULL;
+        rc = getpwent_r(&pwd, nssbuf, nsssiz, &pw);
+        if (rc == ERANGE && nssbuf_grow())
+            continue;
+        if (rc || !pw)
+            break;
+        // like getpwuid, the first of any duplicate ids wins
+        if ((e = pgc_find(c, pw->pw_uid)) && e->gen == c->gen)
+            continue;
+        pgc_store(c, pw->pw_uid, pw->pw_name);
+        n++;
+    }
+    endpwent();
+    pthread_mutex_unlock(&enum_lock);
+}
+
+
+static void gr_enumerate (struct pgcache *c) {
+    struct group grp, *gr;
+    struct pgent *e;
+    int n = 0, rc;
+
+    c->primed = 1;
+    if (!nsssiz && !nssbuf_grow())
+        return;
+    pthread_mutex_lock(&enum_lock);
+    setgrent();
+    while (n < PGC_ENUMAX) {
+        gr = NULL;
+        rc = getgrent_r(&grp, nssbuf, nsssiz, &gr);
+        if (rc == ERANGE && nssbuf_grow())
+            continue;
+        if (rc || !gr)
+            break;
+        if ((e = pgc_find(c, gr->gr_gid)) && e->gen == c->gen)
+            continue;
+        pgc_store(c, gr->gr_gid, gr->gr_name);
+        n++;
+    }
+    endgrent();
+    pthread_mutex_unlock(&enum_lock);
+}
+
+
+char *pwcache_get_user(uid_t uid) {
+    struct pgcache *c = &pwcache;
+    struct passwd pwd, *pw = NULL;
+    struct pgent *e;
+
+    if (!pgc_ready(c))
         return ERRname;
-    (*p)->uid = uid;
-    pw = getpwuid(uid);
-    if(!pw || strlen(pw->pw_name) >= P_G_SZ)
-        sprintf((*p)->name, "%u", uid);
-    else
-        strcpy((*p)->name, pw->pw_name);
-
-    (*p)->next = NULL;
-    return((*p)->name);
+    if (cfg_enum && !c->primed)
+        pw_enumerate(c);
+    if ((e = pgc_find(c, uid)) && e->gen == c->gen) {
+        COUNT(count_hits);
+        return e->name;
+    }
+    COUNT(count_misses);
+    // unlike getpwuid, this is safe when many threads are reading /proc
+    while ((nsssiz || nssbuf_grow())
+    && ERANGE == getpwuid_r(uid, &pwd, nssbuf, nsssiz, &pw)
+    && nssbuf_grow())
+        ;
+    return pgc_store(c, uid, pw ? pw->pw_name : NULL);
 }
 
-static __thread struct grpbuf {
-    struct grpbuf *next;
-    gid_t gid;
-    char name[P_G_SZ];
-} *grphash[HASHSIZE];
 
 char *pwcache_get_group(gid_t gid) {
-    struct grpbuf **g;
-    struct group *gr;
-
-    g = &grphash[HASH(gid)];
-    while (*g) {
-        if ((*g)->gid == gid)
-            return((*g)->name);
-        g = &(*g)->next;
+    struct pgcache *c = &grcache;
+    struct group grp, *gr = NULL;
+    struct pgent *e;
+
+    if (!pgc_ready(c))
+        return ERRname;
+    if (cfg_enum && !c->primed)
+        gr_enumerate(c);
+    if ((e = pgc_find(c, gid)) && e->gen == c->gen) {
+        COUNT(count_hits);
+        return e->name;
     }
-    if (!(*g = (struct grpbuf *)malloc(sizeof(struct grpbuf))))
-        return ERRname;;
-    (*g)->gid = gid;
-    gr = getgrgid(gid);
-    if (!gr || strlen(gr->gr_name) >= P_G_SZ)
-        sprintf((*g)->name, "%u", gid);
-    else
-        strcpy((*g)->name, gr->gr_name);
-    (*g)->next = NULL;
-    return((*g)->name);
+    COUNT(count_misses);
+    while ((nsssiz || nssbuf_grow())
+    && ERANGE == getgrgid_r(gid, &grp, nssbuf, nsssiz, &gr)
+    && nssbuf_grow())
+        ;
+    return pgc_store(c, gid, gr ? gr->gr_name : NULL);
+}
+
+
+void pwcache_count(unsigned long long *hits, unsigned long long *misses) {
+    count_hits = hits;
+    count_misses = misses;
+}
+
+
+static void pgc_free (struct pgcache *c) {
+    struct pgent *slab;
+
+    while ((slab = c->slabs)) {
+        c->slabs = slab->next;
+        free(slab);
+    }
+    free(c->hash);
+    memset(c, 0, sizeof(struct pgcache));
+}
+
+
+void pwcache_thread_free(void) {
+    pgc_free(&pwcache);
+    pgc_free(&grcache);
+    free(nssbuf);
+    nssbuf = NULL;
+    nsssiz = 0;
+    count_hits = count_misses = NULL;
 }
@@ -9,4 +9,12 @@
 char *pwcache_get_user(uid_t uid);
 char *pwcache_get_group(gid_t gid);
 
+// Have this thread's lookups counted as either hits (the name was cached)
+// or misses (NSS was asked), until called again (NULLs stop the counting).
+void pwcache_count(unsigned long long *hits, unsigned long long *misses);
+
+// Free this thread's caches (invalidating every name they returned), as
+// must a thread other than the first before it exits.
+void pwcache_thread_free(void);
+
 #endif
@@ -31,8 +31,13 @@
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <limits.h>
 #include <stdint.h>
+#include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #ifdef WITH_SYSTEMD
 #include <systemd/sd-login.h>
 #endif
@@ -44,6 +49,7 @@
 #include "escape.h"
 #include "misc.h"
 #include "pwcache.h"
+#include "wchan.h"
 #include "readproc.h"
 
 // sometimes it's easier to do this manually, w/o gcc helping
@@ -72,7 +78,62 @@ struct utlbuf_s {
     int   siz;     // current len of the above
 } utlbuf_s;
 
-static int task_dir_missing;
+// and those grown as needed by a few particular functions (never shrunk)
+static __thread struct utlbuf_s strvec_ub,     // file2strvec
+                                lxc_ub,        // lxc_containers
+                                proc_ub,       // simple_readproc
+                                task_ub,       // simple_readtask
+                                listed_ub;     // listed_nextpid
+
+// the container names already seen by lxc_containers
+static __thread struct lxc_ele {
+    struct lxc_ele *next;
+    char *name;
+} *lxc_names;
+
+static __thread int task_dir_missing;
+
+// the PROCTAB.strarena (if any) of the current readproc/readeither call
+static __thread struct strarena *str_arena;
+
+// the PROCTAB.tally (if any) of the current readproc/readeither call
+static __thread struct readproc_tally *rp_tally;
+
+#define RP_TALLY(f, n) do { if (rp_tally) rp_tally-> f += (n); } while (0)
+
+static inline unsigned long long rp_clock (void) {
+    struct timespec ts;
+
+    if (!rp_tally)
+        return 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void rp_spent (enum rp_cost which, unsigned long long beg) {
+    if (rp_tally)
+        rp_tally->nsecs[which] += rp_clock() - beg;
+}
+
+static inline void rp_begin (PROCTAB *restrict const PT) {
+    str_arena = PT->strarena;
+    if (rp_tally != PT->tally) {
+        rp_tally = PT->tally;
+        pwcache_count(rp_tally ? &rp_tally->pw_hits : NULL
+            , rp_tally ? &rp_tally->pw_misses : NULL);
+    }
+}
+
+static inline char *rp_strdup (const char *str) {
+    if (str_arena)
+        return strarena_strdup(str_arena, str);
+    RP_TALLY(allocs, 1);
+    return strdup(str);
+}
+
+static inline void rp_free (void *ptr) {
+    if (ptr && !strarena_owns(str_arena, ptr)) free(ptr);
+}
 
 
 // free any additional dynamically acquired storage associated with a proc_t
@@ -81,17 +142,17 @@ static inline void free_acquired (proc_t *p) {
      * here we free those items that might exist even when not explicitly |
      * requested by our caller.  it is expected that pid.c will then free |
      * any remaining dynamic memory which might be dangling off a proc_t. | */
-    if (p->cgname)   free(p->cgname);
-    if (p->cgroup)   free(p->cgroup);
-    if (p->cmd)      free(p->cmd);
-    if (p->sd_mach)  free(p->sd_mach);
-    if (p->sd_ouid)  free(p->sd_ouid);
-    if (p->sd_seat)  free(p->sd_seat);
-    if (p->sd_sess)  free(p->sd_sess);
-    if (p->sd_slice) free(p->sd_slice);
-    if (p->sd_unit)  free(p->sd_unit);
-    if (p->sd_uunit) free(p->sd_uunit);
-    if (p->supgid)   free(p->supgid);
+    rp_free(p->cgname);
+    rp_free(p->cgroup);
+    rp_free(p->cmd);
+    rp_free(p->sd_mach);
+    rp_free(p->sd_ouid);
+    rp_free(p->sd_seat);
+    rp_free(p->sd_sess);
+    rp_free(p->sd_slice);
+    rp_free(p->sd_unit);
+    rp_free(p->sd_uunit);
+    rp_free(p->supgid);
 
     memset(p, '\0', sizeof(proc_t));
 }
@@ -107,14 +168,26 @@ typedef struct status_table_struct {
 #else
     void *addr;
 #endif
+    unsigned key;                 // PROC_STATUS_xxx (or 0 when ignored)
 } status_table_struct;
 
 #ifdef LABEL_OFFSET
-#define F(x) {#x, sizeof(#x)-1, (long)(&&case_##x-&&base)},
+#define F(x) {#x, sizeof(#x)-1, (long)(&&case_##x-&&base), PROC_STATUS_##x},
 #else
-#define F(x) {#x, sizeof(#x)-1, &&case_##x},
+#define F(x) {#x, sizeof(#x)-1, &&case_##x, PROC_STATUS_##x},
 #endif
-#define NUL  {"", 0, 0},
+#define NUL  {"", 0, 0, 0},
+
+// fields we'd never need, unless PROCTAB.statuskeys is zero (ie. all)
+#define PROC_STATUS_CapBnd   0
+#define PROC_STATUS_CapEff   0
+#define PROC_STATUS_CapInh   0
+#define PROC_STATUS_CapPrm   0
+#define PROC_STATUS_FDSize   0
+#define PROC_STATUS_SigQ     0
+#define PROC_STATUS_VmHWM    0
+#define PROC_STATUS_VmPTE    0
+#define PROC_STATUS_VmPeak   0
 
 #define GPERF_TABLE_SIZE 128
 
@@ -137,10 +210,11 @@ typedef struct status_table_struct {
 // and the number of entries. Currently, the table is padded to 128
 // entries and we therefore mask with 127.
 
-static int status2proc (char *S, proc_t *restrict P, int is_proc) {
+static int status2proc (char *S, proc_t *restrict P, int is_proc, unsigned keys) {
     long Threads = 0;
     long Tgid = 0;
     long Pid = 0;
+    unsigned seen = 0;
 
   // 128 entries because we trust the kernel to use ASCII names
   static const unsigned char asso[] =
@@ -228,6 +302,9 @@ ENTER(0x220);
         char *colon;
         status_table_struct entry;
 
+        // with everything of interest now in hand, the rest can be ignored
+        if (keys && (seen & keys) == keys) break;
+
         // advance to next line
         S = strchr(S, '\n');
         if(!S) break;            // if no newline
@@ -243,6 +320,8 @@ ENTER(0x220);
         if(colon[1]!='\t') break;
         if(colon-S != entry.len) continue;
         if(memcmp(entry.name,S,colon-S)) continue;
+        if (keys && !(entry.key & keys)) continue;
+        seen |= entry.key;
 
         S = colon+2; // past the '\t'
 
@@ -273,7 +352,7 @@ ENTER(0x220);
 #endif
         if (!P->cmd) {
             escape_str(buf, raw, sizeof(buf));
-            if (!(P->cmd = strdup(buf))) return 1;
+            if (!(P->cmd = rp_strdup(buf))) return 1;
         }
 #ifdef FALSE_THREADS
         }
@@ -414,7 +493,9 @@ ENTER(0x220);
     // that is not initialized for built-in kernel tasks.
     // Only 2.6.0 and above have "Threads" (nlwp) info.
 
-    if(Threads){
+    if(keys && !(seen & PROC_STATUS_Pid)){
+        ;                   // caller wasn't interested, keep the finder's
+    }else if(Threads){
         P->nlwp = Threads;
         P->tgid = Tgid;     // the POSIX PID value
         P->tid  = Pid;      // the thread ID
@@ -427,7 +508,7 @@ ENTER(0x220);
 #ifdef FALSE_THREADS
     if (!IS_THREAD(P)) {
 #endif
-    if (!P->supgid) {
+    if (!P->supgid && (!keys || (keys & PROC_STATUS_Groups))) {
         P->supgid = strdup("-");
         if (!P->supgid)
             return 1;
@@ -558,7 +639,57 @@ static int sd2proc (proc_t *restrict p) {
 
 // Reads /proc/*/stat files, being careful not to trip over processes with
 // names like ":-) 1 2 3 4 5 6".
-static int stat2proc (const char *S, proc_t *restrict P) {
+#define STAT_MAXFLDS  64            // (only the first 42 are of interest)
+
+    // Locate the start of every field in what follows comm in /proc/#/stat,
+    // where each is separated by exactly one space.  The spaces are found 16
+    // bytes at a time (whenever SSE2 is available), with any remainder done
+    // the old fashioned way.  Returned is the number of fields found.
+static inline int stat_fields_find (const char *S, const char **fld) {
+    size_t i = 0, len = strlen(S);
+    int n = 0;
+
+    fld[n++] = S;
+#ifdef __SSE2__
+    const __m128i spaces = _mm_set1_epi8(' ');
+    for (; i + 16 <= len; i += 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i *)(S + i)), spaces));
+        while (mask) {
+            fld[n++] = S + i + __builtin_ctz(mask) + 1;
+            if (n >= STAT_MAXFLDS) return n;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        if (S[i] == ' ') {
+            fld[n++] = S + i + 1;
+            if (n >= STAT_MAXFLDS) return n;
+        }
+    }
+    return n;
+}
+
+
+    // Convert one field, which like sscanf's %d or %lu may carry a sign.
+    // The result is simply truncated (with a cast) to fit its destination.
+static inline unsigned long long stat_field_num (const char *s) {
+    unsigned long long v = 0, neg = (*s == '-');
+    unsigned d;
+
+    s += neg;
+    while ((d = (unsigned char)*s++ - '0') < 10)
+        v = v * 10 + d;
+    return (v ^ -neg) + neg;
+}
+
+
+    // Parse the /proc/#/stat contents for a process or task.  Only those
+    // 'want'ed fields are converted, although zero means all of them.  Any
+    // field missing with an older kernel leaves its prior (or default) value.
+static int stat2proc (const char *S, proc_t *restrict P, unsigned long long want) {
+    const char *fld[STAT_MAXFLDS];
     char buf[64], raw[64];
     size_t num;
     char *tmp;
@@ -584,49 +715,59 @@ ENTER(0x160);
        memcpy(raw, S, num);
        raw[num] = '\0';
        escape_str(buf, raw, sizeof(buf));
-       if (!(P->cmd = strdup(buf))) return 1;
+       if (!(P->cmd = rp_strdup(buf))) return 1;
     }
 #ifdef FALSE_THREADS
      }
 #endif
     S = tmp + 2;                 // skip ") "
 
-    sscanf(S,
-       "%c "                      // state
-       "%d %d %d %d %d "          // ppid, pgrp, sid, tty_nr, tty_pgrp
-       "%lu %lu %lu %lu %lu "     // flags, min_flt, cmin_flt, maj_flt, cmaj_flt
-       "%llu %llu %llu %llu "     // utime, stime, cutime, cstime
-       "%d %d "                   // priority, nice
-       "%d "                      // num_threads
-       "%lu "                     // 'alarm' == it_real_value (obsolete, always 0)
-       "%llu "                    // start_time
-       "%lu "                     // vsize
-       "%lu "                     // rss
-       "%lu %lu %lu %lu %lu %lu " // rsslim, start_code, end_code, start_stack, esp, eip
-       "%*s %*s %*s %*s "         // pending, blocked, sigign, sigcatch                      <=== DISCARDED
-       "%lu %*u %*u "             // 0 (former wchan), 0, 0                                  <=== Placeholders only
-       "%d %d "                   // exit_signal, task_cpu
-       "%d %d "                   // rt_priority, policy (sched)
-       "%llu %llu %llu",          // blkio_ticks, gtime, cgtime
-       &P->state,
-       &P->ppid, &P->pgrp, &P->session, &P->tty, &P->tpgid,
-       &P->flags, &P->min_flt, &P->cmin_flt, &P->maj_flt, &P->cmaj_flt,
-       &P->utime, &P->stime, &P->cutime, &P->cstime,
-       &P->priority, &P->nice,
-       &P->nlwp,
-       &P->alarm,
-       &P->start_time,
-       &P->vsize,
-       &P->rss,
-       &P->rss_rlim, &P->start_code, &P->end_code, &P->start_stack, &P->kstk_esp, &P->kstk_eip,
-/*     P->signal, P->blocked, P->sigignore, P->sigcatch,   */ /* can't use */
-       &P->wchan, /* &P->nswap, &P->cnswap, */  /* nswap and cnswap dead for 2.4.xx and up */
-/* -- Linux 2.0.35 ends here -- */
-       &P->exit_signal, &P->processor,  /* 2.2.1 ends with "exit_signal" */
-/* -- Linux 2.2.8 to 2.5.17 end here -- */
-       &P->rtprio, &P->sched,  /* both added to 2.5.18 */
-       &P->blkio_tics, &P->gtime, &P->cgtime
-    );
+    num = stat_fields_find(S, fld);
+    want = want ? want | PROC_STAT_BASE : ~0ULL;
+    if (num < STAT_MAXFLDS)
+        want &= (1ULL << num) - 1;
+
+ #define SF(f,t) if (want & PROC_STAT_ ## f) \
+    P-> f = (t)stat_field_num(fld[__builtin_ctzll(PROC_STAT_ ## f)])
+    if (want & PROC_STAT_state)
+        P->state = *fld[0];
+    SF(ppid,        int);
+    SF(pgrp,        int);
+    SF(session,     int);
+    SF(tty,         int);
+    SF(tpgid,       int);
+    SF(flags,       unsigned long);
+    SF(min_flt,     unsigned long);
+    SF(cmin_flt,    unsigned long);
+    SF(maj_flt,     unsigned long);
+    SF(cmaj_flt,    unsigned long);
+    SF(utime,       unsigned long long);
+    SF(stime,       unsigned long long);
+    SF(cutime,      unsigned long long);
+    SF(cstime,      unsigned long long);
+    SF(priority,    int);
+    SF(nice,        int);
+    SF(nlwp,        int);
+    SF(alarm,       unsigned long);       // 'alarm' == it_real_value (obsolete, always 0)
+    SF(start_time,  unsigned long long);
+    SF(vsize,       unsigned long);
+    SF(rss,         unsigned long);
+    SF(rss_rlim,    unsigned long);
+    SF(start_code,  unsigned long);
+    SF(end_code,    unsigned long);
+    SF(start_stack, unsigned long);
+    SF(kstk_esp,    unsigned long);
+    SF(kstk_eip,    unsigned long);
+    // pending, blocked, sigign and sigcatch are useless here
+    SF(wchan,       unsigned long);       // 0 (former wchan), then nswap and cnswap are dead
+    SF(exit_signal, int);
+    SF(processor,   int);
+    SF(rtprio,      int);                 // both added to 2.5.18
+    SF(sched,       int);
+    SF(blkio_tics,  unsigned long long);
+    SF(gtime,       unsigned long long);
+    SF(cgtime,      unsigned long long);
+ #undef SF
 
     if(!P->nlwp)
       P->nlwp = 1;
@@ -635,6 +776,8 @@ ENTER(0x160);
 LEAVE(0x160);
 }
 
+#undef STAT_MAXFLDS
+
 
 /////////////////////////////////////////////////////////////////////////
 
@@ -715,10 +858,12 @@ static void smaps2proc (const char *s, proc_t *restrict P) {
   #undef mkOBJ
 }
 
-static int file2str(const char *directory, const char *what, struct utlbuf_s *ub) {
+    // read an entire (already opened) file into a utility buffer, using
+    // pread so that an fd held open from some earlier cycle can be reused
+    // without the need for an lseek back to the beginning of that file
+static int fd2str(int fd, struct utlbuf_s *ub) {
  #define buffGRW 1024
-    char path[PROCPATHLEN];
-    int fd, num, tot_read = 0, len;
+    int num, tot_read = 0;
 
     /* on first use we preallocate a buffer of minimum size to emulate
        former 'local static' behavior -- even if this read fails, that
@@ -728,84 +873,89 @@ static int file2str(const char *directory, const char *what, struct utlbuf_s *ub
     else {
         ub->buf = calloc(1, (ub->siz = buffGRW));
         if (!ub->buf) return -1;
+        RP_TALLY(allocs, 1);
     }
-    len = snprintf(path, sizeof path, "%s/%s", directory, what);
-    if (len <= 0 || (size_t)len >= sizeof path) return -1;
-    if (-1 == (fd = open(path, O_RDONLY, 0))) return -1;
-    while (0 < (num = read(fd, ub->buf + tot_read, ub->siz - tot_read))) {
+    while (0 < (num = pread(fd, ub->buf + tot_read, ub->siz - tot_read, tot_read))) {
+        RP_TALLY(reads, 1);
         tot_read += num;
         if (tot_read < ub->siz) break;
         if (ub->siz >= INT_MAX - buffGRW) {
             tot_read--;
             break;
         }
-        if (!(ub->buf = realloc(ub->buf, (ub->siz += buffGRW)))) {
-            close(fd);
+        if (!(ub->buf = realloc(ub->buf, (ub->siz += buffGRW))))
             return -1;
-        }
+        RP_TALLY(allocs, 1);
     };
+    RP_TALLY(reads, num == 0);
+    RP_TALLY(bytes, tot_read);
     ub->buf[tot_read] = '\0';
-    close(fd);
     if (tot_read < 1) return -1;
     return tot_read;
  #undef buffGRW
 }
 
 
-static char **file2strvec(const char *directory, const char *what) {
-    char buf[2048];     /* read buf bytes at a time */
-    char *p, *rbuf = 0, *endbuf, **q, **ret, *strp;
-    int fd, tot = 0, n, c, end_of_file = 0;
-    int align;
+static int file2str(int dirfd, const char *what, struct utlbuf_s *ub) {
+    int fd, num;
 
-    const int len = snprintf(buf, sizeof buf, "%s/%s", directory, what);
-    if(len <= 0 || (size_t)len >= sizeof buf) return NULL;
-    fd = open(buf, O_RDONLY, 0);
-    if(fd==-1) return NULL;
+    if (-1 == (fd = openat(dirfd, what, O_RDONLY, 0))) return -1;
+    RP_TALLY(opens, 1);
+    num = fd2str(fd, ub);
+    close(fd);
+    return num;
+}
 
-    /* read whole file into a memory buffer, allocating as we go */
-    while ((n = read(fd, buf, sizeof buf - 1)) >= 0) {
-        if (n < (int)(sizeof buf - 1))
-            end_of_file = 1;
-        if (n <= 0 && tot <= 0) {  /* nothing read now, nothing read before */
-            break;                 /* process died between our open and read */
-        }
-        /* ARG_LEN is our guesstimated median length of a command-line argument
-           or environment variable (the minimum is 1, the maximum is 131072) */
-        #define ARG_LEN 64
-        if (tot >= INT_MAX / (ARG_LEN + (int)sizeof(char*)) * ARG_LEN - n) {
-            end_of_file = 1;       /* integer overflow: null-terminate and break */
-            n = 0;                 /* but tot > 0 */
-        }
-        #undef ARG_LEN
-        if (end_of_file &&
-            ((n > 0 && buf[n-1] != '\0') ||     /* last read char not null */
-             (n <= 0 && rbuf && rbuf[tot-1] != '\0')))  /* last read char not null */
 
-            buf[n++] = '\0';                    /* so append null-terminator */
+static char **file2strvec(int dirfd, const char *what) {
+    char *p, *rbuf, *endbuf, **q, **ret, *strp;
+    int fd, tot = 0, n = 0, c, want;
+    int align;
+    /* ARG_LEN is our guesstimated median length of a command-line argument
+       or environment variable (the minimum is 1, the maximum is 131072) */
+    #define ARG_LEN 64
+    const int limit = INT_MAX / (ARG_LEN + (int)sizeof(char*)) * ARG_LEN;
+    #undef ARG_LEN
 
-        if (n <= 0) break;         /* unneeded (end_of_file = 1) but avoid realloc */
-        rbuf = realloc(rbuf, tot + n);          /* allocate more memory */
-        if (!rbuf) {
-            close(fd);
-            return NULL;
+    fd = openat(dirfd, what, O_RDONLY, 0);
+    if(fd==-1) return NULL;
+    RP_TALLY(opens, 1);
+
+    /* read whole file into our reusable buffer, growing it as we go */
+    for (;;) {
+        if (tot >= limit)
+            break;                 /* integer overflow: null-terminate and break */
+        if (strvec_ub.siz - tot < 4096 + 1) {
+            int siz = !strvec_ub.siz ? 8192 : strvec_ub.siz > limit / 2 ? limit + 1 : strvec_ub.siz * 2;
+            if (!(p = realloc(strvec_ub.buf, siz))) {
+                close(fd);
+                return NULL;
+            }
+            strvec_ub.buf = p;
+            strvec_ub.siz = siz;
+            RP_TALLY(allocs, 1);
         }
-        memcpy(rbuf + tot, buf, n);             /* copy buffer into it */
-        tot += n;                               /* increment total byte ctr */
-        if (end_of_file)
+        want = strvec_ub.siz - tot - 1;   /* always leave room for a null-terminator */
+        if (want > limit - tot)    /* and never read beyond the limit above */
+            want = limit - tot;
+        RP_TALLY(reads, 1);
+        if ((n = read(fd, strvec_ub.buf + tot, want)) <= 0)
+            break;                 /* eof, error or process died since the open */
+        RP_TALLY(bytes, n);
+        tot += n;
+        if (n < want)              /* a short read, so this is the end of file */
             break;
     }
     close(fd);
-    if (n < 0 || tot <= 0) {       /* error, or nothing read */
-        if (rbuf) free(rbuf);
-        return NULL;               /* read error */
-    }
+    if (n < 0 || tot <= 0)         /* error, or nothing read */
+        return NULL;
+    if (strvec_ub.buf[tot-1] != '\0')    /* last read char not null */
+        strvec_ub.buf[tot++] = '\0';      /* so append null-terminator */
 
-    rbuf[tot-1] = '\0';            /* belt and suspenders (the while loop did it, too) */
-    endbuf = rbuf + tot;           /* count space for pointers */
+    endbuf = strvec_ub.buf + tot;         /* count space for pointers */
     align = (sizeof(char*)-1) - ((tot + sizeof(char*)-1) & (sizeof(char*)-1));
     c = sizeof(char*);             /* one extra for NULL term */
-    for (p = rbuf; p < endbuf; p++) {
+    for (p = strvec_ub.buf; p < endbuf; p++) {
         if (!*p || *p == '\n') {
             if (c >= INT_MAX - (tot + (int)sizeof(char*) + align)) break;
             c += sizeof(char*);
@@ -814,8 +964,12 @@ static char **file2strvec(const char *directory, const char *what) {
             *p = 0;
     }
 
-    rbuf = realloc(rbuf, tot + c + align);      /* make room for ptrs AT END */
+    rbuf = str_arena                            /* make room for ptrs AT END */
+        ? strarena_alloc(str_arena, tot + c + align)
+        : malloc(tot + c + align);
     if (!rbuf) return NULL;
+    if (!str_arena) RP_TALLY(allocs, 1);
+    memcpy(rbuf, strvec_ub.buf, tot);
     endbuf = rbuf + tot;                        /* addr just past data buf */
     q = ret = (char**) (endbuf+align);          /* ==> free(*ret) to dealloc */
     for (strp = p = rbuf; p < endbuf; p++) {
@@ -834,27 +988,27 @@ static char **file2strvec(const char *directory, const char *what) {
     // this is the former under utilized 'read_cmdline', which has been
     // generalized in support of these new libproc flags:
     //     PROC_EDITCGRPCVT, PROC_EDITCMDLCVT and PROC_EDITENVRCVT
-static int read_unvectored(char *restrict const dst, unsigned sz, const char *whom, const char *what, char sep) {
-    char path[PROCPATHLEN];
-    int fd, len;
+static int read_unvectored(char *restrict const dst, unsigned sz, int dirfd, const char *what, char sep) {
+    int fd;
     unsigned n = 0;
 
     if(sz <= 0) return 0;
     if(sz >= INT_MAX) sz = INT_MAX-1;
     dst[0] = '\0';
 
-    len = snprintf(path, sizeof(path), "%s/%s", whom, what);
-    if(len <= 0 || (size_t)len >= sizeof(path)) return 0;
-    fd = open(path, O_RDONLY);
+    fd = openat(dirfd, what, O_RDONLY);
     if(fd==-1) return 0;
+    RP_TALLY(opens, 1);
 
     for(;;){
         ssize_t r = read(fd,dst+n,sz-n);
+        RP_TALLY(reads, 1);
         if(r==-1){
             if(errno==EINTR) continue;
             break;
         }
         if(r<=0) break;  // EOF
+        RP_TALLY(bytes, r);
         n += r;
         if(n==sz) {      // filled the buffer
             --n;         // make room for '\0'
@@ -904,13 +1058,13 @@ static int vectorize_dash_rc (char ***vec) {
 
     // This routine reads a 'cgroup' for the designated proc_t and
     // guarantees the caller a valid proc_t.cgroup pointer.
-static int fill_cgroup_cvt (const char *directory, proc_t *restrict p) {
+static int fill_cgroup_cvt (int dirfd, proc_t *restrict p) {
  #define vMAX ( MAX_BUFSZ - (int)(dst - dst_buffer) )
     char *src, *dst, *grp, *eob, *name;
     int tot, x, len;
 
     *(dst = dst_buffer) = '\0';                  // empty destination
-    tot = read_unvectored(src_buffer, MAX_BUFSZ, directory, "cgroup", '\0');
+    tot = read_unvectored(src_buffer, MAX_BUFSZ, dirfd, "cgroup", '\0');
     for (src = src_buffer, eob = src_buffer + tot; src < eob; src += x) {
         x = 1;                                   // loop assist
         if (!*src) continue;
@@ -925,11 +1079,11 @@ static int fill_cgroup_cvt (const char *directory, proc_t *restrict p) {
         dst += len;
         dst += escape_str(dst, grp, vMAX);
     }
-    if (!(p->cgroup = strdup(dst_buffer[0] ? dst_buffer : "-")))
+    if (!(p->cgroup = rp_strdup(dst_buffer[0] ? dst_buffer : "-")))
         return 1;
     name = strstr(p->cgroup, ":name=");
     if (name && *(name+6)) name += 6; else name = p->cgroup;
-    if (!(p->cgname = strdup(name)))
+    if (!(p->cgname = rp_strdup(name)))
         return 1;
     return 0;
  #undef vMAX
@@ -939,13 +1093,13 @@ static int fill_cgroup_cvt (const char *directory, proc_t *restrict p) {
     // This routine reads a 'cmdline' for the designated proc_t, "escapes"
     // the result into a single string while guaranteeing the caller a
     // valid proc_t.cmdline pointer.
-static int fill_cmdline_cvt (const char *directory, proc_t *restrict p) {
+static int fill_cmdline_cvt (int dirfd, proc_t *restrict p) {
  #define uFLG ( ESC_BRACKETS | ESC_DEFUNCT )
-    if (read_unvectored(src_buffer, MAX_BUFSZ, directory, "cmdline", ' '))
+    if (read_unvectored(src_buffer, MAX_BUFSZ, dirfd, "cmdline", ' '))
         escape_str(dst_buffer, src_buffer, MAX_BUFSZ);
     else
         escape_command(dst_buffer, p, MAX_BUFSZ, uFLG);
-    p->cmdline = strdup(dst_buffer[0] ? dst_buffer : "?");
+    p->cmdline = rp_strdup(dst_buffer[0] ? dst_buffer : "?");
     if (!p->cmdline)
         return 1;
     return 0;
@@ -955,11 +1109,11 @@ static int fill_cmdline_cvt (const char *directory, proc_t *restrict p) {
 
     // This routine reads an 'environ' for the designated proc_t and
     // guarantees the caller a valid proc_t.environ pointer.
-static int fill_environ_cvt (const char *directory, proc_t *restrict p) {
+static int fill_environ_cvt (int dirfd, proc_t *restrict p) {
     dst_buffer[0] = '\0';
-    if (read_unvectored(src_buffer, MAX_BUFSZ, directory, "environ", ' '))
+    if (read_unvectored(src_buffer, MAX_BUFSZ, dirfd, "environ", ' '))
         escape_str(dst_buffer, src_buffer, MAX_BUFSZ);
-    p->environ = strdup(dst_buffer[0] ? dst_buffer : "-");
+    p->environ = rp_strdup(dst_buffer[0] ? dst_buffer : "-");
     if (!p->environ)
         return 1;
     return 0;
@@ -969,8 +1123,7 @@ static int fill_environ_cvt (const char *directory, proc_t *restrict p) {
     // Provide the means to value proc_t.lxcname (perhaps only with "-") while
     // tracking all names already seen thus avoiding the overhead of repeating
     // malloc() and free() calls.
-static char *lxc_containers (const char *path) {
-    static __thread struct utlbuf_s ub = { NULL, 0 };   // util buffer for whole cgroup
+static char *lxc_containers (int dirfd) {
     static char lxc_none[] = "-";
     static char lxc_oops[] = "?";              // used when memory alloc fails
     /*
@@ -988,7 +1141,7 @@ static char *lxc_containers (const char *path) {
            2:name=systemd:/
            1:cpuset,cpu,cpuacct,devices,freezer,net_cls,blkio,perf_event,net_prio:/lxc/lxc-P
     */
-    if (file2str(path, "cgroup", &ub) > 0) {
+    if (file2str(dirfd, "cgroup", &lxc_ub) > 0) {
         /* ouch, the next defaults could be changed at lxc ./configure time
            ( and a changed 'lxc.cgroup.pattern' is only available to root ) */
         static const char *lxc_delm1 = "lxc.payload.";    // with lxc-4.0.0
@@ -997,14 +1150,10 @@ static char *lxc_containers (const char *path) {
         const char *delim;
         char *p1;
 
-        if ((p1 = strstr(ub.buf, (delim = lxc_delm1)))
-        || ((p1 = strstr(ub.buf, (delim = lxc_delm2)))
-        || ((p1 = strstr(ub.buf, (delim = lxc_delm3)))))) {
-            static __thread struct lxc_ele {
-                struct lxc_ele *next;
-                char *name;
-            } *anchor = NULL;
-            struct lxc_ele *ele = anchor;
+        if ((p1 = strstr(lxc_ub.buf, (delim = lxc_delm1)))
+        || ((p1 = strstr(lxc_ub.buf, (delim = lxc_delm2)))
+        || ((p1 = strstr(lxc_ub.buf, (delim = lxc_delm3)))))) {
+            struct lxc_ele *ele = lxc_names;
             int delim_len = strlen(delim);
             char *p2;
 
@@ -1027,8 +1176,8 @@ static char *lxc_containers (const char *path) {
                 free(ele);
                 return lxc_oops;
             }
-            ele->next = anchor;                // push the new container name
-            anchor = ele;
+            ele->next = lxc_names;             // push the new container name
+            lxc_names = ele;
             return ele->name;                  // return a new container name
         }
     }
@@ -1037,13 +1186,12 @@ static char *lxc_containers (const char *path) {
 
 
     // Provide the user id at login (or -1 if not available)
-static int login_uid (const char *path) {
+static int login_uid (int dirfd) {
     char buf[PROCPATHLEN];
     int fd, id, in;
 
     id = -1;
-    snprintf(buf, sizeof(buf), "%s/loginuid", path);
-    if ((fd = open(buf, O_RDONLY, 0)) != -1) {
+    if ((fd = openat(dirfd, "loginuid", O_RDONLY, 0)) != -1) {
         in = read(fd, buf, sizeof(buf) - 1);
         close(fd);
         if (in > 0) {
@@ -1055,29 +1203,26 @@ static int login_uid (const char *path) {
 }
 
 
-static char *readlink_exe (const char *path){
-    char buf[PROCPATHLEN];
+static char *readlink_exe (int dirfd){
     int in;
 
-    snprintf(buf, sizeof(buf), "%s/exe", path);
-    in = (int)readlink(buf, src_buffer, MAX_BUFSZ-1);
+    in = (int)readlinkat(dirfd, "exe", src_buffer, MAX_BUFSZ-1);
     if (in > 0) {
         src_buffer[in] = '\0';
         escape_str(dst_buffer, src_buffer, MAX_BUFSZ);
-        return strdup(dst_buffer);
+        return rp_strdup(dst_buffer);
     }
-    return strdup("-");
+    return rp_strdup("-");
 }
 
 
     // Provide the autogroup fields (or -1 if not available)
-static void autogroup_fill (const char *path, proc_t *p) {
+static void autogroup_fill (int dirfd, proc_t *p) {
     char buf[PROCPATHLEN];
     int fd, in;
 
     p->autogrp_id = -1;
-    snprintf(buf, sizeof(buf), "%s/autogroup", path);
-    if ((fd = open(buf, O_RDONLY, 0)) != -1) {
+    if ((fd = openat(dirfd, "autogroup", O_RDONLY, 0)) != -1) {
         in = read(fd, buf, sizeof(buf) - 1);
         close(fd);
         if (in > 0) {
@@ -1112,18 +1257,439 @@ static void autogroup_fill (const char *path, proc_t *p) {
         } )
 
 
+//////////////////////////////////////////////////////////////////////////////////
+// An fdcache retains the /proc/# directory fd plus those for the 4 files read
+// most often, so a later scan can simply pread them again.  Entries are hashed
+// by tid (with int links, just like the pids history) and any not seen during
+// a complete scan are discarded, along with their fds, by fdcache_sweep.  An
+// entry can also remember the task's namespaces, guarded by its start_time.
+// So that start_time is always checked, stat is read whenever there's a cache.
+
+#define FDC_HASHSIZ  4096               // power of 2
+#define FDC_HASH(k)  ((k) & (FDC_HASHSIZ - 1))
+#define FDC_GROW     256                // entries added when exhausted
+
+enum fdc_file { FDC_PIDDIR, FDC_STAT, FDC_STATM, FDC_STATUS, FDC_WCHAN, FDC_MAXFILES };
+
+struct fdcache_ent {
+    int tid;                            // key (or zero when on free list)
+    int lnk;                            // next on hash chain (or free list)
+    unsigned gen;                       // last scan generation seeing tid
+    unsigned long long start_time;      // from stat, guards against reuse
+    int fds[FDC_MAXFILES];              // -1 when not (yet) held
+    unsigned nshave;                    // 1 << PROCPS_NS_xxx already in ns
+    struct procps_ns ns;                // (only when fdcache.keepns)
+};
+
+struct fdcache {
+    int maxfds;                         // the caller's fd budget
+    int keepns;                         // remember each task's namespaces
+    int numfds;                         // number of fds presently held
+    unsigned gen;                       // the current scan generation
+    int siz;                            // total entries allocated
+    int avail;                          // head of free list (or -1)
+    struct fdcache_ent *ents;
+    int hash[FDC_HASHSIZ];
+};
+
+
+struct fdcache *fdcache_new (int maxfds, int keepns) {
+    struct fdcache *fdc;
+    int i;
+
+    // no fds at all is fine, so long as there's some other purpose
+    if ((maxfds < FDC_MAXFILES && (maxfds || !keepns))
+    || !(fdc = calloc(1, sizeof(struct fdcache))))
+        return NULL;
+    fdc->maxfds = maxfds;
+    fdc->keepns = keepns;
+    fdc->gen = 1;
+    fdc->avail = -1;
+    for (i = 0; i < FDC_HASHSIZ; i++)
+        fdc->hash[i] = -1;
+    return fdc;
+}
+
+
+static void fdcache_close (struct fdcache *fdc, struct fdcache_ent *ent, enum fdc_file first) {
+    int i;
+
+    for (i = first; i < FDC_MAXFILES; i++) {
+        if (ent->fds[i] != -1) {
+            close(ent->fds[i]);
+            ent->fds[i] = -1;
+            fdc->numfds--;
+        }
+    }
+}
+
+
+static void fdcache_drop (struct fdcache *fdc, int slot) {
+    struct fdcache_ent *ent = &fdc->ents[slot];
+    int *link = &fdc->hash[FDC_HASH(ent->tid)];
+
+    while (*link != slot)
+        link = &fdc->ents[*link].lnk;
+    *link = ent->lnk;
+    fdcache_close(fdc, ent, FDC_PIDDIR);
+    ent->tid = 0;
+    ent->lnk = fdc->avail;
+    fdc->avail = slot;
+}
+
+
+    // find (or create) the entry for some tid, marking it seen this scan
+static int fdcache_lookup (struct fdcache *fdc, int tid) {
+    struct fdcache_ent *ent;
+    int i, slot = fdc->hash[FDC_HASH(tid)];
+
+    while (slot != -1) {
+        if (fdc->ents[slot].tid == tid)
+            goto found;
+        slot = fdc->ents[slot].lnk;
+    }
+    if (fdc->avail == -1) {
+        if (!(ent = realloc(fdc->ents, sizeof(struct fdcache_ent) * (fdc->siz + FDC_GROW))))
+            return -1;
+        fdc->ents = ent;
+        for (i = fdc->siz + FDC_GROW - 1; i >= fdc->siz; i--) {
+            fdc->ents[i].tid = 0;
+            fdc->ents[i].lnk = fdc->avail;
+            fdc->avail = i;
+        }
+        fdc->siz += FDC_GROW;
+    }
+    slot = fdc->avail;
+    ent = &fdc->ents[slot];
+    fdc->avail = ent->lnk;
+    ent->tid = tid;
+    ent->start_time = 0;
+    ent->nshave = 0;
+    for (i = 0; i < FDC_MAXFILES; i++)
+        ent->fds[i] = -1;
+    ent->lnk = fdc->hash[FDC_HASH(tid)];
+    fdc->hash[FDC_HASH(tid)] = slot;
+found:
+    fdc->ents[slot].gen = fdc->gen;
+    return slot;
+}
+
+
+void fdcache_sweep (struct fdcache *fdc) {
+    int i;
+
+    if (!fdc) return;
+    for (i = 0; i < fdc->siz; i++)
+        if (fdc->ents[i].tid && fdc->ents[i].gen != fdc->gen)
+            fdcache_drop(fdc, i);
+    fdc->gen++;
+}
+
+
+void fdcache_free (struct fdcache *fdc) {
+    int i;
+
+    if (!fdc) return;
+    for (i = 0; i < fdc->siz; i++)
+        if (fdc->ents[i].tid)
+            fdcache_close(fdc, &fdc->ents[i], FDC_PIDDIR);
+    free(fdc->ents);
+    free(fdc);
+}
+
+
+    // Read one of those files an fdcache can hold.  When an fd was kept from
+    // some previous scan it's simply re-read, otherwise the file is opened
+    // relative to the piddir and then retained if the budget permits.  Should
+    // a kept fd fail, the task has died (and its tid maybe since been reused)
+    // so the entry's fds are discarded, with any piddir in use handed back to
+    // the PROCTAB, and PT->fdslot is left as -1 to signal that.
+static int fdcache_file2str (PROCTAB *restrict const PT, enum fdc_file which, const char *what, struct utlbuf_s *ub) {
+    struct fdcache *fdc = PT->fdcache;
+    struct fdcache_ent *ent;
+    int fd, num;
+
+    if (!fdc || PT->fdslot == -1)
+        return file2str(PT->piddir, what, ub);
+    ent = &fdc->ents[PT->fdslot];
+
+    if ((fd = ent->fds[which]) != -1) {
+        if ((num = fd2str(fd, ub)) != -1)
+            return num;
+        if (PT->piddir_kept) {
+            ent->fds[FDC_PIDDIR] = -1;
+            fdc->numfds--;
+            PT->piddir_kept = 0;
+        }
+        fdcache_close(fdc, ent, FDC_PIDDIR);
+        PT->fdslot = -1;
+        return -1;
+    }
+    if (-1 == (fd = openat(PT->piddir, what, O_RDONLY | O_CLOEXEC)))
+        return -1;
+    RP_TALLY(opens, 1);
+    num = fd2str(fd, ub);
+    if (num != -1 && fdc->numfds < fdc->maxfds) {
+        ent->fds[which] = fd;
+        fdc->numfds++;
+    } else
+        close(fd);
+    return num;
+}
+
+
+    // when a tid has been reused, the former owner's fds must not be served
+static void fdcache_verify (PROCTAB *restrict const PT, const proc_t *restrict const p) {
+    struct fdcache_ent *ent;
+
+    if (!PT->fdcache || PT->fdslot == -1)
+        return;
+    ent = &PT->fdcache->ents[PT->fdslot];
+    if (ent->start_time != p->start_time) {
+        // the piddir and stat were just proven good, but not the others
+        if (ent->start_time)
+            fdcache_close(PT->fdcache, ent, FDC_STATM);
+        ent->start_time = p->start_time;
+        ent->nshave = 0;
+    }
+}
+
+
+    // Read just those /proc/#/ns/* wanted.  With an fdcache keeping them, a
+    // task's namespaces are read only once since they rarely (if ever) change,
+    // with stat (always read then) having let its start_time vouch for the tid.
+static void ns2proc (PROCTAB *restrict const PT, proc_t *restrict const p) {
+    unsigned want = PT->nsfields ? PT->nsfields : (1u << PROCPS_NS_COUNT) - 1;
+    struct fdcache_ent *ent;
+    struct procps_ns ns;
+    int i;
+
+    if (!PT->fdcache || !PT->fdcache->keepns || PT->fdslot == -1) {
+        ns_read_at(PT->piddir, want, &p->ns);
+        return;
+    }
+    ent = &PT->fdcache->ents[PT->fdslot];
+    if (want & ~ent->nshave) {
+        ns_read_at(PT->piddir, want & ~ent->nshave, &ns);
+        for (i = 0; i < PROCPS_NS_COUNT; i++)
+            if (want & ~ent->nshave & (1u << i))
+                ent->ns.ns[i] = ns.ns[i];
+        ent->nshave |= want;
+    }
+    p->ns = ent->ns;
+}
+
+#undef FDC_HASHSIZ
+#undef FDC_HASH
+#undef FDC_GROW
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// A strarena carves strings from a few large chunks (each twice the size of
+// the one before) and never frees them individually.  It has two generations
+// of such chunks, alternated by strarena_flip, which rewinds the older one in
+// O(1) so the strings of the scan just prior can survive one more scan.
+
+#define SA_CHUNK_MIN  (64 * 1024)       // the size of a first chunk
+#define SA_CHUNK_MAX  (4 * 1024 * 1024) // the biggest, unless for a huge string
+#define SA_ALIGN(n)   (((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+struct strarena_chunk {
+    struct strarena_chunk *next;
+    size_t siz;                         // bytes in data
+    size_t used;                        // bytes carved so far
+    void *data[];                       // (pointer aligned, for vectors)
+};
+
+struct strarena {
+    struct {
+        struct strarena_chunk *head;    // all of this generation's chunks
+        struct strarena_chunk *cur;     // the one now being carved
+    } gen[2];
+    int now;                            // the current generation (0 or 1)
+};
+
+
+struct strarena *strarena_new (void) {
+    return calloc(1, sizeof(struct strarena));
+}
+
+
+void strarena_flip (struct strarena *sa) {
+    sa->now ^= 1;
+    sa->gen[sa->now].cur = sa->gen[sa->now].head;
+    if (sa->gen[sa->now].head)
+        sa->gen[sa->now].head->used = 0;
+}
+
+
+char *strarena_alloc (struct strarena *sa, size_t len) {
+    struct strarena_chunk *c = sa->gen[sa->now].cur, *new;
+    size_t siz;
+
+    len = SA_ALIGN(len);
+    // the current chunk or any one beyond it (after a flip) might do
+    while (c) {
+        if (c->siz - c->used >= len) {
+            c->used += len;
+            sa->gen[sa->now].cur = c;
+            return (char *)c->data + c->used - len;
+        }
+        if (!c->next)
+            break;
+        c = c->next;
+        c->used = 0;
+    }
+    siz = c ? c->siz * 2 : SA_CHUNK_MIN;
+    if (siz > SA_CHUNK_MAX) siz = SA_CHUNK_MAX;
+    if (siz < len) siz = len;
+    if (!(new = malloc(sizeof(struct strarena_chunk) + siz)))
+        return NULL;
+    RP_TALLY(allocs, 1);
+    new->next = NULL;
+    new->siz = siz;
+    new->used = len;
+    if (c) c->next = new;
+    else sa->gen[sa->now].head = new;
+    sa->gen[sa->now].cur = new;
+    return (char *)new->data;
+}
+
+
+char *strarena_strdup (struct strarena *sa, const char *str) {
+    size_t len = strlen(str) + 1;
+    char *p;
+
+    if ((p = strarena_alloc(sa, len)))
+        memcpy(p, str, len);
+    return p;
+}
+
+
+    // the copy will have its pointers first, then all the strings
+char **strarena_strvdup (struct strarena *sa, char **vec) {
+    size_t tot = 0;
+    char **new, *p;
+    int i, n;
+
+    for (n = 0; vec[n]; n++)
+        tot += strlen(vec[n]) + 1;
+    if (!(new = (char **)strarena_alloc(sa, sizeof(char *) * (n + 1) + tot)))
+        return NULL;
+    p = (char *)(new + n + 1);
+    for (i = 0; i < n; i++) {
+        tot = strlen(vec[i]) + 1;
+        new[i] = memcpy(p, vec[i], tot);
+        p += tot;
+    }
+    new[n] = NULL;
+    return new;
+}
+
+
+int strarena_owns (const struct strarena *sa, const void *ptr) {
+    const struct strarena_chunk *c;
+    int i;
+
+    if (!sa) return 0;
+    for (i = 0; i < 2; i++)
+        for (c = sa->gen[i].head; c; c = c->next)
+            if ((uintptr_t)ptr >= (uintptr_t)c->data
+            && (uintptr_t)ptr < (uintptr_t)c->data + c->siz)
+                return 1;
+    return 0;
+}
+
+
+void strarena_free (struct strarena *sa) {
+    struct strarena_chunk *c, *next;
+    int i;
+
+    if (!sa) return;
+    for (i = 0; i < 2; i++)
+        for (c = sa->gen[i].head; c; c = next) {
+            next = c->next;
+            free(c);
+        }
+    free(sa);
+}
+
+#undef SA_CHUNK_MIN
+#undef SA_CHUNK_MAX
+#undef SA_ALIGN
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Open the /proc/# (or /proc/#/task/#) directory itself, retaining that fd in
+// the PROCTAB so every subsequent file can be opened relative to it, sparing
+// the kernel a repeated path walk (and dentry lookups) for each file.  With an
+// fdcache, that fd will often have been kept from some previous scan.
+static int piddir_open (PROCTAB *restrict const PT, const char *path, int tid) {
+    struct fdcache *fdc = PT->fdcache;
+    int *fd;
+
+    if (PT->piddir != -1 && !PT->piddir_kept)
+        close(PT->piddir);
+    PT->piddir = -1;
+    PT->piddir_kept = 0;
+    PT->fdslot = -1;
+
+    if (fdc && (PT->fdslot = fdcache_lookup(fdc, tid)) != -1) {
+        fd = &fdc->ents[PT->fdslot].fds[FDC_PIDDIR];
+        if (*fd == -1 && fdc->numfds < fdc->maxfds) {
+            if ((*fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1)
+                return -1;
+            RP_TALLY(opens, 1);
+            fdc->numfds++;
+        }
+        if (*fd != -1) {
+            PT->piddir_kept = 1;
+            return PT->piddir = *fd;
+        }
+    }
+    PT->piddir = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    RP_TALLY(opens, PT->piddir != -1);
+    return PT->piddir;
+}
+
+
+    // those /proc/#/status lines which status2proc must parse, given that
+    // some flags (and hide_kernel) imply additional keys beyond the caller's
+static inline unsigned status_keys (const PROCTAB *restrict const PT) {
+    unsigned keys = PT->statuskeys;
+
+    if (!keys)
+        return 0;
+    if (PT->hide_kernel && !(PT->flags & PROC_FILLSTAT))
+        keys |= PROC_STATUS_PPid;
+    if (PT->flags & (PROC_FILL_SUPGRP & ~PROC_FILLSTATUS))
+        keys |= PROC_STATUS_Groups;
+    if (PT->flags & (PROC_FILL_OUSERS & ~PROC_FILLSTATUS))
+        keys |= PROC_STATUS_Uid;
+    if (PT->flags & (PROC_FILL_OGROUPS & ~PROC_FILLSTATUS))
+        keys |= PROC_STATUS_Gid;
+    return keys;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////
 // This reads process info from /proc in the traditional way, for one process.
 // The pid (tgid? tid?) is already in p, and a path to it in path, with some
 // room to spare.
 static proc_t *simple_readproc(PROCTAB *restrict const PT, proc_t *restrict const p) {
-    static __thread struct utlbuf_s ub = { NULL, 0 };    // buf for stat,statm,status
     static __thread struct stat sb;     // stat() buffer
-    char *restrict const path = PT->path;
     unsigned flags = PT->flags;
-    int rc = 0;
+    unsigned long long beg;
+    int fd, rc = 0, retry = 0;
 
-    if (stat(path, &sb) == -1)                  /* no such dirent (anymore) */
+    // only stat's start_time can prove that the fds kept are still this tid's
+    if (PT->fdcache)
+        flags |= PROC_FILLSTAT;
+
+again:
+    if ((fd = piddir_open(PT, PT->path, p->tid)) == -1) /* no such dirent (anymore) */
+        goto next_proc;
+    if (fstat(fd, &sb) == -1)
         goto next_proc;
 
     if ((flags & PROC_UID) && !XinLN(uid_t, sb.st_uid, PT->uids, PT->nuid))
@@ -1133,29 +1699,43 @@ static proc_t *simple_readproc(PROCTAB *restrict const PT, proc_t *restrict cons
     p->egid = sb.st_gid;                        /* need a way to get real gid */
 
     if (flags & PROC_FILLSTAT) {                // read /proc/#/stat
-        if (file2str(path, "stat", &ub) == -1)
+        beg = rp_clock();
+        if (fdcache_file2str(PT, FDC_STAT, "stat", &proc_ub) == -1) {
+            if (PT->fdcache && PT->fdslot == -1 && !retry++) /* stale fds? */
+                goto again;
             goto next_proc;
-        rc += stat2proc(ub.buf, p);
+        }
+        rc += stat2proc(proc_ub.buf, p, PT->statfields);
+        rp_spent(RP_COST_STAT, beg);
+        fdcache_verify(PT, p);
+        // the caller may already hold everything else, from some prior scan
+        if (PT->unchanged && PT->unchanged(PT->unchanged_data, p))
+            goto wrap_up;
     }
 
     if (flags & PROC_FILLIO) {                  // read /proc/#/io
-        if (file2str(path, "io", &ub) != -1)
-            io2proc(ub.buf, p);
+        if (file2str(fd, "io", &proc_ub) != -1)
+            io2proc(proc_ub.buf, p);
     }
 
     if (flags & PROC_FILLSMAPS) {               // read /proc/#/smaps_rollup
-        if (file2str(path, "smaps_rollup", &ub) != -1)
-            smaps2proc(ub.buf, p);
+        beg = rp_clock();
+        if (file2str(fd, "smaps_rollup", &proc_ub) != -1)
+            smaps2proc(proc_ub.buf, p);
+        rp_spent(RP_COST_SMAPS, beg);
     }
 
     if (flags & PROC_FILLMEM) {                 // read /proc/#/statm
-        if (file2str(path, "statm", &ub) != -1)
-            statm2proc(ub.buf, p);
+        beg = rp_clock();
+        if (fdcache_file2str(PT, FDC_STATM, "statm", &proc_ub) != -1)
+            statm2proc(proc_ub.buf, p);
+        rp_spent(RP_COST_STATM, beg);
     }
 
     if (flags & PROC_FILLSTATUS) {              // read /proc/#/status
-        if (file2str(path, "status", &ub) != -1){
-            rc += status2proc(ub.buf, p, 1);
+        beg = rp_clock();
+        if (fdcache_file2str(PT, FDC_STATUS, "status", &proc_ub) != -1){
+            rc += status2proc(proc_ub.buf, p, 1, status_keys(PT));
             if (flags & (PROC_FILL_SUPGRP & ~PROC_FILLSTATUS))
                 rc += supgrps_from_supgids(p);
             if (flags & (PROC_FILL_OUSERS & ~PROC_FILLSTATUS)) {
@@ -1169,6 +1749,14 @@ static proc_t *simple_readproc(PROCTAB *restrict const PT, proc_t *restrict cons
                 p->fgroup = pwcache_get_group(p->fgid);
             }
         }
+        rp_spent(RP_COST_STATUS, beg);
+    }
+
+    if (flags & PROC_FILLWCHAN) {               // read /proc/#/wchan
+        if (fdcache_file2str(PT, FDC_WCHAN, "wchan", &proc_ub) != -1)
+            p->wchan_name = lookup_wchan_str(proc_ub.buf);
+        else
+            p->wchan_name = "?";
     }
 
     // if multithreaded, some values are crap
@@ -1182,52 +1770,55 @@ static proc_t *simple_readproc(PROCTAB *restrict const PT, proc_t *restrict cons
     if (flags & PROC_FILLGRP)
         p->egroup = pwcache_get_group(p->egid);
 
+    beg = rp_clock();
     if (flags & PROC_FILLENV)                   // read /proc/#/environ
-        if (!(p->environ_v = file2strvec(path, "environ")))
+        if (!(p->environ_v = file2strvec(fd, "environ")))
             rc += vectorize_dash_rc(&p->environ_v);
     if (flags & PROC_EDITENVRCVT)
-        rc += fill_environ_cvt(path, p);
+        rc += fill_environ_cvt(fd, p);
 
     if (flags & PROC_FILLARG)                   // read /proc/#/cmdline
-        if (!(p->cmdline_v = file2strvec(path, "cmdline")))
+        if (!(p->cmdline_v = file2strvec(fd, "cmdline")))
             rc += vectorize_dash_rc(&p->cmdline_v);
     if (flags & PROC_EDITCMDLCVT)
-        rc += fill_cmdline_cvt(path, p);
+        rc += fill_cmdline_cvt(fd, p);
 
     if ((flags & PROC_FILLCGROUP))              // read /proc/#/cgroup
-        if (!(p->cgroup_v = file2strvec(path, "cgroup")))
+        if (!(p->cgroup_v = file2strvec(fd, "cgroup")))
             rc += vectorize_dash_rc(&p->cgroup_v);
     if (flags & PROC_EDITCGRPCVT)
-        rc += fill_cgroup_cvt(path, p);
+        rc += fill_cgroup_cvt(fd, p);
+    rp_spent(RP_COST_VECTORS, beg);
 
     if (flags & PROC_FILLOOM) {
-        if (file2str(path, "oom_score", &ub) != -1)
-            oomscore2proc(ub.buf, p);
-        if (file2str(path, "oom_score_adj", &ub) != -1)
-            oomadj2proc(ub.buf, p);
+        if (file2str(fd, "oom_score", &proc_ub) != -1)
+            oomscore2proc(proc_ub.buf, p);
+        if (file2str(fd, "oom_score_adj", &proc_ub) != -1)
+            oomadj2proc(proc_ub.buf, p);
     }
 
     if (flags & PROC_FILLNS)                    // read /proc/#/ns/*
-        procps_ns_read_pid(p->tid, &(p->ns));
+        ns2proc(PT, p);
 
 
     if (flags & PROC_FILLSYSTEMD)               // get sd-login.h stuff
         rc += sd2proc(p);
 
     if (flags & PROC_FILL_LXC)                  // value the lxc name
-        p->lxcname = lxc_containers(path);
+        p->lxcname = lxc_containers(fd);
 
     if (flags & PROC_FILL_LUID)                 // value the login user id
-        p->luid = login_uid(path);
+        p->luid = login_uid(fd);
 
     if (flags & PROC_FILL_EXE) {
-        if (!(p->exe = readlink_exe(path)))
+        if (!(p->exe = readlink_exe(fd)))
             rc += 1;
     }
 
     if (flags & PROC_FILLAUTOGRP)               // value the 2 autogroup fields
-        autogroup_fill(path, p);
+        autogroup_fill(fd, p);
 
+wrap_up:
     // openproc() ensured that a ppid will be present when needed ...
     if (rc == 0) {
         if (PT->hide_kernel && (p->ppid == 2 || p->tid == 2)) {
@@ -1247,12 +1838,19 @@ next_proc:
 // t is the POSIX thread  (task group member, generally not the leader)
 // path is a path to the task, with some room to spare.
 static proc_t *simple_readtask(PROCTAB *restrict const PT, proc_t *restrict const t, char *restrict const path) {
-    static __thread struct utlbuf_s ub = { NULL, 0 };    // buf for stat,statm,status
     static __thread struct stat sb;     // stat() buffer
     unsigned flags = PT->flags;
-    int rc = 0;
+    unsigned long long beg;
+    int fd, rc = 0, retry = 0;
 
-    if (stat(path, &sb) == -1)                  /* no such dirent (anymore) */
+    // only stat's start_time can prove that the fds kept are still this tid's
+    if (PT->fdcache)
+        flags |= PROC_FILLSTAT;
+
+again:
+    if ((fd = piddir_open(PT, path, t->tid)) == -1) /* no such dirent (anymore) */
+        goto next_task;
+    if (fstat(fd, &sb) == -1)
         goto next_task;
 
 //  if ((flags & PROC_UID) && !XinLN(uid_t, sb.st_uid, PT->uids, PT->nuid))
@@ -1262,29 +1860,43 @@ static proc_t *simple_readtask(PROCTAB *restrict const PT, proc_t *restrict cons
     t->egid = sb.st_gid;                        /* need a way to get real gid */
 
     if (flags & PROC_FILLSTAT) {                // read /proc/#/task/#/stat
-        if (file2str(path, "stat", &ub) == -1)
+        beg = rp_clock();
+        if (fdcache_file2str(PT, FDC_STAT, "stat", &task_ub) == -1) {
+            if (PT->fdcache && PT->fdslot == -1 && !retry++) /* stale fds? */
+                goto again;
             goto next_task;
-        rc += stat2proc(ub.buf, t);
+        }
+        rc += stat2proc(task_ub.buf, t, PT->statfields);
+        rp_spent(RP_COST_STAT, beg);
+        fdcache_verify(PT, t);
+        // the caller may already hold everything else, from some prior scan
+        if (PT->unchanged && PT->unchanged(PT->unchanged_data, t))
+            goto wrap_up;
     }
 
     if (flags & PROC_FILLIO) {                  // read /proc/#/task/#/io
-        if (file2str(path, "io", &ub) != -1)
-            io2proc(ub.buf, t);
+        if (file2str(fd, "io", &task_ub) != -1)
+            io2proc(task_ub.buf, t);
     }
 
     if (flags & PROC_FILLSMAPS) {               // read /proc/#/task/#/smaps_rollup
-        if (file2str(path, "smaps_rollup", &ub) != -1)
-            smaps2proc(ub.buf, t);
+        beg = rp_clock();
+        if (file2str(fd, "smaps_rollup", &task_ub) != -1)
+            smaps2proc(task_ub.buf, t);
+        rp_spent(RP_COST_SMAPS, beg);
     }
 
     if (flags & PROC_FILLMEM) {                 // read /proc/#/task/#/statm
-        if (file2str(path, "statm", &ub) != -1)
-            statm2proc(ub.buf, t);
+        beg = rp_clock();
+        if (fdcache_file2str(PT, FDC_STATM, "statm", &task_ub) != -1)
+            statm2proc(task_ub.buf, t);
+        rp_spent(RP_COST_STATM, beg);
     }
 
     if (flags & PROC_FILLSTATUS) {              // read /proc/#/task/#/status
-        if (file2str(path, "status", &ub) != -1) {
-            rc += status2proc(ub.buf, t, 0);
+        beg = rp_clock();
+        if (fdcache_file2str(PT, FDC_STATUS, "status", &task_ub) != -1) {
+            rc += status2proc(task_ub.buf, t, 0, status_keys(PT));
             if (flags & (PROC_FILL_SUPGRP & ~PROC_FILLSTATUS))
                 rc += supgrps_from_supgids(t);
             if (flags & (PROC_FILL_OUSERS & ~PROC_FILLSTATUS)) {
@@ -1298,6 +1910,14 @@ static proc_t *simple_readtask(PROCTAB *restrict const PT, proc_t *restrict cons
                 t->fgroup = pwcache_get_group(t->fgid);
             }
         }
+        rp_spent(RP_COST_STATUS, beg);
+    }
+
+    if (flags & PROC_FILLWCHAN) {               // read /proc/#/task/#/wchan
+        if (fdcache_file2str(PT, FDC_WCHAN, "wchan", &task_ub) != -1)
+            t->wchan_name = lookup_wchan_str(task_ub.buf);
+        else
+            t->wchan_name = "?";
     }
 
     /* some number->text resolving which is time consuming */
@@ -1310,29 +1930,31 @@ static proc_t *simple_readtask(PROCTAB *restrict const PT, proc_t *restrict cons
 #ifdef FALSE_THREADS
     if (!IS_THREAD(t)) {
 #endif
+    beg = rp_clock();
     if (flags & PROC_FILLARG)                   // read /proc/#/task/#/cmdline
-        if (!(t->cmdline_v = file2strvec(path, "cmdline")))
+        if (!(t->cmdline_v = file2strvec(fd, "cmdline")))
             rc += vectorize_dash_rc(&t->cmdline_v);
     if (flags & PROC_EDITCMDLCVT)
-        rc += fill_cmdline_cvt(path, t);
+        rc += fill_cmdline_cvt(fd, t);
 
     if (flags & PROC_FILLENV)                   // read /proc/#/task/#/environ
-        if (!(t->environ_v = file2strvec(path, "environ")))
+        if (!(t->environ_v = file2strvec(fd, "environ")))
             rc += vectorize_dash_rc(&t->environ_v);
     if (flags & PROC_EDITENVRCVT)
-        rc += fill_environ_cvt(path, t);
+        rc += fill_environ_cvt(fd, t);
 
     if ((flags & PROC_FILLCGROUP))              // read /proc/#/task/#/cgroup
-        if (!(t->cgroup_v = file2strvec(path, "cgroup")))
+        if (!(t->cgroup_v = file2strvec(fd, "cgroup")))
             rc += vectorize_dash_rc(&t->cgroup_v);
     if (flags & PROC_EDITCGRPCVT)
-        rc += fill_cgroup_cvt(path, t);
+        rc += fill_cgroup_cvt(fd, t);
+    rp_spent(RP_COST_VECTORS, beg);
 
     if (flags & PROC_FILLSYSTEMD)               // get sd-login.h stuff
         rc += sd2proc(t);
 
     if (flags & PROC_FILL_EXE) {
-        if (!(t->exe = readlink_exe(path)))
+        if (!(t->exe = readlink_exe(fd)))
             rc += 1;
     }
 #ifdef FALSE_THREADS
@@ -1340,23 +1962,24 @@ static proc_t *simple_readtask(PROCTAB *restrict const PT, proc_t *restrict cons
 #endif
 
     if (flags & PROC_FILLOOM) {
-        if (file2str(path, "oom_score", &ub) != -1)
-            oomscore2proc(ub.buf, t);
-        if (file2str(path, "oom_score_adj", &ub) != -1)
-            oomadj2proc(ub.buf, t);
+        if (file2str(fd, "oom_score", &task_ub) != -1)
+            oomscore2proc(task_ub.buf, t);
+        if (file2str(fd, "oom_score_adj", &task_ub) != -1)
+            oomadj2proc(task_ub.buf, t);
     }
     if (flags & PROC_FILLNS)                    // read /proc/#/task/#/ns/*
-        procps_ns_read_pid(t->tid, &(t->ns));
+        ns2proc(PT, t);
 
     if (flags & PROC_FILL_LXC)
-        t->lxcname = lxc_containers(path);
+        t->lxcname = lxc_containers(fd);
 
     if (flags & PROC_FILL_LUID)
-        t->luid = login_uid(path);
+        t->luid = login_uid(fd);
 
     if (flags & PROC_FILLAUTOGRP)               // value the 2 autogroup fields
-        autogroup_fill(path, t);
+        autogroup_fill(fd, t);
 
+wrap_up:
     if (rc == 0) return t;
     errno = ENOMEM;
 next_task:
@@ -1365,25 +1988,102 @@ next_task:
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// This finds processes in /proc in the traditional way.
-// Return non-zero on success.
-static int simple_nextpid(PROCTAB *restrict const PT, proc_t *restrict const p) {
-    static __thread struct dirent *ent;   /* dirent handle */
-    char *restrict const path = PT->path;
+// pidscan -- getdents64 in bulk, rather than a readdir + strtoul per dirent
+
+#define SCAN_BUFSIZ  (32 * 1024)
+
+struct scan_dirent64 {                  // the kernel's linux_dirent64
+    uint64_t       d_ino;
+    int64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+
+int pidscan_open (struct pidscan *ps, const char *path) {
+    ps->pos = ps->end = 0;
+    if (!ps->buf && !(ps->buf = malloc(SCAN_BUFSIZ))) {
+        ps->fd = -1;
+        return -1;
+    }
+    ps->fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return ps->fd;
+}
+
+
+int pidscan_next (struct pidscan *ps, const char **name) {
+    struct scan_dirent64 *ent;
+    const char *cp;
+    unsigned long pid;
+    int num;
+
+    if (ps->fd == -1)
+        return 0;
     for (;;) {
-        ent = readdir(PT->procfs);
-        if (!ent || !ent->d_name[0]) break;
-        if (*ent->d_name > '0' && *ent->d_name <= '9') {
-            errno = 0;
-            p->tgid = strtoul(ent->d_name, NULL, 10);
-            if (errno == 0) {
-                p->tid = p->tgid;
-                snprintf(path, PROCPATHLEN, "/proc/%d", p->tgid);
-                return 1;
-            }
+        if (ps->pos >= ps->end) {
+            num = syscall(SYS_getdents64, ps->fd, ps->buf, SCAN_BUFSIZ);
+            if (num <= 0)
+                return 0;
+            ps->pos = 0;
+            ps->end = num;
         }
+        ent = (struct scan_dirent64 *)(ps->buf + ps->pos);
+        ps->pos += ent->d_reclen;
+        cp = ent->d_name;
+        // the many "." + "..", "self", "sys", etc. fail on their 1st byte
+        if (*cp <= '0' || *cp > '9')
+            continue;
+        for (pid = 0; *cp >= '0' && *cp <= '9' && pid <= INT_MAX; cp++)
+            pid = pid * 10 + (*cp - '0');
+        if (*cp || pid > INT_MAX)
+            continue;
+        if (name)
+            *name = ent->d_name;
+        return (int)pid;
     }
-    return 0;
+}
+
+
+void pidscan_close (struct pidscan *ps) {
+    if (ps->fd != -1)
+        close(ps->fd);
+    ps->fd = -1;
+    free(ps->buf);
+    ps->buf = NULL;
+}
+
+
+int pidscan_count (const char *path) {
+    struct pidscan ps = { -1, 0, 0, NULL };
+    int n = 0;
+
+    if (pidscan_open(&ps, path) == -1) {
+        pidscan_close(&ps);
+        return -1;
+    }
+    while (pidscan_next(&ps, NULL))
+        n++;
+    pidscan_close(&ps);
+    return n;
+}
+
+#undef SCAN_BUFSIZ
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// This finds processes in /proc in the traditional way.
+// Return non-zero on success.
+static int simple_nextpid(PROCTAB *restrict const PT, proc_t *restrict const p) {
+    const char *name;
+
+    if (!(p->tgid = pidscan_next(&PT->procfs, &name)))
+        return 0;
+    p->tid = p->tgid;
+    // that name is already the decimal pid, so there's no need for snprintf
+    memcpy(PT->path, PT->procpath, PT->procpathlen);
+    strcpy(PT->path + PT->procpathlen, name);
+    return 1;
 }
 
 
@@ -1391,26 +2091,23 @@ static int simple_nextpid(PROCTAB *restrict const PT, proc_t *restrict const p)
 // This finds tasks in /proc/*/task/ in the traditional way.
 // Return non-zero on success.
 static int simple_nexttid(PROCTAB *restrict const PT, const proc_t *restrict const p, proc_t *restrict const t, char *restrict const path) {
-  static __thread struct dirent *ent;   /* dirent handle */
+  const char *name;
   if(PT->taskdir_user != p->tgid){
-    if(PT->taskdir){
-      closedir(PT->taskdir);
+    if(PT->taskdir.fd != -1){
+      close(PT->taskdir.fd);
+      PT->taskdir.fd = -1;
     }
-    // use "path" as some tmp space
-    snprintf(path, PROCPATHLEN, "/proc/%d/task", p->tgid);
-    PT->taskdir = opendir(path);
-    if(!PT->taskdir) return 0;
+    PT->taskpathlen = snprintf(PT->taskpath, PROCPATHLEN, "%s%d/task/", PT->procpath, p->tgid);
+    if(pidscan_open(&PT->taskdir, PT->taskpath) == -1) return 0;
+    RP_TALLY(opens, 1);
     PT->taskdir_user = p->tgid;
   }
-  for (;;) {
-    ent = readdir(PT->taskdir);
-    if(!ent || !ent->d_name[0]) return 0;
-    if(*ent->d_name > '0' && *ent->d_name <= '9') break;
-  }
-  t->tid = strtoul(ent->d_name, NULL, 10);
+  if(!(t->tid = pidscan_next(&PT->taskdir, &name))) return 0;
   t->tgid = p->tgid;
 //t->ppid = p->ppid;  // cover for kernel behavior? we want both actually...?
-  snprintf(path, PROCPATHLEN, "/proc/%d/task/%.10s", p->tgid, ent->d_name);
+  // pidscan_next assures us that name is at most 10 digits
+  memcpy(path, PT->taskpath, PT->taskpathlen);
+  strcpy(path + PT->taskpathlen, name);
   return 1;
 }
 
@@ -1419,12 +2116,12 @@ static int simple_nexttid(PROCTAB *restrict const PT, const proc_t *restrict con
 // This "finds" processes in a list that was given to openproc().
 // Return non-zero on success. (tgid is a real headache)
 static int listed_nextpid (PROCTAB *PT, proc_t *p) {
-  static __thread struct utlbuf_s ub = { NULL, 0 };
   pid_t pid = *(PT->pids)++;
   char *path = PT->path;
 
   if (pid) {
-    snprintf(path, PROCPATHLEN, "/proc/%d", pid);
+    memcpy(path, PT->procpath, PT->procpathlen);
+    sprintf(path + PT->procpathlen, "%d", pid);
     p->tid = p->tgid = pid;        // this tgid may be a huge fib |
 
     /* the 'status' directory is the only place where we find the |
@@ -1432,8 +2129,9 @@ static int listed_nextpid (PROCTAB *PT, proc_t *p) {
        dealing with fewer processes, unlike the other 'next' guys |
        (plus we need not parse the whole thing like status2proc)! | */
 
-    if (file2str(path, "status", &ub) != -1) {
-      char *str = strstr(ub.buf, "Tgid:");
+    if (piddir_open(PT, path, pid) != -1
+    && (file2str(PT->piddir, "status", &listed_ub) != -1)) {
+      char *str = strstr(listed_ub.buf, "Tgid:");
       if (str)
         p->tgid = atoi(str + 5);   // this tgid is the proper one |
     }
@@ -1442,6 +2140,21 @@ static int listed_nextpid (PROCTAB *PT, proc_t *p) {
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////
+// This "finds" processes in a list that was itself just obtained from a
+// readdir of /proc (see PROC_PIDSCAN), so each is known to be a tgid.
+static int scanned_nextpid (PROCTAB *PT, proc_t *p) {
+  pid_t pid = *(PT->pids)++;
+
+  if (pid) {
+    memcpy(PT->path, PT->procpath, PT->procpathlen);
+    sprintf(PT->path + PT->procpathlen, "%d", pid);
+    p->tid = p->tgid = pid;
+  }
+  return pid;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////
 /* readproc: return a pointer to a proc_t filled with requested info about the
  * next process available matching the restriction set.  If no more such
@@ -1456,6 +2169,7 @@ static int listed_nextpid (PROCTAB *PT, proc_t *p) {
 proc_t *readproc(PROCTAB *restrict const PT, proc_t *restrict p) {
   proc_t *ret;
 
+  rp_begin(PT);
   free_acquired(p);
 
   for(;;){
@@ -1484,6 +2198,7 @@ proc_t *readeither (PROCTAB *restrict const PT, proc_t *restrict x) {
     char path[PROCPATHLEN];
     proc_t *ret;
 
+    rp_begin(PT);
     free_acquired(x);
 
     if (new_p) {
@@ -1536,22 +2251,31 @@ PROCTAB *openproc(unsigned flags, ...) {
         return NULL;
     if (hide_kernel < 0)
         hide_kernel = (NULL != getenv("LIBPROC_HIDE_KERNEL"));
+    PT->procpathlen = procps_rootf(PT->procpath, PROCPATHLEN, "/proc/");
     if (!did_stat){
-        task_dir_missing = stat("/proc/self/task", &sbuf);
+        char path[PROCPATHLEN];
+
+        procps_rootf(path, sizeof(path), "/proc/self/task");
+        task_dir_missing = stat(path, &sbuf);
         did_stat = 1;
     }
-    PT->taskdir = NULL;
+    PT->procfs.fd = -1;
+    PT->taskdir.fd = -1;
     PT->taskdir_user = -1;
+    PT->piddir = -1;
+    PT->fdslot = -1;
     PT->taskfinder = simple_nexttid;
     PT->taskreader = simple_readtask;
 
     PT->reader = simple_readproc;
     if (flags & PROC_PID){
-        PT->procfs = NULL;
-        PT->finder = listed_nextpid;
+        PT->finder = (flags & PROC_PIDSCAN) ? scanned_nextpid : listed_nextpid;
     }else{
-        PT->procfs = opendir("/proc");
-        if (!PT->procfs) { free(PT); return NULL; }
+        if (pidscan_open(&PT->procfs, PT->procpath) == -1) {
+            pidscan_close(&PT->procfs);
+            free(PT);
+            return NULL;
+        }
         PT->finder = simple_nextpid;
     }
     PT->flags = flags;
@@ -1574,14 +2298,15 @@ PROCTAB *openproc(unsigned flags, ...) {
 
     if (!src_buffer
     && !(src_buffer = malloc(MAX_BUFSZ))) {
-        closedir(PT->procfs);
+        pidscan_close(&PT->procfs);
         free(PT);
         return NULL;
     }
     if (!dst_buffer
     && !(dst_buffer = malloc(MAX_BUFSZ))) {
-        closedir(PT->procfs);
+        pidscan_close(&PT->procfs);
         free(src_buffer);
+        src_buffer = NULL;
         free(PT);
         return NULL;
     }
@@ -1593,24 +2318,54 @@ PROCTAB *openproc(unsigned flags, ...) {
 // terminate a process table scan
 void closeproc(PROCTAB *PT) {
     if (PT){
-        if (PT->procfs) closedir(PT->procfs);
-        if (PT->taskdir) closedir(PT->taskdir);
+        pidscan_close(&PT->procfs);
+        pidscan_close(&PT->taskdir);
+        if (PT->piddir != -1 && !PT->piddir_kept) close(PT->piddir);
         memset(PT,'#',sizeof(PROCTAB));
         free(PT);
     }
 }
 
 
+// release this thread's buffers (and lxc names), before it exits
+void readproc_thread_free(void) {
+    struct lxc_ele *ele;
+
+    free(src_buffer);
+    free(dst_buffer);
+    src_buffer = dst_buffer = NULL;
+    free(strvec_ub.buf);
+    free(lxc_ub.buf);
+    free(proc_ub.buf);
+    free(task_ub.buf);
+    free(listed_ub.buf);
+    memset(&strvec_ub, 0, sizeof(struct utlbuf_s));
+    memset(&lxc_ub, 0, sizeof(struct utlbuf_s));
+    memset(&proc_ub, 0, sizeof(struct utlbuf_s));
+    memset(&task_ub, 0, sizeof(struct utlbuf_s));
+    memset(&listed_ub, 0, sizeof(struct utlbuf_s));
+    while ((ele = lxc_names)) {
+        lxc_names = ele->next;
+        free(ele->name);
+        free(ele);
+    }
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////
 int look_up_our_self(proc_t *p) {
     struct utlbuf_s ub = { NULL, 0 };
+    char path[PROCPATHLEN];
     int rc = 0;
 
-    if(file2str("/proc/self", "stat", &ub) == -1){
+    procps_rootf(path, sizeof(path), "/proc/self/stat");
+    rp_tally = NULL;            // nor is this read any reap's cost
+    if(file2str(AT_FDCWD, path, &ub) == -1){
         fprintf(stderr, "Error, do this: mount -t proc proc /proc\n");
         _exit(47);
     }
-    rc = stat2proc(ub.buf, p);  // parse /proc/self/stat
+    str_arena = NULL;           // this cmd is the caller's to free
+    rc = stat2proc(ub.buf, p, 0);  // parse /proc/self/stat
     free(ub.buf);
     return !rc;
 }
@@ -14,6 +14,7 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <proc/misc.h>
+#include <proc/procps-private.h>
 
 // the following is development only, forcing display of "[ duplicate ENUM ]" strings
 // #define FALSE_THREADS        /* set most child string fields to NULL */
@@ -177,6 +178,8 @@ typedef struct proc_t {
     char
         *lxcname,       // n/a             lxc container name
         *exe;           // exe             executable path + name
+    const char
+        *wchan_name;    // wchan           kernel wait channel name (shared)
     int
         luid,           // loginuid        user id at login
         autogrp_id,     // autogroup       autogroup number (id)
@@ -187,14 +190,47 @@ typedef struct proc_t {
 // from openproc().  The setup is intentionally similar to the dirent interface
 // and other system table interfaces (utmp+wtmp come to mind).
 
-#define PROCPATHLEN 64  // must hold /proc/2000222000/task/2000222000/cmdline
+#define PROCPATHLEN (PROCPS_ROOTMAX + 64)  // must hold <root>/proc/2000222000/task/2000222000/cmdline
+
+struct fdcache;         // optional, outlives any PROCTAB (see fdcache_new)
+struct strarena;        // optional, outlives any PROCTAB (see strarena_new)
+
+// What reading tasks has cost, accumulated in whatever PROCTAB.tally points
+// to (when it's not NULL).  Each file's nsecs are for its read plus parse.
+enum rp_cost {
+    RP_COST_STAT, RP_COST_STATUS, RP_COST_STATM, RP_COST_SMAPS,
+    RP_COST_VECTORS,    // cmdline, environ and cgroup
+    RP_COST_count
+};
+struct readproc_tally {
+    unsigned long long opens;           // files and directories opened
+    unsigned long long reads;           // read (or pread) calls made
+    unsigned long long bytes;           // bytes which those returned
+    unsigned long long allocs;          // buffers malloc'd or grown
+    unsigned long long pw_hits;         // user/group names from pwcache
+    unsigned long long pw_misses;       // user/group names needing NSS
+    unsigned long long nsecs[RP_COST_count];
+};
+
+// A pidscan reads some /proc (or /proc/#/task) directory with getdents64,
+// yielding only those entries with numeric names.
+struct pidscan {
+    int         fd;     // the directory (or -1 when not open)
+    int         pos;    // offset of the next dirent within buf
+    int         end;    // number of bytes now in buf
+    char       *buf;    // raw dirents, as the kernel returned them
+};
 
 typedef struct PROCTAB {
-    DIR        *procfs;
+    struct pidscan procfs;
 //    char deBug0[64];
-    DIR        *taskdir;  // for threads
+    struct pidscan taskdir;  // for threads
 //    char deBug1[64];
     pid_t       taskdir_user;  // for threads
+    char        procpath[PROCPATHLEN];  // the "<root>/proc/" for all the paths
+    unsigned    procpathlen;   // length of string in the above
+    char        taskpath[PROCPATHLEN];  // the "<root>/proc/#/task/" for the above
+    unsigned    taskpathlen;   // length of string in the above
     int(*finder)(struct PROCTAB *__restrict const, proc_t *__restrict const);
     proc_t*(*reader)(struct PROCTAB *__restrict const, proc_t *__restrict const);
     int(*taskfinder)(struct PROCTAB *__restrict const, const proc_t *__restrict const, proc_t *__restrict const, char *__restrict const);
@@ -207,8 +243,19 @@ typedef struct PROCTAB {
     unsigned    flags;
     unsigned    u;  // generic
     void *      vp; // generic
-    char        path[PROCPATHLEN];  // must hold /proc/2000222000/task/2000222000/cmdline
+    char        path[PROCPATHLEN];  // must hold <root>/proc/2000222000/task/2000222000/cmdline
     unsigned pathlen;        // length of string in the above (w/o '\0')
+    int         piddir;      // O_DIRECTORY fd for the process/task now being read
+    int         piddir_kept; // the above belongs to the fdcache, not to us
+    struct fdcache *fdcache; // when non-NULL, retains fds from scan to scan
+    int         fdslot;      // the fdcache entry for the process/task (or -1)
+    unsigned    statuskeys;  // PROC_STATUS_xxx lines to parse (zero means all)
+    unsigned long long statfields; // PROC_STAT_xxx fields to convert (0 = all)
+    unsigned    nsfields;    // 1 << PROCPS_NS_xxx namespaces to read (0 = all)
+    int       (*unchanged)(void *, const proc_t *); // true skips all but stat
+    void       *unchanged_data;  // passed to the above
+    struct strarena *strarena;   // when non-NULL, the source of most strings
+    struct readproc_tally *tally; // when non-NULL, what reading has cost
 } PROCTAB;
 
 
@@ -259,6 +306,85 @@ typedef struct PROCTAB {
 
 // and let's put new flags here ...
 #define PROC_FILLAUTOGRP     0x01000000 // fill in proc_t autogroup stuff
+#define PROC_PIDSCAN         0x02000000 // with PROC_PID, those came from /proc
+#define PROC_FILLWCHAN       0x04000000 // fill in proc_t wchan_name
+
+// PROCTAB.statuskeys, those /proc/#/status lines of interest (when non-zero,
+// the other lines are skipped and parsing ends once all of these were seen)
+#define PROC_STATUS_Name     0x00000001
+#define PROC_STATUS_State    0x00000002
+#define PROC_STATUS_Tgid     0x00000004
+#define PROC_STATUS_Pid      0x00000008
+#define PROC_STATUS_PPid     0x00000010
+#define PROC_STATUS_Uid      0x00000020
+#define PROC_STATUS_Gid      0x00000040
+#define PROC_STATUS_Groups   0x00000080
+#define PROC_STATUS_VmSize   0x00000100
+#define PROC_STATUS_VmLck    0x00000200
+#define PROC_STATUS_VmRSS    0x00000400
+#define PROC_STATUS_RssAnon  0x00000800
+#define PROC_STATUS_RssFile  0x00001000
+#define PROC_STATUS_RssShmem 0x00002000
+#define PROC_STATUS_VmData   0x00004000
+#define PROC_STATUS_VmStk    0x00008000
+#define PROC_STATUS_VmExe    0x00010000
+#define PROC_STATUS_VmLib    0x00020000
+#define PROC_STATUS_VmSwap   0x00040000
+#define PROC_STATUS_Threads  0x00080000
+#define PROC_STATUS_SigPnd   0x00100000
+#define PROC_STATUS_ShdPnd   0x00200000
+#define PROC_STATUS_SigBlk   0x00400000
+#define PROC_STATUS_SigIgn   0x00800000
+#define PROC_STATUS_SigCgt   0x01000000
+// the tid, tgid and nlwp must be derived from all three of these
+#define PROC_STATUS_IDS    ( PROC_STATUS_Tgid | PROC_STATUS_Pid | PROC_STATUS_Threads )
+#define PROC_STATUS_SIGS   ( PROC_STATUS_SigPnd | PROC_STATUS_ShdPnd | PROC_STATUS_SigBlk \
+                           | PROC_STATUS_SigIgn | PROC_STATUS_SigCgt )
+
+// PROCTAB.statfields, those /proc/#/stat fields to be converted (when non-zero,
+// the others are skipped, save the PROC_STAT_BASE fields which readproc and
+// pids.c rely upon).  Each bit is the field's position, counted from state.
+#define PROC_STAT_state        (1ULL <<  0)
+#define PROC_STAT_ppid         (1ULL <<  1)
+#define PROC_STAT_pgrp         (1ULL <<  2)
+#define PROC_STAT_session      (1ULL <<  3)
+#define PROC_STAT_tty          (1ULL <<  4)
+#define PROC_STAT_tpgid        (1ULL <<  5)
+#define PROC_STAT_flags        (1ULL <<  6)
+#define PROC_STAT_min_flt      (1ULL <<  7)
+#define PROC_STAT_cmin_flt     (1ULL <<  8)
+#define PROC_STAT_maj_flt      (1ULL <<  9)
+#define PROC_STAT_cmaj_flt     (1ULL << 10)
+#define PROC_STAT_utime        (1ULL << 11)
+#define PROC_STAT_stime        (1ULL << 12)
+#define PROC_STAT_cutime       (1ULL << 13)
+#define PROC_STAT_cstime       (1ULL << 14)
+#define PROC_STAT_priority     (1ULL << 15)
+#define PROC_STAT_nice         (1ULL << 16)
+#define PROC_STAT_nlwp         (1ULL << 17)
+#define PROC_STAT_alarm        (1ULL << 18)
+#define PROC_STAT_start_time   (1ULL << 19)
+#define PROC_STAT_vsize        (1ULL << 20)
+#define PROC_STAT_rss          (1ULL << 21)
+#define PROC_STAT_rss_rlim     (1ULL << 22)
+#define PROC_STAT_start_code   (1ULL << 23)
+#define PROC_STAT_end_code     (1ULL << 24)
+#define PROC_STAT_start_stack  (1ULL << 25)
+#define PROC_STAT_kstk_esp     (1ULL << 26)
+#define PROC_STAT_kstk_eip     (1ULL << 27)
+#define PROC_STAT_wchan        (1ULL << 32)
+#define PROC_STAT_exit_signal  (1ULL << 35)
+#define PROC_STAT_processor    (1ULL << 36)
+#define PROC_STAT_rtprio       (1ULL << 37)
+#define PROC_STAT_sched        (1ULL << 38)
+#define PROC_STAT_blkio_tics   (1ULL << 39)
+#define PROC_STAT_gtime        (1ULL << 40)
+#define PROC_STAT_cgtime       (1ULL << 41)
+// used by history, the task tallies, hide_kernel, fdcache and incremental reaps
+#define PROC_STAT_BASE     ( PROC_STAT_state | PROC_STAT_ppid | PROC_STAT_min_flt \
+                           | PROC_STAT_maj_flt | PROC_STAT_utime | PROC_STAT_stime \
+                           | PROC_STAT_nlwp | PROC_STAT_start_time | PROC_STAT_vsize \
+                           | PROC_STAT_rss )
 
 // it helps to give app code a few spare bits
 #define PROC_SPARE_1         0x10000000
@@ -283,6 +409,47 @@ proc_t *readproc(PROCTAB *__restrict const PT, proc_t *__restrict p);
 proc_t *readeither(PROCTAB *__restrict const PT, proc_t *__restrict x);
 int look_up_our_self(proc_t *p);
 void closeproc(PROCTAB *PT);
+// A thread other than the first must call this before it exits, else the
+// buffers that readproc keeps for it are lost.
+void readproc_thread_free(void);
 char **vectorize_this_str(const char *src);
 
+// An fdcache keeps the /proc/#, stat, statm, status and wchan fds open across
+// many openproc/closeproc cycles, within a budget of 'maxfds' descriptors.  Once
+// assigned to PROCTAB.fdcache, those files are re-read with a pread() at
+// offset zero.  After each complete scan, fdcache_sweep() must be called to
+// close the fds of any tasks which were not seen (ie. have since exited).
+// With 'keepns', each task's namespaces are also remembered and read just
+// once for a given tid and start_time (so PROC_FILLSTAT is then required).
+// Such a cache can be had with a 'maxfds' of zero, in which case no fds are
+// ever kept.
+struct fdcache *fdcache_new(int maxfds, int keepns);
+void fdcache_sweep(struct fdcache *fdc);
+void fdcache_free(struct fdcache *fdc);
+
+// A strarena supplies the strings otherwise strdup'd for every task of every
+// scan.  Once assigned to PROCTAB.strarena, readproc carves cmd, cmdline,
+// environ, cgroup and exe (plus those vectors) from it rather than malloc.
+// Such strings must never be free'd.  They remain valid until the second
+// strarena_flip() following their creation (that's one full scan later).
+struct strarena *strarena_new(void);
+void strarena_flip(struct strarena *sa);
+char *strarena_alloc(struct strarena *sa, size_t len);
+char *strarena_strdup(struct strarena *sa, const char *str);
+char **strarena_strvdup(struct strarena *sa, char **vec);
+int strarena_owns(const struct strarena *sa, const void *ptr);
+void strarena_free(struct strarena *sa);
+
+// The pidscan functions.  Where pidscan_next returns a pid (zero at the end)
+// then 'name' (when not NULL) points to that dirent's name, valid until the
+// next call.  A pidscan_count pass costs little beyond the getdents64 calls.
+int pidscan_open(struct pidscan *ps, const char *path);
+int pidscan_next(struct pidscan *ps, const char **name);
+void pidscan_close(struct pidscan *ps);
+int pidscan_count(const char *path);
+
+// In namespace.c, reads the 'want' namespaces (1 << PROCPS_NS_xxx) relative
+// to some /proc/# directory, zeroing the others, and returns the number found.
+int ns_read_at(int dirfd, unsigned want, struct procps_ns *nsp);
+
 #endif
@@ -0,0 +1,986 @@
+/*
+ * record.c - a file of successive reaps, and their later replay
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "procps-private.h"
+#include "record.h"
+#include "snapshot.h"
+#include "wchan.h"
+
+/*
+ * A recording is a header followed by frames, each holding one reap of the
+ * process table along with the contents of those few /proc files read by
+ * the other collections (stat, meminfo, vmstat, diskstats and slabinfo)
+ * or by procps_uptime and procps_loadavg.  Its tasks are in the format of
+ * a snapshot (see snapshot.c).  When the writer closes the file, an index
+ * of each frame's time and offset is appended and noted in the header.  A
+ * recording without one (its writer having died) is simply walked.
+ *
+ * Every REC_KEYINT'th frame is whole.  Each of the others is but a delta
+ * from its predecessor: an unchanged task is just its tid and an unchanged
+ * file is just a flag, while any other file is copied by line, with only
+ * those lines differing from the line in the same place before included. */
+
+#define REC_MAGIC     0x44524350u      // "PCRD"
+#define FRM_MAGIC     0x4d415246u      // "FRAM"
+#define REC_VERSION   1
+#define REC_KEYINT    64               // one whole frame per so many
+#define REC_ALIGN(n)  (((n) + 7) & ~(size_t)7)
+#define REC_RECSIZ    (sizeof(uint64_t) + sizeof(proc_t))
+
+    // the files, in the order each frame holds them
+static const char *rec_files[] = {
+    "/proc/stat", "/proc/meminfo", "/proc/vmstat", "/proc/diskstats",
+    "/proc/slabinfo", "/proc/uptime", "/proc/loadavg"
+};
+#define REC_NFILES  MAXTABLE(rec_files)
+
+enum rec_how { TXT_NONE, TXT_WHOLE, TXT_DELTA, TXT_SAME };
+
+struct rec_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t proc_size;                // sizeof(proc_t), which must agree
+    uint32_t nfiles;                   // files in each frame
+    uint64_t index;                    // offset of the index, if closed
+    uint64_t frames;                   // entries in that index
+};
+
+struct rec_frame {
+    uint32_t magic;
+    uint32_t key;                      // whole, rather than a delta
+    uint64_t len;                      // bytes, including this header
+    uint64_t when;                     // CLOCK_REALTIME nsecs (never less than before)
+    uint32_t threads;                  // threads were reaped too
+    uint32_t hidden;                   // kernel threads were omitted
+    uint32_t count;                    // tasks
+    uint32_t pad;
+};
+
+struct rec_text {                      // followed by len bytes, then alignment
+    uint32_t how;                      // an enum rec_how
+    uint32_t len;
+};
+
+struct rec_index {
+    uint64_t when;
+    uint64_t off;
+};
+
+struct rec_buf {
+    char *mem;
+    size_t len;
+    size_t siz;
+};
+
+struct rec_tid {
+    int tid;
+    size_t off;                        // a record's place in the tasks below
+};
+
+    // what one frame holds, once whole
+struct rec_state {
+    struct rec_buf text[REC_NFILES];
+    int have[REC_NFILES];              // some file could not be read
+    struct rec_buf tasks;              // the records, one after another
+    unsigned count;                    // number of the above
+    struct rec_tid *tids;              // the above, ordered by tid
+    unsigned tids_siz;                 // entries allocated for the above
+};
+
+struct recording {
+    int fd;
+    struct rec_buf out;                // the frame being written
+    struct rec_state st[2];            // the current frame and the prior one
+    int cur;                           // which of the above is current
+    uint64_t when;                     // the prior frame's time
+    struct rec_index *index;           // each frame's time and offset
+    uint64_t frames;                   // entries in the above
+    uint64_t index_siz;                // entries allocated for the above
+    uint64_t at;                       // offset of the next frame
+    int failed;                        // some partial frame remains
+};
+
+struct replay {
+    char *map;                         // the whole recording, as mapped
+    size_t mapped;                     // bytes in the above
+    struct rec_index *index;           // each frame's time and offset
+    uint64_t frames;                   // entries in the above
+    struct rec_state st[2];            // the current frame and the prior one
+    int cur;                           // which of the above is current
+    int64_t at;                        // the frame the above holds, else -1
+    struct rec_frame frame;            // that frame's header
+    uint64_t start;                    // recording time of our first use
+    double speed;                      // recording secs per elapsed sec
+    struct timespec began;             // CLOCK_MONOTONIC of our first use
+    char *blk;                         // tasks copied by replay_load
+    size_t blk_used;                   // bytes in the above
+    size_t cursor;                     // the next record for replay_next
+    int hide;                          // replay_next omits kernel threads
+    int tasks_only;                    // replay_next omits other threads
+};
+
+    // a file opened by replay_fopen
+struct rec_file {
+    int which;                         // index into rec_files
+    char *mem;                         // its contents, as of the last rewind
+    size_t len;                        // bytes in the above
+    size_t siz;                        // bytes allocated for the above
+    size_t pos;                        // the next byte read
+    int stale;                         // contents are to be refreshed
+};
+
+static char *Replay_path;              // LIBPROC_REPLAY, as last seen
+static struct replay *Replay;          // what it named, if that was usable
+
+
+static int buf_need (struct rec_buf *b, size_t more) {
+    size_t siz;
+    char *mem;
+
+    if (b->len + more <= b->siz)
+        return 1;
+    siz = b->siz ? b->siz : 4096;
+    while (siz < b->len + more)
+        siz *= 2;
+    if (!(mem = realloc(b->mem, siz)))
+        return 0;
+    b->mem = mem;
+    b->siz = siz;
+    return 1;
+}
+
+
+static inline int buf_put (struct rec_buf *b, const void *src, size_t n) {
+    if (!buf_need(b, n))
+        return 0;
+    memcpy(b->mem + b->len, src, n);
+    b->len += n;
+    return 1;
+}
+
+
+static int buf_varint (struct rec_buf *b, uint64_t v) {
+    unsigned char tmp[10];
+    int n = 0;
+
+    do {
+        tmp[n] = v & 0x7f;
+        if ((v >>= 7))
+            tmp[n] |= 0x80;
+        n++;
+    } while (v);
+    return buf_put(b, tmp, n);
+}
+
+
+static int get_varint (const char *src, size_t len, size_t *at, uint64_t *v) {
+    unsigned char c;
+    int shift;
+
+    for (*v = 0, shift = 0; *at < len && shift < 64; shift += 7) {
+        c = src[(*at)++];
+        *v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return 1;
+    }
+    return 0;
+}
+
+
+static void state_free (struct rec_state *st) {
+    int i;
+
+    for (i = 0; i < REC_NFILES; i++)
+        free(st->text[i].mem);
+    free(st->tasks.mem);
+    free(st->tids);
+}
+
+
+    // the end of that line beginning at 'at' (just past its newline)
+static inline size_t txt_eol (const char *src, size_t len, size_t at) {
+    const char *nl = memchr(src + at, '\n', len - at);
+
+    return nl ? (size_t)(nl - src) + 1 : len;
+}
+
+
+static int tid_cmp (const void *a, const void *b) {
+    int x = ((const struct rec_tid *)a)->tid, y = ((const struct rec_tid *)b)->tid;
+
+    return (x > y) - (x < y);
+}
+
+
+    // order a frame's records by tid, so its successor can find them
+static int tids_build (struct rec_state *st) {
+    struct rec_tid *new;
+    uint64_t len;
+    size_t at;
+    unsigned n;
+
+    if (st->tids_siz < st->count) {
+        if (!(new = realloc(st->tids, sizeof(struct rec_tid) * st->count)))
+            return 0;
+        st->tids = new;
+        st->tids_siz = st->count;
+    }
+    for (at = 0, n = 0; at < st->tasks.len && n < st->count; at += len, n++) {
+        memcpy(&len, st->tasks.mem + at, sizeof(len));
+        st->tids[n].tid = ((proc_t *)(st->tasks.mem + at + sizeof(len)))->tid;
+        st->tids[n].off = at;
+    }
+    qsort(st->tids, n, sizeof(struct rec_tid), tid_cmp);
+    return 1;
+}
+
+
+    // a prior frame's record (and its length) for this tid, else NULL
+static const char *tids_find (const struct rec_state *st, int tid, uint64_t *len) {
+    struct rec_tid key = { .tid = tid }, *t;
+
+    if (!st->count
+    || !(t = bsearch(&key, st->tids, st->count, sizeof(struct rec_tid), tid_cmp)))
+        return NULL;
+    memcpy(len, st->tasks.mem + t->off, sizeof(*len));
+    return st->tasks.mem + t->off;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// the writer ------------------------------------------------------------------
+
+static int rec_write (int fd, const void *src, size_t n) {
+    const char *p = src;
+    ssize_t w;
+
+    while (n) {
+        if ((w = write(fd, p, n)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        p += w;
+        n -= w;
+    }
+    return 1;
+}
+
+
+    // the whole of some /proc file, else zero
+static int rec_slurp (const char *path, struct rec_buf *b) {
+    char buf[PROCPS_ROOTMAX + 32];
+    ssize_t n;
+    int fd;
+
+    b->len = 0;
+    procps_rootf(buf, sizeof(buf), "%s", path);
+    if (0 > (fd = open(buf, O_RDONLY | O_CLOEXEC)))
+        return 0;
+    for (;;) {
+        if (!buf_need(b, 4096))
+            break;
+        if ((n = read(fd, b->mem + b->len, b->siz - b->len)) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (n == 0) {
+            close(fd);
+            return 1;
+        }
+        b->len += n;
+    }
+    close(fd);
+    return 0;
+}
+
+
+struct recording *recording_create (const char *path) {
+    struct rec_hdr h = { .magic = REC_MAGIC, .version = REC_VERSION,
+        .proc_size = sizeof(proc_t), .nfiles = REC_NFILES };
+    struct recording *r;
+
+    if (!(r = calloc(1, sizeof(struct recording))))
+        return NULL;
+    // it holds root-only files (slabinfo) and maybe other private details,
+    // so only its owner may read it, even when it had existed already
+    if (0 > (r->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600)))
+        goto oops;
+    if (fchmod(r->fd, 0600) < 0)
+        goto oops;
+    if (!rec_write(r->fd, &h, sizeof(h)))
+        goto oops;
+    r->at = sizeof(h);
+    return r;
+oops:
+    {   int errsav = errno;
+        if (r->fd >= 0)
+            close(r->fd);
+        free(r);
+        errno = errsav;
+    }
+    return NULL;
+}
+
+
+void recording_close (struct recording *r) {
+    struct rec_hdr h = { .magic = REC_MAGIC, .version = REC_VERSION,
+        .proc_size = sizeof(proc_t), .nfiles = REC_NFILES };
+
+    if (!r)
+        return;
+    // with the index in place a reader needn't walk every frame
+    if (r->frames
+    && rec_write(r->fd, r->index, sizeof(struct rec_index) * r->frames)) {
+        h.index = r->at;
+        h.frames = r->frames;
+        // (even without that index it remains a usable recording)
+        if (pwrite(r->fd, &h, sizeof(h), 0) != sizeof(h))
+            errno = EIO;
+    }
+    close(r->fd);
+    free(r->out.mem);
+    state_free(&r->st[0]);
+    state_free(&r->st[1]);
+    free(r->index);
+    free(r);
+}
+
+
+void recording_begin (struct recording *r) {
+    r->st[r->cur].tasks.len = 0;
+    r->st[r->cur].count = 0;
+}
+
+
+int recording_add (struct recording *r, const proc_t *p) {
+    struct rec_state *st = &r->st[r->cur];
+    size_t len = snapshot_rec_size(p);
+
+    if (!buf_need(&st->tasks, len))
+        return 0;
+    snapshot_rec_pack(st->tasks.mem + st->tasks.len, len, p);
+    st->tasks.len += len;
+    st->count++;
+    return 1;
+}
+
+
+    // those lines of 'new' which differ from 'old' in the same place
+static int txt_delta (struct rec_buf *out, const struct rec_buf *old, const struct rec_buf *new) {
+    size_t o = 0, n = 0, oe, ne, lit;
+    uint64_t copy;
+
+    while (n < new->len) {
+        for (copy = 0; n < new->len && o < old->len; copy++) {
+            oe = txt_eol(old->mem, old->len, o);
+            ne = txt_eol(new->mem, new->len, n);
+            if (oe - o != ne - n || memcmp(old->mem + o, new->mem + n, ne - n))
+                break;
+            o = oe;
+            n = ne;
+        }
+        for (lit = n; n < new->len; n = ne) {
+            ne = txt_eol(new->mem, new->len, n);
+            if (o < old->len) {
+                oe = txt_eol(old->mem, old->len, o);
+                if (oe - o == ne - n && !memcmp(old->mem + o, new->mem + n, ne - n))
+                    break;
+                o = oe;
+            }
+        }
+        if (!buf_varint(out, copy)
+        || !buf_varint(out, n - lit)
+        || !buf_put(out, new->mem + lit, n - lit))
+            return 0;
+    }
+    return 1;
+}
+
+
+static int rec_text_put (struct recording *r, int i, int key) {
+    const struct rec_buf *new = &r->st[r->cur].text[i], *old = &r->st[!r->cur].text[i];
+    struct rec_text t = { .how = TXT_NONE };
+    size_t at = r->out.len;
+    static const char zeros[8];
+
+    if (!buf_put(&r->out, &t, sizeof(t)))
+        return 0;
+    if (!r->st[r->cur].have[i])
+        return 1;
+    t.how = TXT_WHOLE;
+    if (!key && r->st[!r->cur].have[i]) {
+        if (new->len == old->len && !memcmp(new->mem, old->mem, new->len))
+            t.how = TXT_SAME;
+        else {
+            if (!txt_delta(&r->out, old, new))
+                return 0;
+            t.how = TXT_DELTA;
+            // a delta no smaller than the file itself is pointless
+            if (r->out.len - at - sizeof(t) >= new->len) {
+                r->out.len = at + sizeof(t);
+                t.how = TXT_WHOLE;
+            }
+        }
+    }
+    if (t.how == TXT_WHOLE && !buf_put(&r->out, new->mem, new->len))
+        return 0;
+    t.len = r->out.len - at - sizeof(t);
+    memcpy(r->out.mem + at, &t, sizeof(t));
+    return buf_put(&r->out, zeros, REC_ALIGN(t.len) - t.len);
+}
+
+
+int recording_commit (struct recording *r, int threads, int hidden) {
+    struct rec_state *st = &r->st[r->cur], *prv = &r->st[!r->cur];
+    struct rec_frame f = { .magic = FRM_MAGIC, .threads = threads,
+        .hidden = hidden, .count = st->count };
+    struct rec_index *new;
+    struct timespec ts;
+    const char *old, *rec;
+    uint64_t len, olen, tag;
+    size_t at;
+    int i;
+
+    if (r->failed) {
+        errno = EIO;
+        return 0;
+    }
+    clock_gettime(CLOCK_REALTIME, &ts);
+    f.when = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    // a clock stepped backwards mustn't leave the frames out of order
+    if (f.when < r->when)
+        f.when = r->when;
+    f.key = (r->frames % REC_KEYINT == 0);
+
+    r->out.len = 0;
+    if (!buf_put(&r->out, &f, sizeof(f)))
+        return 0;
+    for (i = 0; i < REC_NFILES; i++) {
+        st->have[i] = rec_slurp(rec_files[i], &st->text[i]);
+        if (!rec_text_put(r, i, f.key))
+            return 0;
+    }
+    for (at = 0; at < st->tasks.len; at += len) {
+        rec = st->tasks.mem + at;
+        memcpy(&len, rec, sizeof(len));
+        if (!f.key
+        && (old = tids_find(prv, ((proc_t *)(rec + sizeof(len)))->tid, &olen))
+        && olen == len && !memcmp(old, rec, len)) {
+            // the record's own length is even, so an odd one is a tid
+            tag = ((uint64_t)((proc_t *)(rec + sizeof(len)))->tid << 1) | 1;
+            if (!buf_put(&r->out, &tag, sizeof(tag)))
+                return 0;
+        } else if (!buf_put(&r->out, rec, len))
+            return 0;
+    }
+    f.len = r->out.len;
+    memcpy(r->out.mem, &f, sizeof(f));
+
+    if (r->frames >= r->index_siz) {
+        r->index_siz = r->index_siz ? r->index_siz * 2 : 1024;
+        if (!(new = realloc(r->index, sizeof(struct rec_index) * r->index_siz)))
+            return 0;
+        r->index = new;
+    }
+    if (!tids_build(st))
+        return 0;
+    if (!rec_write(r->fd, r->out.mem, r->out.len)) {
+        // what frames there are must not be followed by part of one
+        int errsav = errno;
+        if (ftruncate(r->fd, r->at) < 0 || lseek(r->fd, r->at, SEEK_SET) < 0)
+            r->failed = 1;
+        errno = errsav;
+        return 0;
+    }
+    r->index[r->frames].when = f.when;
+    r->index[r->frames].off = r->at;
+    r->frames++;
+    r->at += r->out.len;
+    r->when = f.when;
+    r->cur = !r->cur;
+    return 1;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// the reader ------------------------------------------------------------------
+
+    // the frame at some offset, provided it's sane
+static const struct rec_frame *rp_frame (const struct replay *r, uint64_t off) {
+    const struct rec_frame *f;
+
+    if (off < sizeof(struct rec_hdr)
+    || off % 8
+    || off > r->mapped - sizeof(struct rec_frame))
+        return NULL;
+    f = (const struct rec_frame *)(r->map + off);
+    if (f->magic != FRM_MAGIC
+    || f->len < sizeof(struct rec_frame)
+    || f->len % 8
+    || f->len > r->mapped - off)
+        return NULL;
+    return f;
+}
+
+
+    // trust the index only when all it says is sane, else walk the frames
+static int rp_index (struct replay *r) {
+    const struct rec_hdr *h = (const struct rec_hdr *)r->map;
+    const struct rec_index *x;
+    const struct rec_frame *f;
+    uint64_t i, off, n;
+
+    if (h->index && h->frames
+    && h->index <= r->mapped
+    && h->frames <= (r->mapped - h->index) / sizeof(struct rec_index)) {
+        x = (const struct rec_index *)(r->map + h->index);
+        for (i = 0; i < h->frames; i++)
+            if (!rp_frame(r, x[i].off)
+            || (i && x[i].when < x[i - 1].when))
+                break;
+        if (i == h->frames) {
+            if (!(r->index = malloc(sizeof(struct rec_index) * i)))
+                return 0;
+            memcpy(r->index, x, sizeof(struct rec_index) * i);
+            r->frames = i;
+            return 1;
+        }
+    }
+    for (n = 0, off = sizeof(struct rec_hdr); (f = rp_frame(r, off)); off += f->len)
+        n++;
+    if (!n || !(r->index = malloc(sizeof(struct rec_index) * n)))
+        return 0;
+    for (i = 0, off = sizeof(struct rec_hdr); i < n; off += f->len, i++) {
+        f = rp_frame(r, off);
+        r->index[i].when = f->when;
+        r->index[i].off = off;
+    }
+    r->frames = n;
+    return 1;
+}
+
+
+static void rp_close (struct replay *r) {
+    if (!r)
+        return;
+    if (r->map)
+        munmap(r->map, r->mapped);
+    free(r->index);
+    state_free(&r->st[0]);
+    state_free(&r->st[1]);
+    free(r);
+}
+
+
+static struct replay *rp_open (const char *path) {
+    const struct rec_hdr *h;
+    struct replay *r;
+    struct stat sb;
+    const char *env;
+    double secs;
+    int fd;
+
+    if (!(r = calloc(1, sizeof(struct replay))))
+        return NULL;
+    r->at = -1;
+    if (0 > (fd = open(path, O_RDONLY | O_CLOEXEC)))
+        goto oops;
+    if (fstat(fd, &sb) < 0 || (size_t)sb.st_size < sizeof(struct rec_hdr)) {
+        close(fd);
+        goto oops;
+    }
+    r->map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (r->map == MAP_FAILED) {
+        r->map = NULL;
+        goto oops;
+    }
+    r->mapped = sb.st_size;
+    h = (const struct rec_hdr *)r->map;
+    if (h->magic != REC_MAGIC
+    || h->version != REC_VERSION
+    || h->proc_size != sizeof(proc_t)
+    || h->nfiles != REC_NFILES
+    || !rp_index(r))
+        goto oops;
+
+    r->speed = 1.0;
+    if ((env = getenv("LIBPROC_REPLAY_SPEED")) && (secs = strtod(env, NULL)) >= 0)
+        r->speed = secs;
+    r->start = r->index[0].when;
+    if ((env = getenv("LIBPROC_REPLAY_START")) && (secs = strtod(env, NULL)) > 0)
+        r->start += secs * 1000000000.0;
+    clock_gettime(CLOCK_MONOTONIC, &r->began);
+    return r;
+oops:
+    rp_close(r);
+    return NULL;
+}
+
+
+    // the lines of some prior file, as altered by a delta
+static int txt_undelta (struct rec_buf *out, const struct rec_buf *old, const char *ops, size_t len) {
+    size_t at = 0, o = 0, oe, end;
+    uint64_t copy, lit;
+
+    out->len = 0;
+    while (at < len) {
+        if (!get_varint(ops, len, &at, &copy)
+        || !get_varint(ops, len, &at, &lit)
+        || lit > len - at)
+            return 0;
+        for ( ; copy; copy--) {
+            if (o >= old->len)
+                return 0;
+            oe = txt_eol(old->mem, old->len, o);
+            if (!buf_put(out, old->mem + o, oe - o))
+                return 0;
+            o = oe;
+        }
+        if (!buf_put(out, ops + at, lit))
+            return 0;
+        // each new line replaced one old one (if there were yet any)
+        for (end = at + lit; at < end; at = txt_eol(ops, end, at))
+            if (o < old->len)
+                o = txt_eol(old->mem, old->len, o);
+    }
+    return 1;
+}
+
+
+    // make some frame current, given that any delta follows what's current
+static int rp_decode (struct replay *r, int64_t k) {
+    struct rec_state *st = &r->st[!r->cur], *prv = &r->st[r->cur];
+    const struct rec_frame *f = rp_frame(r, r->index[k].off);
+    const struct rec_text *t;
+    const char *p, *end, *rec;
+    uint64_t tag, len;
+    unsigned n;
+    int i;
+
+    if (!f || (!f->key && r->at != k - 1))
+        return 0;
+    p = (const char *)(f + 1);
+    end = (const char *)f + f->len;
+
+    for (i = 0; i < REC_NFILES; i++) {
+        if ((size_t)(end - p) < sizeof(struct rec_text))
+            return 0;
+        t = (const struct rec_text *)p;
+        p += sizeof(struct rec_text);
+        if ((size_t)(end - p) < REC_ALIGN(t->len))
+            return 0;
+        st->have[i] = (t->how != TXT_NONE);
+        st->text[i].len = 0;
+        switch (t->how) {
+            case TXT_NONE:
+                break;
+            case TXT_WHOLE:
+                if (!buf_put(&st->text[i], p, t->len))
+                    return 0;
+                break;
+            case TXT_SAME:
+                if (f->key || !prv->have[i]
+                || !buf_put(&st->text[i], prv->text[i].mem, prv->text[i].len))
+                    return 0;
+                break;
+            case TXT_DELTA:
+                if (f->key || !prv->have[i]
+                || !txt_undelta(&st->text[i], &prv->text[i], p, t->len))
+                    return 0;
+                break;
+            default:
+                return 0;
+        }
+        p += REC_ALIGN(t->len);
+    }
+
+    st->tasks.len = 0;
+    st->count = 0;
+    for (n = 0; n < f->count; n++) {
+        if ((size_t)(end - p) < sizeof(tag))
+            return 0;
+        memcpy(&tag, p, sizeof(tag));
+        if (tag & 1) {
+            if (f->key || !(rec = tids_find(prv, (int)(tag >> 1), &len)))
+                return 0;
+            p += sizeof(tag);
+        } else {
+            len = tag;
+            if (len < REC_RECSIZ || len % 8 || len > (size_t)(end - p))
+                return 0;
+            rec = p;
+            p += len;
+        }
+        if (!buf_put(&st->tasks, rec, len))
+            return 0;
+        st->count++;
+    }
+    if (!tids_build(st))
+        return 0;
+    r->frame = *f;
+    r->cur = !r->cur;
+    r->at = k;
+    return 1;
+}
+
+
+    // bring the frame due at this moment up to date, else zero
+static int rp_current (struct replay *r) {
+    struct timespec now;
+    uint64_t when;
+    int64_t lo, hi, mid, k;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    when = r->start + ((now.tv_sec - r->began.tv_sec) * 1e9
+        + (now.tv_nsec - r->began.tv_nsec)) * r->speed;
+    // the last frame taken no later than that (any before the first is it)
+    for (lo = 0, hi = r->frames - 1; lo < hi; ) {
+        mid = (lo + hi + 1) / 2;
+        if (r->index[mid].when <= when)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    if (lo == r->at)
+        return 1;
+    // whatever we already have might well be on the way there
+    for (k = lo; k > 0 && k != r->at + 1; k--) {
+        const struct rec_frame *f = rp_frame(r, r->index[k].off);
+        if (!f || f->key)
+            break;
+    }
+    for ( ; k <= lo; k++)
+        if (!rp_decode(r, k)) {
+            r->at = -1;
+            return 0;
+        }
+    return 1;
+}
+
+
+    // what LIBPROC_REPLAY named, once it's current, else NULL
+static struct replay *rp_get (void) {
+    if (!replay_active() || !Replay) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if (!rp_current(Replay)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return Replay;
+}
+
+
+    // the current frame's copy of some file, else NULL
+static const struct rec_buf *rp_text (const char *path) {
+    struct replay *r;
+    int i;
+
+    for (i = 0; i < REC_NFILES; i++)
+        if (!strcmp(path, rec_files[i]))
+            break;
+    if (!(r = rp_get()))
+        return NULL;
+    if (i >= REC_NFILES || !r->st[r->cur].have[i]) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return &r->st[r->cur].text[i];
+}
+
+
+int replay_active (void) {
+    const char *path = getenv("LIBPROC_REPLAY");
+
+    if (path && !*path)
+        path = NULL;
+    // whatever the caller might since have done with setenv is honored
+    if (path && Replay_path && !strcmp(path, Replay_path))
+        return 1;
+    if (!path && !Replay_path)
+        return 0;
+    rp_close(Replay);
+    Replay = NULL;
+    free(Replay_path);
+    Replay_path = NULL;
+    if (path && (Replay_path = strdup(path)))
+        Replay = rp_open(path);
+    return (Replay_path != NULL);
+}
+
+
+int replay_read (const char *path, char *buf, size_t siz) {
+    const struct rec_buf *t;
+
+    if (!(t = rp_text(path)))
+        return -1;
+    if (siz > t->len)
+        siz = t->len;
+    memcpy(buf, t->mem, siz);
+    return siz;
+}
+
+
+static ssize_t rf_read (void *cookie, char *buf, size_t siz) {
+    struct rec_file *f = cookie;
+    const struct rec_buf *t;
+    char *mem;
+
+    if (f->stale) {
+        if (!(t = rp_text(rec_files[f->which])))
+            return -1;
+        if (f->siz < t->len) {
+            if (!(mem = realloc(f->mem, t->len)))
+                return -1;
+            f->mem = mem;
+            f->siz = t->len;
+        }
+        memcpy(f->mem, t->mem, t->len);
+        f->len = t->len;
+        f->stale = 0;
+    }
+    if (f->pos >= f->len)
+        return 0;
+    if (siz > f->len - f->pos)
+        siz = f->len - f->pos;
+    memcpy(buf, f->mem + f->pos, siz);
+    f->pos += siz;
+    return siz;
+}
+
+
+static int rf_seek (void *cookie, off64_t *off, int whence) {
+    struct rec_file *f = cookie;
+    off64_t pos;
+
+    switch (whence) {
+        case SEEK_SET: pos = *off; break;
+        case SEEK_CUR: pos = f->pos + *off; break;
+        case SEEK_END: pos = f->len + *off; break;
+        default: pos = -1;
+    }
+    if (pos < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    // just as with /proc, starting over brings things up to date
+    if (pos == 0)
+        f->stale = 1;
+    *off = f->pos = pos;
+    return 0;
+}
+
+
+static int rf_close (void *cookie) {
+    struct rec_file *f = cookie;
+
+    free(f->mem);
+    free(f);
+    return 0;
+}
+
+
+FILE *replay_fopen (const char *path) {
+    cookie_io_functions_t io = {
+        .read = rf_read, .seek = rf_seek, .close = rf_close };
+    char buf[PROCPS_ROOTMAX + 32];
+    struct rec_file *f;
+    FILE *fp;
+    int i;
+
+    if (!replay_active()) {
+        procps_rootf(buf, sizeof(buf), "%s", path);
+        return fopen(buf, "r");
+    }
+    if (!rp_text(path))
+        return NULL;
+    for (i = 0; strcmp(path, rec_files[i]); i++)
+        ;
+    if (!(f = calloc(1, sizeof(struct rec_file))))
+        return NULL;
+    f->which = i;
+    f->stale = 1;
+    if (!(fp = fopencookie(f, "r", io)))
+        free(f);
+    return fp;
+}
+
+
+int replay_load (struct strarena *sa, int threads, int hide) {
+    struct replay *r;
+    int n;
+
+    if (!(r = rp_get()))
+        return -1;
+    r->blk = NULL;
+    r->blk_used = r->cursor = 0;
+    if (!r->frame.count) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (!(r->blk = strarena_alloc(sa, r->st[r->cur].tasks.len)))
+        return -1;
+    memcpy(r->blk, r->st[r->cur].tasks.mem, r->st[r->cur].tasks.len);
+    if (0 >= (n = snapshot_rec_fixup(r->blk, r->st[r->cur].tasks.len))) {
+        r->blk = NULL;
+        errno = EINVAL;
+        return -1;
+    }
+    r->blk_used = r->st[r->cur].tasks.len;
+    r->hide = hide && !r->frame.hidden;
+    r->tasks_only = !threads && r->frame.threads;
+    return n;
+}
+
+
+proc_t *replay_next (proc_t *p) {
+    struct replay *r = Replay;
+    uint64_t len;
+    proc_t *q;
+
+    while (r && r->cursor < r->blk_used) {
+        memcpy(&len, r->blk + r->cursor, sizeof(len));
+        q = (proc_t *)(r->blk + r->cursor + sizeof(len));
+        r->cursor += len;
+        if (r->hide && (q->ppid == 2 || q->tid == 2))
+            continue;
+        if (r->tasks_only && q->tid != q->tgid)
+            continue;
+        memcpy(p, q, sizeof(proc_t));
+        // a wchan name, unlike the other strings, is expected to persist
+        if (p->wchan_name)
+            p->wchan_name = lookup_wchan_str(p->wchan_name);
+        return p;
+    }
+    return NULL;
+}
@@ -0,0 +1,52 @@
+/*
+ * record.h - a file of successive reaps, and their later replay
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PROCPS_PROC_RECORD_H
+#define PROCPS_PROC_RECORD_H
+
+#include <stdio.h>
+
+#include "readproc.h"
+
+struct recording;
+
+// The writer stages each proc_t from a reap, then adds them as one frame
+// (along with the current contents of some few other /proc files).
+struct recording *recording_create (const char *path);
+void recording_close (struct recording *r);
+void recording_begin (struct recording *r);
+int recording_add (struct recording *r, const proc_t *p);
+int recording_commit (struct recording *r, int threads, int hidden);
+
+// When LIBPROC_REPLAY names a recording, these serve its frames in place
+// of /proc.  Which frame is current depends on the time since the first
+// use (see LIBPROC_REPLAY_START and LIBPROC_REPLAY_SPEED).
+int replay_active (void);
+
+// Either /proc file, beneath any root prefix (only when not replaying), or
+// the current frame's copy of it, which is refreshed by any rewind (or seek
+// to zero).
+FILE *replay_fopen (const char *path);
+int replay_read (const char *path, char *buf, size_t siz);
+
+// The current frame's tasks are copied into the arena, returning their
+// number (or -1), and then copied out one at a time with replay_next.
+int replay_load (struct strarena *sa, int threads, int hide);
+proc_t *replay_next (proc_t *p);
+
+#endif
@@ -35,6 +35,7 @@
 #include <sys/types.h>
 
 #include <proc/procps-private.h>
+#include <proc/record.h>
 #include <proc/slabinfo.h>
 
 
@@ -480,7 +481,7 @@ static int slabinfo_read_failed (
     info->nodes_used = 0;
 
     if (NULL == info->slabinfo_fp
-    && (info->slabinfo_fp = fopen(SLABINFO_FILE, "r")) == NULL)
+    && (info->slabinfo_fp = replay_fopen(SLABINFO_FILE)) == NULL)
         return 1;
 
     if (fseek(info->slabinfo_fp, 0L, SEEK_SET) < 0)
@@ -0,0 +1,569 @@
+/*
+ * snapshot.c - a shared memory copy of one process table reap
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "procps-private.h"
+#include "snapshot.h"
+#include "wchan.h"
+
+/*
+ * A snapshot is a single file (normally in /dev/shm), written by just one
+ * publisher and read by any number of others.  Following its header comes
+ * one record per task: a length, the proc_t itself and then every string
+ * and vector it referenced.  In the proc_t, those pointers are replaced by
+ * offsets (from the proc_t's start) which each reader turns back into
+ * pointers, once it has its own copy.
+ *
+ * The header's sequence number is odd whenever the publisher is writing,
+ * so a reader simply retries should it change during a copy.  The region
+ * only ever grows so that it cannot vanish beneath some reader's mmap. */
+
+#define SNAP_MAGIC    0x504e5350u      // "PSNP"
+#define SNAP_VERSION  1
+#define SNAP_MINSIZ   (1024 * 1024)    // the smallest region, in bytes
+#define SNAP_STAGE    (256 * 1024)     // the initial staging buffer, in bytes
+#define SNAP_TRIES    500              // a reader's attempts at a clean copy
+#define SNAP_NAPNS    100000           // and its nap (in nsecs) after each
+#define SNAP_ALIGN(n) (((n) + 7) & ~(size_t)7)
+#define SNAP_RECSIZ   (sizeof(uint64_t) + sizeof(proc_t))
+
+    // what comes from those /proc files readable by just their owner (and root)
+#define SNAP_PRIVATE  (PROC_FILLENV | PROC_EDITENVRCVT | PROC_FILL_EXE | PROC_FILLIO \
+                     | PROC_FILLNS | PROC_FILLSYSTEMD | PROC_FILLSMAPS | PROC_FILLWCHAN)
+    // and those stat fields the kernel shows as zero to all but its tracers
+#define SNAP_STATPRIV (PROC_STAT_start_code | PROC_STAT_end_code | PROC_STAT_start_stack \
+                     | PROC_STAT_kstk_esp | PROC_STAT_kstk_eip | PROC_STAT_wchan)
+
+struct snap_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t proc_size;                // sizeof(proc_t), which must agree
+    uint32_t seq;                      // odd while the publisher is writing
+    uint64_t region;                   // the file's size (only increases)
+    uint64_t used;                     // bytes of records following this
+    uint64_t taken;                    // CLOCK_MONOTONIC nsecs at commit
+    uint64_t statfields;               // (see struct snap_meta)
+    uint32_t flags;                    //  "
+    uint32_t statuskeys;               //  "
+    uint32_t nsfields;                 //  "
+    uint32_t which;                    //  "
+    uint32_t hidden;                   //  "
+    uint32_t count;                    // number of records
+};
+
+struct snapshot {
+    int fd;
+    struct snap_hdr *hdr;              // the region as mapped
+    size_t mapped;                     // bytes in the above
+    char *stage;                       // publisher: records awaiting commit
+    size_t staged;                     // bytes in use in the above
+    size_t stage_siz;                  // bytes allocated for the above
+    unsigned count;                    // number of records staged
+    int private;                       // publisher: the file is now mode 0600
+    char *blk;                         // reader: records copied by load
+    size_t blk_used;                   // bytes of records in the above
+    size_t cursor;                     // the next record for snapshot_next
+    int hide;                          // snapshot_next omits kernel threads
+};
+
+    // every proc_t string, then every vector, that a snapshot carries
+static const size_t snap_strs[] = {
+    offsetof(proc_t, environ),  offsetof(proc_t, cmdline),  offsetof(proc_t, cgroup),
+    offsetof(proc_t, cgname),   offsetof(proc_t, supgid),   offsetof(proc_t, supgrp),
+    offsetof(proc_t, euser),    offsetof(proc_t, ruser),    offsetof(proc_t, suser),
+    offsetof(proc_t, fuser),    offsetof(proc_t, rgroup),   offsetof(proc_t, egroup),
+    offsetof(proc_t, sgroup),   offsetof(proc_t, fgroup),   offsetof(proc_t, cmd),
+    offsetof(proc_t, sd_mach),  offsetof(proc_t, sd_ouid),  offsetof(proc_t, sd_seat),
+    offsetof(proc_t, sd_sess),  offsetof(proc_t, sd_slice), offsetof(proc_t, sd_unit),
+    offsetof(proc_t, sd_uunit), offsetof(proc_t, lxcname),  offsetof(proc_t, exe),
+    offsetof(proc_t, wchan_name)
+};
+static const size_t snap_vecs[] = {
+    offsetof(proc_t, environ_v), offsetof(proc_t, cmdline_v), offsetof(proc_t, cgroup_v)
+};
+
+#define FLD(p,off)  (*(char **)((char *)(p) + (off)))
+#define VEC(p,off)  (*(char ***)((char *)(p) + (off)))
+
+
+static int snap_path (const char *name, char *path, size_t siz) {
+    int n;
+
+    if (!name || !*name)
+        return 0;
+    if (strchr(name, '/'))
+        n = snprintf(path, siz, "%s", name);
+    else
+        n = snprintf(path, siz, "/dev/shm/%s", name);
+    return (n > 0 && (size_t)n < siz);
+}
+
+
+static struct snapshot *snap_open (const char *name, int flags) {
+    char path[PATH_MAX];
+    struct snapshot *s;
+
+    if (!snap_path(name, path, sizeof(path))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(s = calloc(1, sizeof(struct snapshot))))
+        return NULL;
+    if (0 > (s->fd = open(path, flags | O_CLOEXEC | O_NOFOLLOW, 0644))) {
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+
+void snapshot_close (struct snapshot *s) {
+    if (!s)
+        return;
+    if (s->hdr)
+        munmap(s->hdr, s->mapped);
+    close(s->fd);                      // (along with any flock)
+    free(s->stage);
+    free(s);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// the publisher ---------------------------------------------------------------
+
+    // enlarge the file and our mapping of it, to at least 'need' bytes
+static int snap_grow (struct snapshot *s, size_t need) {
+    size_t pgmsk = getpagesize() - 1;
+    size_t siz = s->mapped ? s->mapped : SNAP_MINSIZ;
+    void *map;
+
+    while (siz < need)
+        siz += siz / 2;
+    siz = (siz + pgmsk) & ~pgmsk;
+    if (ftruncate(s->fd, siz) < 0)
+        return 0;
+    map = mmap(NULL, siz, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    if (map == MAP_FAILED)
+        return 0;
+    if (s->hdr)
+        munmap(s->hdr, s->mapped);
+    s->hdr = map;
+    s->mapped = siz;
+    return 1;
+}
+
+
+struct snapshot *snapshot_publish (const char *name) {
+    struct snapshot *s;
+    struct stat sb;
+
+    if (!(s = snap_open(name, O_RDWR | O_CREAT)))
+        return NULL;
+    if (flock(s->fd, LOCK_EX | LOCK_NB) < 0) {
+        if (errno == EWOULDBLOCK)
+            errno = EBUSY;
+        goto oops;
+    }
+    if (fstat(s->fd, &sb) < 0)
+        goto oops;
+    // an existing file is trusted only when ours, since its mode then stays
+    // ours to set (as snapshot_begin does once there's anything private)
+    if (!S_ISREG(sb.st_mode) || sb.st_uid != geteuid()) {
+        errno = EPERM;
+        goto oops;
+    }
+    // any existing region is reused, since some reader might have it mapped
+    if (!snap_grow(s, (size_t)sb.st_size))
+        goto oops;
+    return s;
+oops:
+    {   int errsav = errno;
+        snapshot_close(s);
+        errno = errsav;
+    }
+    return NULL;
+}
+
+
+int snapshot_begin (struct snapshot *s, unsigned flags, unsigned long long statfields) {
+    s->staged = 0;
+    s->count = 0;
+    if (s->private)
+        return 1;
+    // whatever the file's mode was (a umask is no help when it pre-existed),
+    // only its owner may read what's private
+    if ((flags & SNAP_PRIVATE)
+    || ((flags & PROC_FILLSTAT) && (!statfields || (statfields & SNAP_STATPRIV)))) {
+        if (fchmod(s->fd, 0600) < 0)
+            return 0;
+        s->private = 1;
+    }
+    return 1;
+}
+
+
+static inline uintptr_t snap_put (char *base, size_t *off, const char *str) {
+    size_t n = strlen(str) + 1;
+    uintptr_t at = *off;
+
+    memcpy(base + at, str, n);
+    *off += n;
+    return at;
+}
+
+
+size_t snapshot_rec_size (const proc_t *p) {
+    size_t vsz = 0, ssz = 0;
+    char **v;
+    int i, j;
+
+    for (i = 0; i < MAXTABLE(snap_strs); i++)
+        if (FLD(p, snap_strs[i]))
+            ssz += strlen(FLD(p, snap_strs[i])) + 1;
+    for (i = 0; i < MAXTABLE(snap_vecs); i++) {
+        if (!(v = VEC(p, snap_vecs[i])))
+            continue;
+        for (j = 0; v[j]; j++)
+            ssz += strlen(v[j]) + 1;
+        vsz += sizeof(uintptr_t) * (j + 1);
+    }
+    return SNAP_ALIGN(SNAP_RECSIZ + vsz + ssz);
+}
+
+
+void snapshot_rec_pack (char *dst, size_t len, const proc_t *p) {
+    size_t aoff, soff;
+    uintptr_t *arr;
+    char **v, *base;
+    uint64_t rec;
+    int i, j;
+
+    // the copy, with every pointer made an offset from the proc_t itself
+    rec = len;
+    memcpy(dst, &rec, sizeof(rec));
+    base = memcpy(dst + sizeof(rec), p, sizeof(proc_t));
+    memset(dst + len - 8, 0, 8);
+
+    aoff = sizeof(proc_t);
+    for (i = 0; i < MAXTABLE(snap_vecs); i++)
+        if ((v = VEC(p, snap_vecs[i]))) {
+            for (j = 0; v[j]; j++)
+                ;
+            aoff += sizeof(uintptr_t) * (j + 1);
+        }
+    soff = aoff;
+    aoff = sizeof(proc_t);
+    for (i = 0; i < MAXTABLE(snap_vecs); i++) {
+        if (!(v = VEC(p, snap_vecs[i])))
+            continue;
+        arr = (uintptr_t *)(base + aoff);
+        VEC(base, snap_vecs[i]) = (char **)aoff;
+        for (j = 0; v[j]; j++)
+            arr[j] = snap_put(base, &soff, v[j]);
+        arr[j] = 0;
+        aoff += sizeof(uintptr_t) * (j + 1);
+    }
+    for (i = 0; i < MAXTABLE(snap_strs); i++)
+        if (FLD(p, snap_strs[i]))
+            FLD(base, snap_strs[i]) = (char *)snap_put(base, &soff, FLD(p, snap_strs[i]));
+}
+
+
+int snapshot_add (struct snapshot *s, const proc_t *p) {
+    size_t len, siz;
+    char *new;
+    proc_t q;
+
+    // while the file's readable by others, nothing they couldn't see goes in
+    if (!s->private) {
+        memcpy(&q, p, sizeof(proc_t));
+        q.start_code = q.end_code = q.start_stack = 0;
+        q.kstk_esp = q.kstk_eip = q.wchan = 0;
+        q.wchan_name = NULL;
+        p = &q;
+    }
+    len = snapshot_rec_size(p);
+    if (s->staged + len > s->stage_siz) {
+        siz = s->stage_siz ? s->stage_siz : SNAP_STAGE;
+        while (siz < s->staged + len)
+            siz *= 2;
+        if (!(new = realloc(s->stage, siz)))
+            return 0;
+        s->stage = new;
+        s->stage_siz = siz;
+    }
+    snapshot_rec_pack(s->stage + s->staged, len, p);
+    s->staged += len;
+    s->count++;
+    return 1;
+}
+
+
+int snapshot_commit (struct snapshot *s, const struct snap_meta *m) {
+    struct snap_hdr *h;
+    struct timespec ts;
+    uint32_t seq;
+
+    if (sizeof(struct snap_hdr) + s->staged > s->mapped
+    && !snap_grow(s, sizeof(struct snap_hdr) + s->staged))
+        return 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    h = s->hdr;
+
+    seq = h->seq | 1;
+    __atomic_store_n(&h->seq, seq, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(h + 1, s->stage, s->staged);
+    h->magic = SNAP_MAGIC;
+    h->version = SNAP_VERSION;
+    h->proc_size = sizeof(proc_t);
+    h->region = s->mapped;
+    h->used = s->staged;
+    h->taken = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    h->statfields = m->statfields;
+    h->flags = m->flags;
+    h->statuskeys = m->statuskeys;
+    h->nsfields = m->nsfields;
+    h->which = m->which;
+    h->hidden = m->hidden;
+    h->count = s->count;
+    __atomic_store_n(&h->seq, seq + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// the readers -----------------------------------------------------------------
+
+    // (re)map the region, whose size will have only grown since last time
+static int snap_map (struct snapshot *s) {
+    struct stat sb;
+    void *map;
+
+    if (fstat(s->fd, &sb) < 0
+    || (size_t)sb.st_size < sizeof(struct snap_hdr))
+        return 0;
+    if ((size_t)sb.st_size == s->mapped)
+        return 1;
+    map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, s->fd, 0);
+    if (map == MAP_FAILED)
+        return 0;
+    if (s->hdr)
+        munmap(s->hdr, s->mapped);
+    s->hdr = map;
+    s->mapped = sb.st_size;
+    return 1;
+}
+
+
+struct snapshot *snapshot_attach (const char *name) {
+    struct snapshot *s;
+    struct stat sb;
+
+    if (!(s = snap_open(name, O_RDONLY)))
+        return NULL;
+    // what's been published by some other (unprivileged) user isn't trusted
+    if (fstat(s->fd, &sb) < 0
+    || !S_ISREG(sb.st_mode)
+    || (sb.st_uid != 0 && sb.st_uid != geteuid())) {
+        snapshot_close(s);
+        errno = EPERM;
+        return NULL;
+    }
+    // (the publisher may not yet have gotten around to its first commit)
+    snap_map(s);
+    return s;
+}
+
+
+static int snap_usable (const struct snap_hdr *h, const struct snap_meta *want, int maxage) {
+    struct timespec ts;
+    unsigned long long now;
+
+    if (h->magic != SNAP_MAGIC
+    || h->version != SNAP_VERSION
+    || h->proc_size != sizeof(proc_t)
+    || h->count == 0
+    || h->used > h->region - sizeof(struct snap_hdr))
+        return 0;
+    if (maxage > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        now = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        if (now < h->taken || now - h->taken > maxage * 1000000ULL)
+            return 0;
+    }
+    if (h->which != want->which
+    || (h->hidden && !want->hidden)
+    || (want->flags & ~h->flags & ~(PROC_PID | PROC_UID)))
+        return 0;
+ #define HAS(f) (!h->f || (want->f && !(want->f & ~h->f)))
+    if (((want->flags & PROC_FILLSTATUS) && !HAS(statuskeys))
+    || ((want->flags & PROC_FILLSTAT) && !HAS(statfields))
+    || ((want->flags & PROC_FILLNS) && !HAS(nsfields)))
+        return 0;
+ #undef HAS
+    // we'll be hiding kernel threads ourselves, so we'll need their ppids
+    if (want->hidden && !h->hidden
+    && !(h->flags & (PROC_FILLSTAT | PROC_FILLSTATUS)))
+        return 0;
+    return 1;
+}
+
+
+    // turn an offset back into a pointer, once it's been proven sane
+static inline int snap_ptr (char *base, size_t len, char **fld) {
+    uintptr_t off = (uintptr_t)*fld;
+
+    if (!off)
+        return 1;
+    if (off < sizeof(proc_t) || off >= len || !memchr(base + off, '\0', len - off))
+        return 0;
+    *fld = base + off;
+    return 1;
+}
+
+
+static int snap_fixup (char *base, size_t len) {
+    uintptr_t off;
+    char **v;
+    int i;
+
+    for (i = 0; i < MAXTABLE(snap_strs); i++)
+        if (!snap_ptr(base, len, &FLD(base, snap_strs[i])))
+            return 0;
+    for (i = 0; i < MAXTABLE(snap_vecs); i++) {
+        if (!(off = (uintptr_t)VEC(base, snap_vecs[i])))
+            continue;
+        if (off < sizeof(proc_t) || off >= len || off % sizeof(uintptr_t))
+            return 0;
+        for (v = (char **)(base + off); ; v++) {
+            if ((char *)(v + 1) > base + len)
+                return 0;
+            if (!*v)
+                break;
+            if (!snap_ptr(base, len, v))
+                return 0;
+        }
+        VEC(base, snap_vecs[i]) = (char **)(base + off);
+    }
+    return 1;
+}
+
+
+int snapshot_rec_fixup (char *blk, size_t used) {
+    uint64_t len;
+    size_t at;
+    int n;
+
+    for (at = 0, n = 0; at < used; at += len, n++) {
+        if (used - at < SNAP_RECSIZ)
+            return -1;
+        memcpy(&len, blk + at, sizeof(len));
+        if (len < SNAP_RECSIZ || len > used - at || len % 8)
+            return -1;
+        if (!snap_fixup(blk + at + sizeof(len), len - sizeof(len)))
+            return -1;
+    }
+    return n;
+}
+
+
+int snapshot_load (struct snapshot *s, struct strarena *sa, const struct snap_meta *want, int maxage) {
+    const struct timespec nap = { 0, SNAP_NAPNS };
+    struct snap_hdr h;
+    size_t siz = 0;
+    char *blk = NULL;
+    uint32_t seq;
+    int tries;
+
+    s->blk = NULL;
+    s->blk_used = s->cursor = 0;
+    if (!s->hdr && !snap_map(s))
+        return 0;
+    for (tries = 0; ; tries++) {
+        if (tries) {
+            if (tries >= SNAP_TRIES)
+                return 0;
+            nanosleep(&nap, NULL);
+        }
+        if ((seq = __atomic_load_n(&s->hdr->seq, __ATOMIC_ACQUIRE)) & 1)
+            continue;
+        memcpy(&h, s->hdr, sizeof(h));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (seq != __atomic_load_n(&s->hdr->seq, __ATOMIC_RELAXED))
+            continue;
+        if (!snap_usable(&h, want, maxage))
+            return 0;
+        if (h.region > s->mapped) {
+            if (!snap_map(s) || h.region > s->mapped)
+                return 0;
+            continue;
+        }
+        if (siz < h.used) {
+            if (!(blk = strarena_alloc(sa, h.used)))
+                return 0;
+            siz = h.used;
+        }
+        memcpy(blk, s->hdr + 1, h.used);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (seq == __atomic_load_n(&s->hdr->seq, __ATOMIC_RELAXED))
+            break;
+    }
+
+    // what's now ours is checked rather than trusted, since it's just a file
+    if ((unsigned)snapshot_rec_fixup(blk, h.used) != h.count)
+        return 0;
+
+    s->blk = blk;
+    s->blk_used = h.used;
+    s->hide = want->hidden && !h.hidden;
+    return h.count;
+}
+
+
+proc_t *snapshot_next (struct snapshot *s, proc_t *p) {
+    uint64_t len;
+    proc_t *q;
+
+    while (s->cursor < s->blk_used) {
+        memcpy(&len, s->blk + s->cursor, sizeof(len));
+        q = (proc_t *)(s->blk + s->cursor + sizeof(len));
+        s->cursor += len;
+        if (s->hide && (q->ppid == 2 || q->tid == 2))
+            continue;
+        memcpy(p, q, sizeof(proc_t));
+        // a wchan name, unlike the other strings, is expected to persist
+        if (p->wchan_name)
+            p->wchan_name = lookup_wchan_str(p->wchan_name);
+        return p;
+    }
+    return NULL;
+}
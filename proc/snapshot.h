@@ -0,0 +1,66 @@
+/*
+ * snapshot.h - a shared memory copy of one process table reap
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PROCPS_PROC_SNAPSHOT_H
+#define PROCPS_PROC_SNAPSHOT_H
+
+#include "readproc.h"
+
+// What some reap gathered, so a reader can tell if it's sufficient.  For
+// each of the statuskeys, statfields and nsfields a zero means 'all'.
+struct snap_meta {
+    unsigned flags;                    // the readproc PROC_FILLxxx flags
+    unsigned statuskeys;               // those /proc/#/status lines parsed
+    unsigned long long statfields;     // those /proc/#/stat fields converted
+    unsigned nsfields;                 // those /proc/#/ns/* links read
+    unsigned which;                    // PIDS_FETCH_TASKS_ONLY or THREADS_TOO
+    unsigned hidden;                   // kernel threads were omitted
+};
+
+struct snapshot;
+
+// A name without any '/' is placed in /dev/shm, anything else is a path.
+// Only one publisher may hold a name at a time, else EBUSY results.
+struct snapshot *snapshot_publish (const char *name);
+struct snapshot *snapshot_attach (const char *name);
+void snapshot_close (struct snapshot *s);
+
+// The publisher stages each proc_t from a reap and then makes them all
+// visible at once, when the reap has completed.  Given the reap's flags
+// and statfields, the file is made mode 0600 if anything private is among
+// them, else those fields the kernel hides from others are left out.
+int snapshot_begin (struct snapshot *s, unsigned flags, unsigned long long statfields);
+int snapshot_add (struct snapshot *s, const proc_t *p);
+int snapshot_commit (struct snapshot *s, const struct snap_meta *m);
+
+// A reader copies the latest snapshot into the arena, provided that it's
+// no older than maxage msecs (zero means any age) and has all that 'want'
+// needs.  It returns the number of tasks, or zero when unusable.  Then, the
+// proc_t's themselves are copied out one at a time with snapshot_next.
+int snapshot_load (struct snapshot *s, struct strarena *sa, const struct snap_meta *want, int maxage);
+proc_t *snapshot_next (struct snapshot *s, proc_t *p);
+
+// Recordings (see record.c) carry these very same records.  The size of
+// one is found and then it's packed into that many bytes.  A block of them
+// is later checked and its offsets made pointers, returning the count (or
+// -1 should anything be amiss).
+size_t snapshot_rec_size (const proc_t *p);
+void snapshot_rec_pack (char *dst, size_t len, const proc_t *p);
+int snapshot_rec_fixup (char *blk, size_t used);
+
+#endif
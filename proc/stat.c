@@ -33,14 +33,19 @@
 #include <proc/numa.h>
 
 #include <proc/procps-private.h>
+#include <proc/record.h>
 #include <proc/stat.h>
 
 
 #define STAT_FILE "/proc/stat"
+#define IRQS_FILE "/proc/interrupts"
+#define SIRQ_FILE "/proc/softirqs"
 
 #define BUFFER_INCR   8192             // amount i/p buffer allocations grow
 #define STACKS_INCR   64               // amount reap stack allocations grow
 #define NEWOLD_INCR   64               // amount jiffs hist allocations grow
+#define IRQ_NAMESIZ   24               // an irq's label, as in "NET_RX" or "LOC"
+#define IRQ_DESCSIZ   64               // what /proc/interrupts shows after counts
 
 /* ------------------------------------------------------------------------- +
    this provision can be used to ensure that our Item_table was synchronized |
@@ -98,6 +103,38 @@ struct hist_tic {
 #endif
 };
 
+struct hist_irq {
+    char name[IRQ_NAMESIZ];
+    char desc[IRQ_DESCSIZ];
+    int cpus;                          // entries in each of the following
+    unsigned long long *counts;        // indexed by cpu id (in irq_gen.slab)
+    unsigned long long *deltas;        //  ditto, less the prior counts
+    unsigned long long new_tot;
+    unsigned long long old_tot;
+    int hot;                           // cpu id with the largest delta
+    int active;                        // number of cpus with any delta
+};
+
+struct irq_gen {
+    int ncols;                         // cpu columns in this read of the file
+    int *col_ids;                      // the cpu id for each such column
+    int ncpus;                         // highest of those cpu ids, plus one
+    int n_inuse;                       // number of below structs occupied
+    int n_alloc;                       // number of below structs allocated
+    int c_alloc;                       // counts + deltas, room for how many cpus
+    struct hist_irq *irqs;
+    unsigned long long *slab;          // all of the counts and deltas
+};
+
+struct irq_support {
+    const char *file;                  // /proc/interrupts or /proc/softirqs
+    int fd;                            // the above, for pread (else -1)
+    char *buf;                         // grows to accommodate all of the file
+    int buf_size;                      // current size for the above buf
+    int gen;                           // which of the below is the newest
+    struct irq_gen gens[2];            // new & old, alternating with each read
+};
+
 struct stacks_extent {
     int ext_numstacks;
     struct stacks_extent *next;
@@ -124,6 +161,7 @@ struct reap_support {
     int total;                         // independently obtained # of cpus/nodes
     struct ext_support fetch;          // extents plus items details
     struct tic_support hist;           // cpu and node jiffies management
+    struct irq_support irq;            // or, hard or soft irq management
     int n_alloc;                       // last known anchor pointers allocation
     struct stat_stack **anchor;        // reapable stacks (consolidated extents)
     int n_alloc_save;                  // last known results.stacks allocation
@@ -132,19 +170,23 @@ struct reap_support {
 
 struct stat_info {
     int refcount;
-    FILE *stat_fp;
+    int stat_fd;                       // /proc/stat, for pread (else -1)
     char *stat_buf;                    // grows to accommodate all /proc/stat
     int stat_buf_size;                 // current size for the above stat_buf
     struct hist_sys sys_hist;          // SYS type management
     struct hist_tic cpu_hist;          // TIC type management for cpu summary
     struct reap_support cpus;          // TIC type management for real cpus
     struct reap_support nodes;         // TIC type management for numa nodes
+    struct reap_support hard;          // IRQ type management for interrupts
+    struct reap_support soft;          // IRQ type management for softirqs
     struct ext_support cpu_summary;    // supports /proc/stat line #1 results
     struct ext_support select;         // support for 'procps_stat_select()'
     struct stat_reaped results;        // for return to caller after a reap
     struct stat_result get_this;       // for return to caller after a get
     struct item_support reap_items;    // items used for reap (shared among 3)
     struct item_support select_items;  // items unique to select
+    struct item_support hard_items;    // items unique to the interrupts reap
+    struct item_support soft_items;    // items unique to the softirqs reap
     time_t sav_secs;                   // used by procps_stat_get to limit i/o
 };
 
@@ -153,7 +195,7 @@ struct stat_info {
 
 #define setNAME(e) set_stat_ ## e
 #define setDECL(e) static void setNAME(e) \
-    (struct stat_result *R, struct hist_sys *S, struct hist_tic *T)
+    (struct stat_result *R, struct hist_sys *S, struct hist_tic *T, struct hist_irq *Q)
 
 // regular assignment
 #define TIC_set(e,t,x) setDECL(e) { \
@@ -167,8 +209,8 @@ struct stat_info {
 #define SYSsetH(e,t,x) setDECL(e) { \
     (void)T; R->result. t = ( S->new. x - S->old. x ); }
 
-setDECL(noop)  { (void)R; (void)S; (void)T; }
-setDECL(extra) { (void)S; (void)T; R->result.ull_int = 0; }
+setDECL(noop)  { (void)R; (void)S; (void)T; (void)Q; }
+setDECL(extra) { (void)S; (void)T; (void)Q; R->result.ull_int = 0; }
 
 setDECL(TIC_ID)                 { (void)S; R->result.s_int = T->id;  }
 setDECL(TIC_NUMA_NODE)          { (void)S; R->result.s_int = T->numa_node; }
@@ -221,6 +263,17 @@ SYSsetH(SYS_DELTA_PROC_BLOCKED,   s_int,    procs_blocked)
 SYSsetH(SYS_DELTA_PROC_CREATED,   s_int,    procs_created)
 SYSsetH(SYS_DELTA_PROC_RUNNING,   s_int,    procs_running)
 
+setDECL(IRQ_NAME)               { (void)S; (void)T; R->result.str = Q->name; }
+setDECL(IRQ_DESC)               { (void)S; (void)T; R->result.str = Q->desc; }
+setDECL(IRQ_NUM_CPUS)           { (void)S; (void)T; R->result.s_int = Q->cpus; }
+setDECL(IRQ_TOTAL)              { (void)S; (void)T; R->result.ull_int = Q->new_tot; }
+setDECL(IRQ_PER_CPU)            { (void)S; (void)T; R->result.ull_v = Q->counts; }
+setDECL(IRQ_CPUS_ACTIVE)        { (void)S; (void)T; R->result.s_int = Q->active; }
+setDECL(IRQ_CPU_HOT)            { (void)S; (void)T; R->result.s_int = Q->hot; }
+setDECL(IRQ_DELTA_TOTAL)        { (void)S; (void)T; R->result.sl_int = Q->new_tot - Q->old_tot; if (R->result.sl_int < 0) R->result.sl_int = 0; }
+setDECL(IRQ_DELTA_PER_CPU)      { (void)S; (void)T; R->result.ull_v = Q->deltas; }
+setDECL(IRQ_DELTA_CPU_HOT)      { (void)S; (void)T; R->result.sl_int = Q->deltas[Q->hot]; }
+
 #undef setDECL
 #undef TIC_set
 #undef SYS_set
@@ -267,6 +320,12 @@ srtDECL(ull_int) {
     return 0;
 }
 
+srtDECL(str) {
+    const struct stat_result *a = (*A)->head + P->offset; \
+    const struct stat_result *b = (*B)->head + P->offset; \
+    return P->order * strcoll(a->result.str, b->result.str);
+}
+
 srtDECL(noop) { \
     (void)A; (void)B; (void)P; \
     return 0;
@@ -277,7 +336,7 @@ srtDECL(noop) { \
 
 // ___ Controlling Table ||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-typedef void (*SET_t)(struct stat_result *, struct hist_sys *, struct hist_tic *);
+typedef void (*SET_t)(struct stat_result *, struct hist_sys *, struct hist_tic *, struct hist_irq *);
 #ifdef ITEMTABLE_DEBUG
 #define RS(e) (SET_t)setNAME(e), STAT_ ## e, STRINGIFY(STAT_ ## e)
 #else
@@ -357,14 +416,28 @@ static struct {
   { RS(SYS_DELTA_PROC_BLOCKED),  QS(s_int),    TS(s_int)   },
   { RS(SYS_DELTA_PROC_CREATED),  QS(s_int),    TS(s_int)   },
   { RS(SYS_DELTA_PROC_RUNNING),  QS(s_int),    TS(s_int)   },
+
+  { RS(IRQ_NAME),                QS(str),      TS(str)     },
+  { RS(IRQ_DESC),                QS(str),      TS(str)     },
+  { RS(IRQ_NUM_CPUS),            QS(s_int),    TS(s_int)   },
+  { RS(IRQ_TOTAL),               QS(ull_int),  TS(ull_int) },
+  { RS(IRQ_PER_CPU),             QS(noop),     TS(ull_v)   },
+  { RS(IRQ_CPUS_ACTIVE),         QS(s_int),    TS(s_int)   },
+  { RS(IRQ_CPU_HOT),             QS(s_int),    TS(s_int)   },
+
+  { RS(IRQ_DELTA_TOTAL),         QS(sl_int),   TS(sl_int)  },
+  { RS(IRQ_DELTA_PER_CPU),       QS(noop),     TS(ull_v)   },
+  { RS(IRQ_DELTA_CPU_HOT),       QS(sl_int),   TS(sl_int)  },
 };
 
     /* please note,
      * 1st enum MUST be kept in sync with highest TIC type
-     * 2nd enum MUST be 1 greater than the highest value of any enum */
+     * 2nd enum MUST be kept in sync with lowest IRQ type
+     * 3rd enum MUST be 1 greater than the highest value of any enum */
 #ifdef ENFORCE_LOGICAL
 enum stat_item STAT_TIC_highest = STAT_TIC_DELTA_GUEST_NICE;
 #endif
+enum stat_item STAT_IRQ_lowest = STAT_IRQ_NAME;
 enum stat_item STAT_logical_end = MAXTABLE(Item_table);
 
 #undef setNAME
@@ -378,7 +451,8 @@ enum stat_item STAT_logical_end = MAXTABLE(Item_table);
 static inline void stat_assign_results (
         struct stat_stack *stack,
         struct hist_sys *sys_hist,
-        struct hist_tic *tic_hist)
+        struct hist_tic *tic_hist,
+        struct hist_irq *irq_hist)
 {
     struct stat_result *this = stack->head;
 
@@ -386,7 +460,7 @@ static inline void stat_assign_results (
         enum stat_item item = this->item;
         if (item >= STAT_logical_end)
             break;
-        Item_table[item].setsfunc(this, sys_hist, tic_hist);
+        Item_table[item].setsfunc(this, sys_hist, tic_hist, irq_hist);
         ++this;
     }
     return;
@@ -484,6 +558,24 @@ static inline int stat_items_check_failed (
 } // end: stat_items_check_failed
 
 
+    // the IRQ type items may be used only with (and only) the irq reaps
+static inline int stat_items_irq_failed (
+        int numitems,
+        enum stat_item *items,
+        int irq)
+{
+    int i;
+
+    for (i = 0; i < numitems; i++) {
+        if (items[i] == STAT_noop || items[i] == STAT_extra)
+            continue;
+        if ((items[i] >= STAT_IRQ_lowest) != irq)
+            return 1;
+    }
+    return 0;
+} // end: stat_items_irq_failed
+
+
 static int stat_make_numa_hist (
         struct stat_info *info)
 {
@@ -544,11 +636,66 @@ static int stat_make_numa_hist (
 } // end: stat_make_numa_hist
 
 
+    // the next (unsigned) number on this line, skipping blanks before it,
+    // where *bp is left just beyond it (else upon whatever stopped us)
+static inline int stat_next_num (
+        char **bp,
+        unsigned long long *num)
+{
+    char *p = *bp;
+    unsigned long long n;
+
+    while (*p == ' ')
+        ++p;
+    if ((unsigned)(*p - '0') > 9) {
+        *bp = p;
+        return 0;
+    }
+    n = *p++ - '0';
+    while ((unsigned)(*p - '0') <= 9)
+        n = n * 10 + (*p++ - '0');
+    *bp = p;
+    *num = n;
+    return 1;
+} // end: stat_next_num
+
+
+    // those jiffies on a 'cpu' line (just after its label), returning how
+    // many were found -- any not found are simply left as they were
+static inline int stat_next_jifs (
+        char **bp,
+        struct stat_jifs *j)
+{
+    unsigned long long *jifs[] = {
+        &j->user,  &j->nice,   &j->system, &j->idle,  &j->iowait,
+        &j->irq,   &j->sirq,   &j->stolen, &j->guest, &j->gnice };
+    int n;
+
+    for (n = 0; n < (int)MAXTABLE(jifs); n++)
+        if (!stat_next_num(bp, jifs[n]))
+            break;
+    return n;
+} // end: stat_next_jifs
+
+
+    // the start of the line after bp (or the end of the buffer)
+static inline char *stat_next_line (
+        char *bp,
+        char *end)
+{
+    char *nl;
+
+    if (!(nl = memchr(bp, '\n', end - bp)))
+        return end;
+    return nl + 1;
+} // end: stat_next_line
+
+
 static int stat_read_failed (
         struct stat_info *info)
 {
     struct hist_tic *sum_ptr, *cpu_ptr;
-    char *bp, *b;
+    char *bp, *end;
     int i, rc, num, tot_read;
     unsigned long long llnum;
 
@@ -560,38 +707,56 @@ static int stat_read_failed (
         info->cpus.hist.n_inuse = 0;
     }
 
-    if (!info->stat_fp
-    && (!(info->stat_fp = fopen(STAT_FILE, "r"))))
-        return 1;
-    fflush(info->stat_fp);
-    rewind(info->stat_fp);
-
  #define maxSIZ    info->stat_buf_size
  #define curSIZ  ( maxSIZ - tot_read )
  #define curPOS  ( info->stat_buf + tot_read )
-    /* we slurp in the entire directory thus avoiding repeated calls to fread, |
-       especially in a massively parallel environment.  additionally, each cpu |
-       line is then frozen in time rather than changing until we get around to |
-       accessing it.  this helps to minimize (not eliminate) some distortions. | */
+    /* we slurp in the entire file thus avoiding repeated calls to pread, once |
+       the buffer has grown to fit (which also lets the kernel produce it all  |
+       at once).  additionally, each cpu line is then frozen in time rather    |
+       than changing until we get around to accessing it.  this helps to      |
+       minimize (not eliminate) some distortions.                              | */
     tot_read = 0;
-    while ((0 < (num = fread(curPOS, 1, curSIZ, info->stat_fp)))) {
-        tot_read += num;
-        if (tot_read < maxSIZ)
-            break;
-        maxSIZ += BUFFER_INCR;
-        if (!(info->stat_buf = realloc(info->stat_buf, maxSIZ)))
+    if (replay_active()) {
+        // a recording's copy, which is truncated unless the buffer can hold it
+        while (curSIZ - 1 <= (num = replay_read(STAT_FILE, info->stat_buf, curSIZ - 1))) {
+            maxSIZ += BUFFER_INCR;
+            if (!(info->stat_buf = realloc(info->stat_buf, maxSIZ)))
+                return 1;
+        }
+        if (num < 0)
             return 1;
-    };
+        tot_read = num;
+    } else {
+        if (info->stat_fd == -1) {
+            char path[PROCPS_ROOTMAX + 32];
+
+            procps_rootf(path, sizeof(path), STAT_FILE);
+            if (-1 == (info->stat_fd = open(path, O_RDONLY | O_CLOEXEC)))
+                return 1;
+        }
+        // (always leaving room for that null terminator)
+        while (0 < (num = pread(info->stat_fd, curPOS, curSIZ - 1, tot_read))) {
+            tot_read += num;
+            if (tot_read < maxSIZ - 1)
+                break;
+            maxSIZ += BUFFER_INCR;
+            if (!(info->stat_buf = realloc(info->stat_buf, maxSIZ)))
+                return 1;
+        };
+        if (num < 0)
+            return 1;
+    }
  #undef maxSIZ
  #undef curSIZ
  #undef curPOS
 
-    if (!feof(info->stat_fp)) {
+    if (!tot_read) {
         errno = EIO;
         return 1;
     }
     info->stat_buf[tot_read] = '\0';
     bp = info->stat_buf;
+    end = bp + tot_read;
 
     sum_ptr = &info->cpu_hist;
     // remember summary from last time around
@@ -601,15 +766,16 @@ static int stat_read_failed (
     sum_ptr->numa_node = STAT_NODE_INVALID;     // mark as invalid
 
     // now value the cpu summary tics from line #1
+    if (strncmp(bp, "cpu ", 4)) {
+        errno = ERANGE;
+        return 1;
+    }
+    bp += 4;
 #ifdef __CYGWIN__
-    if (4 > sscanf(bp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu"
+    if (4 > stat_next_jifs(&bp, &sum_ptr->new)) {
 #else
-    if (8 > sscanf(bp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu"
+    if (8 > stat_next_jifs(&bp, &sum_ptr->new)) {
 #endif
-        , &sum_ptr->new.user,  &sum_ptr->new.nice,   &sum_ptr->new.system
-        , &sum_ptr->new.idle,  &sum_ptr->new.iowait, &sum_ptr->new.irq
-        , &sum_ptr->new.sirq,  &sum_ptr->new.stolen
-        , &sum_ptr->new.guest, &sum_ptr->new.gnice)) {
             errno = ERANGE;
             return 1;
     }
@@ -627,25 +793,27 @@ reap_em_again:
     cpu_ptr = info->cpus.hist.tics + i;   // adapt to relocated if reap_em_again
 
     do {
-        bp = 1 + strchr(bp, '\n');
+        bp = stat_next_line(bp, end);
         // remember this cpu from last time around
         memcpy(&cpu_ptr->old, &cpu_ptr->new, sizeof(struct stat_jifs));
         // next can be overridden under 'stat_make_numa_hist'
         cpu_ptr->numa_node = STAT_NODE_INVALID;
         cpu_ptr->count = 1;
 
+        // (rc counts the id, as sscanf would have)
+        rc = 0;
+        if (!strncmp(bp, "cpu", 3) && (unsigned)(bp[3] - '0') <= 9) {
+            char *p = bp + 3;
+            stat_next_num(&p, &llnum);
+            cpu_ptr->id = llnum;
+            rc = 1 + stat_next_jifs(&p, &cpu_ptr->new);
+        }
 #ifdef __CYGWIN__
-        if (4 > (rc = sscanf(bp, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu"
+        if (4 > rc)
 #else
-        if (8 > (rc = sscanf(bp, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu"
+        if (8 > rc)
 #endif
-            , &cpu_ptr->id
-            , &cpu_ptr->new.user,  &cpu_ptr->new.nice,   &cpu_ptr->new.system
-            , &cpu_ptr->new.idle,  &cpu_ptr->new.iowait, &cpu_ptr->new.irq
-            , &cpu_ptr->new.sirq,  &cpu_ptr->new.stolen
-            , &cpu_ptr->new.guest, &cpu_ptr->new.gnice))) {
                 break;                   // we must tolerate cpus taken offline
-        }
         stat_derive_unique(cpu_ptr);
 #ifdef CPU_IDLE_FORCED
         // first time through (that priming read) sum_ptr->edge will be zero |
@@ -671,39 +839,219 @@ reap_em_again:
 
     // remember sys_hist stuff from last time around
     memcpy(&info->sys_hist.old, &info->sys_hist.new, sizeof(struct stat_data));
+    memset(&info->sys_hist.new, 0, sizeof(struct stat_data));
+
+    /* the remaining lines each begin with a label and what we want is just |
+       the first number which follows it.  the rest of any line, especially |
+       that 'intr' one (which can be huge), is then skipped via memchr.     | */
+ #define sysLINE(label, field) \
+    if (!strncmp(bp, label " ", sizeof(label))) { \
+        char *p = bp + sizeof(label); \
+        if (stat_next_num(&p, &llnum)) info->sys_hist.new. field = llnum; \
+        continue; }
+    for ( ; bp < end; bp = stat_next_line(bp, end)) {
+        sysLINE("intr",          intr)
+        sysLINE("ctxt",          ctxt)
+        sysLINE("btime",         btime)
+        sysLINE("processes",     procs_created)
+        sysLINE("procs_blocked", procs_blocked)
+        sysLINE("procs_running", procs_running)
+    }
+ #undef sysLINE
 
-    llnum = 0;
-    if ((b = strstr(bp, "intr ")))
-        sscanf(b,  "intr %llu", &llnum);
-    info->sys_hist.new.intr = llnum;
+    return 0;
+} // end: stat_read_failed
 
-    llnum = 0;
-    if ((b = strstr(bp, "ctxt ")))
-        sscanf(b,  "ctxt %llu", &llnum);
-    info->sys_hist.new.ctxt = llnum;
 
-    llnum = 0;
-    if ((b = strstr(bp, "btime ")))
-        sscanf(b,  "btime %llu", &llnum);
-    info->sys_hist.new.btime = llnum;
+    // (re)size a generation for at least so many irqs and cpus, then point
+    // each irq at its own counts and deltas within the slab
+static int stat_irq_gen_grow (
+        struct irq_gen *g,
+        int irqs,
+        int cpus)
+{
+    void *p;
+    int i;
+
+    if (irqs > g->n_alloc) {
+        if (!(p = realloc(g->irqs, sizeof(struct hist_irq) * (irqs + NEWOLD_INCR))))
+            return 0;
+        g->irqs = p;
+        g->n_alloc = irqs + NEWOLD_INCR;
+    } else if (cpus <= g->c_alloc && g->slab)
+        return 1;
+    if (cpus > g->c_alloc)
+        g->c_alloc = cpus;
+    if (!(p = realloc(g->slab, sizeof(unsigned long long) * 2 * g->c_alloc * g->n_alloc)))
+        return 0;
+    g->slab = p;
+    for (i = 0; i < g->n_alloc; i++) {
+        g->irqs[i].counts = g->slab + (2 * g->c_alloc * i);
+        g->irqs[i].deltas = g->irqs[i].counts + g->c_alloc;
+    }
+    return 1;
+} // end: stat_irq_gen_grow
 
-    llnum = 0;
-    if ((b = strstr(bp, "processes ")))
-        sscanf(b,  "processes %llu", &llnum);
-    info->sys_hist.new.procs_created = llnum;
 
-    llnum = 0;
-    if ((b = strstr(bp, "procs_blocked ")))
-        sscanf(b,  "procs_blocked %llu", &llnum);
-    info->sys_hist.new.procs_blocked = llnum;
+    // the prior read's irq with this name, expected to be at the same index
+static inline struct hist_irq *stat_irq_prior (
+        struct irq_gen *old,
+        int i,
+        const char *name)
+{
+    int j;
+
+    if (i < old->n_inuse && !strcmp(old->irqs[i].name, name))
+        return &old->irqs[i];
+    for (j = 0; j < old->n_inuse; j++)
+        if (!strcmp(old->irqs[j].name, name))
+            return &old->irqs[j];
+    return NULL;
+} // end: stat_irq_prior
+
+
+    /*
+     * Both /proc/interrupts and /proc/softirqs have a header of cpu columns
+     * (only those online) followed by a line for each irq: a label, one count
+     * per column and, with interrupts, some description.  The latest read is
+     * kept apart from the one before, so any irq which comes or goes (or any
+     * cpu taken offline) can be matched up when computing those deltas. */
+static int stat_irq_read_failed (
+        struct irq_support *this)
+{
+    struct irq_gen *new, *old;
+    struct hist_irq *irq, *prv;
+    char *bp, *end, *p;
+    unsigned long long llnum, delta, hot;
+    int i, n, num, tot_read, same, busy;
+
+    if (!this->buf) {
+        if (!(this->buf = calloc(1, BUFFER_INCR)))
+            return 1;
+        this->buf_size = BUFFER_INCR;
+    }
+    if (this->fd == -1) {
+        char path[PROCPS_ROOTMAX + 32];
 
-    llnum = 0;
-    if ((b = strstr(bp, "procs_running ")))
-        sscanf(b,  "procs_running %llu", &llnum);
-    info->sys_hist.new.procs_running = llnum;
+        procps_rootf(path, sizeof(path), this->file);
+        if (-1 == (this->fd = open(path, O_RDONLY | O_CLOEXEC)))
+            return 1;
+    }
+ #define maxSIZ    this->buf_size
+ #define curSIZ  ( maxSIZ - tot_read )
+ #define curPOS  ( this->buf + tot_read )
+    // just like /proc/stat, once the buffer fits, this is a single pread
+    tot_read = 0;
+    while (0 < (num = pread(this->fd, curPOS, curSIZ - 1, tot_read))) {
+        tot_read += num;
+        if (tot_read < maxSIZ - 1)
+            break;
+        maxSIZ += BUFFER_INCR;
+        if (!(this->buf = realloc(this->buf, maxSIZ)))
+            return 1;
+    };
+    if (num < 0)
+        return 1;
+ #undef maxSIZ
+ #undef curSIZ
+ #undef curPOS
+    this->buf[tot_read] = '\0';
+    bp = this->buf;
+    end = bp + tot_read;
+
+    this->gen ^= 1;
+    new = &this->gens[this->gen];
+    old = &this->gens[!this->gen];
+
+    // the header, whose columns are the cpus then online ------------------
+    for (n = 0, p = bp; p < end && *p != '\n'; p++)
+        if (p[0] == 'C' && p[1] == 'P' && p[2] == 'U')
+            ++n;
+    if (!n) {
+        errno = EIO;
+        return 1;
+    }
+    if (n > new->ncols
+    && !(new->col_ids = realloc(new->col_ids, sizeof(int) * n)))
+        return 1;
+    for (new->ncols = 0, new->ncpus = 0, p = bp; new->ncols < n; ) {
+        if (!(p = strstr(p, "CPU")))
+            break;
+        p += 3;
+        if (!stat_next_num(&p, &llnum))
+            continue;
+        new->col_ids[new->ncols++] = llnum;
+        if ((int)llnum >= new->ncpus)
+            new->ncpus = llnum + 1;
+    }
+    same = (new->ncols == old->ncols && new->ncpus == old->ncpus
+        && !memcmp(new->col_ids, old->col_ids, sizeof(int) * new->ncols));
+    if (!stat_irq_gen_grow(new, 1, new->ncpus))
+        return 1;
 
+    // then each irq, only ever scanning that description to the newline ---
+    new->n_inuse = 0;
+    for (bp = stat_next_line(bp, end); bp < end; bp = stat_next_line(bp, end)) {
+        while (*bp == ' ')
+            ++bp;
+        for (p = bp; p < end && *p != ':' && *p != '\n'; p++)
+            ;
+        if (*p != ':')
+            continue;
+        i = new->n_inuse;
+        if (!(i < new->n_alloc)
+        && !stat_irq_gen_grow(new, i + 1, new->ncpus))
+            return 1;
+        irq = &new->irqs[i];
+        n = p - bp < IRQ_NAMESIZ ? p - bp : IRQ_NAMESIZ - 1;
+        memcpy(irq->name, bp, n);
+        irq->name[n] = '\0';
+        irq->cpus = new->ncpus;
+        memset(irq->counts, 0, sizeof(unsigned long long) * new->ncpus);
+        memset(irq->deltas, 0, sizeof(unsigned long long) * new->ncpus);
+        bp = p + 1;
+        for (n = 0; n < new->ncols; n++) {
+            if (!stat_next_num(&bp, &llnum))
+                break;
+            irq->counts[new->col_ids[n]] = llnum;
+        }
+        while (*bp == ' ')
+            ++bp;
+        for (p = bp; p < end && *p != '\n'; p++)
+            ;
+        n = p - bp < IRQ_DESCSIZ ? p - bp : IRQ_DESCSIZ - 1;
+        memcpy(irq->desc, bp, n);
+        irq->desc[n] = '\0';
+
+        // deltas only make sense if the same cpus were online last time
+        prv = same ? stat_irq_prior(old, i, irq->name) : NULL;
+        irq->new_tot = 0;
+        irq->active = 0;
+        irq->hot = busy = new->col_ids[0];
+        for (n = 0, hot = 0; n < new->ncols; n++) {
+            llnum = irq->counts[new->col_ids[n]];
+            irq->new_tot += llnum;
+            delta = 0;
+            if (prv && llnum > prv->counts[new->col_ids[n]])
+                delta = llnum - prv->counts[new->col_ids[n]];
+            irq->deltas[new->col_ids[n]] = delta;
+            if (delta)
+                irq->active++;
+            if (delta > hot) {
+                hot = delta;
+                irq->hot = new->col_ids[n];
+            }
+            if (llnum > irq->counts[busy])
+                busy = new->col_ids[n];
+        }
+        // lacking any delta, the hottest is simply the busiest
+        if (!hot)
+            irq->hot = busy;
+        irq->old_tot = prv ? prv->new_tot : irq->new_tot;
+        new->n_inuse++;
+    }
     return 0;
-} // end: stat_read_failed
+} // end: stat_irq_read_failed
 
 
 /*
@@ -767,7 +1115,7 @@ static int stat_stacks_fetch (
         struct reap_support *this)
 {
  #define n_alloc  this->n_alloc
- #define n_inuse  this->hist.n_inuse
+ #define n_inuse  this->total
  #define n_saved  this->n_alloc_save
     struct stacks_extent *ext;
     int i;
@@ -793,7 +1141,10 @@ static int stat_stacks_fetch (
                 return -1;   // here, errno was set to ENOMEM
             memcpy(this->anchor + i, ext->stacks, sizeof(void *) * STACKS_INCR);
         }
-        stat_assign_results(this->anchor[i], &info->sys_hist, &this->hist.tics[i]);
+        if (this->irq.file)
+            stat_assign_results(this->anchor[i], &info->sys_hist, NULL, &this->irq.gens[this->irq.gen].irqs[i]);
+        else
+            stat_assign_results(this->anchor[i], &info->sys_hist, &this->hist.tics[i], NULL);
     }
 
     // finalize stuff -------------------------------------
@@ -842,6 +1193,25 @@ static int stat_stacks_reconfig_maybe (
 } // end: stat_stacks_reconfig_maybe
 
 
+static void stat_irq_free (
+        struct reap_support *this)
+{
+    int i;
+
+    if (this->irq.fd != -1)
+        close(this->irq.fd);
+    free(this->irq.buf);
+    for (i = 0; i < 2; i++) {
+        free(this->irq.gens[i].col_ids);
+        free(this->irq.gens[i].irqs);
+        free(this->irq.gens[i].slab);
+    }
+    free(this->anchor);
+    free(this->result.stacks);
+    stat_extents_free_all(&this->fetch);
+} // end: stat_irq_free
+
+
 static struct stat_stack *stat_update_single_stack (
         struct stat_info *info,
         struct ext_support *this)
@@ -850,7 +1220,7 @@ static struct stat_stack *stat_update_single_stack (
     && !(stat_stacks_alloc(this, 1)))
        return NULL;
 
-    stat_assign_results(this->extents->stacks[0], &info->sys_hist, &info->cpu_hist);
+    stat_assign_results(this->extents->stacks[0], &info->sys_hist, &info->cpu_hist, NULL);
 
     return this->extents->stacks[0];
 } // end: stat_update_single_stack
@@ -898,6 +1268,7 @@ PROCPS_EXPORT int procps_stat_new (
         return -ENOMEM;
     }
     p->stat_buf_size = BUFFER_INCR;
+    p->stat_fd = -1;
     p->refcount = 1;
 
     p->results.cpus = &p->cpus.result;
@@ -909,6 +1280,14 @@ PROCPS_EXPORT int procps_stat_new (
     // the select guy has its own set of items
     p->select.items = &p->select_items;
 
+    // as do each of the irq reaps, whose files are read only if reaped
+    p->hard.fetch.items = &p->hard_items;
+    p->hard.irq.file = IRQS_FILE;
+    p->hard.irq.fd = -1;
+    p->soft.fetch.items = &p->soft_items;
+    p->soft.irq.file = SIRQ_FILE;
+    p->soft.irq.fd = -1;
+
     numa_init();
 
     /* do a priming read here for the following potential benefits: |
@@ -947,8 +1326,8 @@ PROCPS_EXPORT int procps_stat_unref (
     if ((*info)->refcount < 1) {
         int errno_sav = errno;
 
-        if ((*info)->stat_fp)
-            fclose((*info)->stat_fp);
+        if ((*info)->stat_fd != -1)
+            close((*info)->stat_fd);
         if ((*info)->stat_buf)
             free((*info)->stat_buf);
 
@@ -970,6 +1349,9 @@ PROCPS_EXPORT int procps_stat_unref (
         if ((*info)->nodes.fetch.extents)
             stat_extents_free_all(&(*info)->nodes.fetch);
 
+        stat_irq_free(&(*info)->hard);
+        stat_irq_free(&(*info)->soft);
+
         if ((*info)->cpu_summary.extents)
             stat_extents_free_all(&(*info)->cpu_summary);
 
@@ -980,6 +1362,8 @@ PROCPS_EXPORT int procps_stat_unref (
             free((*info)->reap_items.enums);
         if ((*info)->select_items.enums)
             free((*info)->select_items.enums);
+        free((*info)->hard_items.enums);
+        free((*info)->soft_items.enums);
 
         numa_uninit();
 
@@ -1006,6 +1390,9 @@ PROCPS_EXPORT struct stat_result *procps_stat_get (
         return NULL;
     if (item < 0 || item >= STAT_logical_end)
         return NULL;
+    // the irq items belong to a single irq, so cannot be had this way
+    if (item >= STAT_IRQ_lowest)
+        return NULL;
     errno = 0;
 
     /* we will NOT read the source file with every call - rather, we'll offer
@@ -1020,7 +1407,7 @@ PROCPS_EXPORT struct stat_result *procps_stat_get (
     info->get_this.item = item;
     //  with 'get', we must NOT honor the usual 'noop' guarantee
     info->get_this.result.ull_int = 0;
-    Item_table[item].setsfunc(&info->get_this, &info->sys_hist, &info->cpu_hist);
+    Item_table[item].setsfunc(&info->get_this, &info->sys_hist, &info->cpu_hist, NULL);
 
     return &info->get_this;
 } // end: procps_stat_get
@@ -1058,6 +1445,8 @@ PROCPS_EXPORT struct stat_reaped *procps_stat_reap (
 #endif
     if (0 > (rc = stat_stacks_reconfig_maybe(&info->cpu_summary, items, numitems)))
         return NULL;         // here, errno may be overridden with ENOMEM
+    if (stat_items_irq_failed(numitems, items, 0))
+        return NULL;
     if (rc) {
         stat_extents_free_all(&info->cpus.fetch);
         stat_extents_free_all(&info->nodes.fetch);
@@ -1101,6 +1490,48 @@ PROCPS_EXPORT struct stat_reaped *procps_stat_reap (
 } // end: procps_stat_reap
 
 
+/* procps_stat_reap_irqs():
+ *
+ * Harvest all the requested IRQ information for each of the hard (or soft)
+ * irqs, providing the result stacks along with their total.
+ *
+ * Returns: pointer to a stat_reap struct on success, NULL on error.
+ */
+PROCPS_EXPORT struct stat_reap *procps_stat_reap_irqs (
+        struct stat_info *info,
+        enum stat_irq_type which,
+        enum stat_item *items,
+        int numitems)
+{
+    struct reap_support *this;
+
+    errno = EINVAL;
+    if (info == NULL || items == NULL)
+        return NULL;
+    if (which != STAT_IRQ_HARD && which != STAT_IRQ_SOFT)
+        return NULL;
+    this = (which == STAT_IRQ_HARD) ? &info->hard : &info->soft;
+    if (0 > stat_stacks_reconfig_maybe(&this->fetch, items, numitems))
+        return NULL;         // here, errno may be overridden with ENOMEM
+    if (stat_items_irq_failed(numitems, items, 1))
+        return NULL;
+    errno = 0;
+
+    // a priming read, like procps_stat_new's, so the deltas are useful
+    if (this->irq.fd == -1
+    && stat_irq_read_failed(&this->irq))
+        return NULL;
+    if (stat_irq_read_failed(&this->irq))
+        return NULL;
+    this->total = this->irq.gens[this->irq.gen].n_inuse;
+
+    if (0 > stat_stacks_fetch(info, this))
+        return NULL;
+
+    return &this->result;
+} // end: procps_stat_reap_irqs
+
+
 /* procps_stat_select():
  *
  * Harvest all the requested TIC and/or SYS information then return
@@ -1118,6 +1549,8 @@ PROCPS_EXPORT struct stat_stack *procps_stat_select (
         return NULL;
     if (0 > stat_stacks_reconfig_maybe(&info->select, items, numitems))
         return NULL;         // here, errno may be overridden with ENOMEM
+    if (stat_items_irq_failed(numitems, items, 0))
+        return NULL;
     errno = 0;
 
     if (stat_read_failed(info))
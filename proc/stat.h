@@ -80,7 +80,19 @@ enum stat_item {
     STAT_SYS_DELTA_INTERRUPTS,    //    s_int         "
     STAT_SYS_DELTA_PROC_BLOCKED,  //    s_int         "
     STAT_SYS_DELTA_PROC_CREATED,  //    s_int         "
-    STAT_SYS_DELTA_PROC_RUNNING   //    s_int         "
+    STAT_SYS_DELTA_PROC_RUNNING,  //    s_int         "
+
+    STAT_IRQ_NAME,                //      str        /proc/interrupts or /proc/softirqs
+    STAT_IRQ_DESC,                //      str         "  ( interrupts only )
+    STAT_IRQ_NUM_CPUS,            //    s_int        [ highest cpu id + 1, see IRQ_PER_CPU ]
+    STAT_IRQ_TOTAL,               //  ull_int        derived from all cpus
+    STAT_IRQ_PER_CPU,             //    ull_v        [ indexed by cpu id, offline cpus zero ]
+    STAT_IRQ_CPUS_ACTIVE,         //    s_int        [ cpus with a non-zero delta ]
+    STAT_IRQ_CPU_HOT,             //    s_int        [ cpu id with the largest delta, else count ]
+
+    STAT_IRQ_DELTA_TOTAL,         //   sl_int        derived from above
+    STAT_IRQ_DELTA_PER_CPU,       //    ull_v         "
+    STAT_IRQ_DELTA_CPU_HOT        //   sl_int         "
 };
 
 enum stat_reap_type {
@@ -88,6 +100,11 @@ enum stat_reap_type {
     STAT_REAP_NUMA_NODES_TOO
 };
 
+enum stat_irq_type {
+    STAT_IRQ_HARD,                // /proc/interrupts
+    STAT_IRQ_SOFT                 // /proc/softirqs
+};
+
 enum stat_sort_order {
     STAT_SORT_ASCEND   = +1,
     STAT_SORT_DESCEND  = -1
@@ -101,6 +118,8 @@ struct stat_result {
         signed long         sl_int;
         unsigned long       ul_int;
         unsigned long long  ull_int;
+        char               *str;
+        unsigned long long *ull_v;
     } result;
 };
 
@@ -151,6 +170,12 @@ struct stat_reaped *procps_stat_reap (
     enum stat_item *items,
     int numitems);
 
+struct stat_reap *procps_stat_reap_irqs (
+    struct stat_info *info,
+    enum stat_irq_type which,
+    enum stat_item *items,
+    int numitems);
+
 struct stat_stack *procps_stat_select (
     struct stat_info *info,
     enum stat_item *items,
@@ -26,6 +26,8 @@
 #include <ctype.h>
 #include <locale.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -34,6 +36,7 @@
 #endif
 #include "misc.h"
 #include "procps-private.h"
+#include "record.h"
 
 
 #define LOADAVG_FILE "/proc/loadavg"
@@ -95,7 +98,7 @@ PROCPS_EXPORT int procps_loadavg(
     int retval=0;
     FILE *fp;
 
-    if ((fp = fopen(LOADAVG_FILE, "r")) == NULL)
+    if ((fp = replay_fopen(LOADAVG_FILE)) == NULL)
         return -errno;
 
     tmplocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
@@ -128,14 +131,15 @@ PROCPS_EXPORT int procps_loadavg(
 PROCPS_EXPORT unsigned int procps_pid_length(void)
 {
     FILE *fp;
-    char pidbuf[24];
+    char path[PROCPS_ROOTMAX + 32], pidbuf[24];
     static __thread int pid_length=0;
 
     if (pid_length)
         return pid_length;
 
     pid_length = DEFAULT_PID_LENGTH;
-    if ((fp = fopen(PROCFS_PID_MAX, "r")) != NULL) {
+    procps_rootf(path, sizeof(path), PROCFS_PID_MAX);
+    if ((fp = fopen(path, "r")) != NULL) {
         if (fgets(pidbuf, sizeof(pidbuf), fp) != NULL) {
             pid_length = strlen(pidbuf);
             if (pidbuf[pid_length-1] == '\n')
@@ -163,3 +167,78 @@ long procps_cpu_count(void)
     return cpus;
 }
 
+
+///////////////////////////////////////////////////////////////////////////
+
+static char procfs_root[PROCPS_ROOTMAX];
+static int procfs_rootlen;
+static pthread_once_t procfs_once = PTHREAD_ONCE_INIT;
+
+static int root_store (const char *dir)
+{
+    size_t len = strlen(dir);
+
+    // trailing slashes are dropped, so "/" alone means no prefix at all
+    while (len && dir[len - 1] == '/')
+        --len;
+    if (len >= sizeof(procfs_root))
+        return -ENAMETOOLONG;
+    memcpy(procfs_root, dir, len);
+    procfs_root[len] = '\0';
+    procfs_rootlen = len;
+    return 0;
+}
+
+static void root_from_env (void)
+{
+    const char *env;
+
+    if ((env = getenv("LIBPROC_ROOT")))
+        root_store(env);
+}
+
+/*
+ * procps_root_set:
+ * @dir: the directory holding some proc, sys and dev, or NULL for the real ones
+ *
+ * Have every /proc (and /sys and /dev) file read thereafter come from beneath
+ * @dir instead, overriding any LIBPROC_ROOT in the environment.  This is
+ * best done before any other library call, since already open files are
+ * not reopened.
+ *
+ * Returns: 0 on success <0 on error
+ */
+PROCPS_EXPORT int procps_root_set (const char *dir)
+{
+    pthread_once(&procfs_once, root_from_env);
+    return root_store(dir ? dir : "");
+}
+
+/*
+ * procps_root_get:
+ *
+ * Returns: the prefix now in effect, or NULL if there is none
+ */
+PROCPS_EXPORT const char *procps_root_get (void)
+{
+    pthread_once(&procfs_once, root_from_env);
+    return procfs_rootlen ? procfs_root : NULL;
+}
+
+int procps_rootf (char *buf, size_t siz, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    pthread_once(&procfs_once, root_from_env);
+    if (siz <= (size_t)procfs_rootlen) {
+        if (siz)
+            buf[0] = '\0';
+        return procfs_rootlen;
+    }
+    memcpy(buf, procfs_root, procfs_rootlen);
+    va_start(ap, fmt);
+    n = vsnprintf(buf + procfs_rootlen, siz - procfs_rootlen, fmt, ap);
+    va_end(ap);
+    return procfs_rootlen + n;
+}
@@ -18,13 +18,25 @@
  */
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
+#include <proc/misc.h>
 #include <proc/pids.h>
 #include "tests.h"
 
 enum pids_item items[] = { PIDS_ID_PID, PIDS_ID_PID };
 enum pids_item items2[] = { PIDS_ID_PID, PIDS_VM_RSS };
+enum pids_item items3[] = { PIDS_ID_PID, PIDS_ID_PPID, PIDS_NLWP, PIDS_VM_RSS };
+enum pids_item items4[] = { PIDS_ID_PID, PIDS_TICS_BEGAN, PIDS_UTILIZATION, PIDS_CMD };
+enum pids_item items5[] = { PIDS_ID_PID, PIDS_CHANGED, PIDS_CMDLINE, PIDS_VM_RSS };
+enum pids_item items6[] = { PIDS_ID_PID, PIDS_CMDLINE, PIDS_CMDLINE_V, PIDS_TTY_NAME };
+enum pids_item items7[] = { PIDS_ID_PID, PIDS_NS_PID, PIDS_NS_NET };
+enum pids_item items8[] = { PIDS_ID_PID, PIDS_FLT_MAJ_DELTA, PIDS_ID_EUSER };
 
 int check_pids_new_nullinfo(void *data)
 {
@@ -60,11 +72,434 @@ int check_fatal_proc_unmounted(void *data)
 	    ( PIDS_VAL(1, u_int, stack, info) > 0));
 }
 
+int check_pids_fdcache_nullinfo(void *data)
+{
+    testname = "procps_pids_fdcache() info=NULL returns -EINVAL";
+    return (procps_pids_fdcache(NULL, 64) == -EINVAL);
+}
+
+int check_pids_fdcache_reap(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *first, *again;
+    int total;
+    testname = "procps_pids_reap() twice with an fdcache";
+
+    if (procps_pids_new(&info, items2, 2) < 0
+    || procps_pids_fdcache(info, 64) <= 0
+    || !(first = procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)))
+        return 0;
+    total = first->counts->total;
+    if (!(again = procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)))
+        return 0;
+    return ( (total > 0) &&
+             (again->counts->total > 0) &&
+             (procps_pids_fdcache(info, 0) == 0) &&
+             (procps_pids_unref(&info) == 0));
+}
+
+int check_pids_reap_parallel(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetched;
+    int i, prev = 0, self = 0;
+    testname = "procps_pids_reap_parallel() keeps /proc order";
+
+    if (procps_pids_new(&info, items2, 2) < 0
+    || !(fetched = procps_pids_reap_parallel(info, PIDS_FETCH_TASKS_ONLY, 4)))
+        return 0;
+    for (i = 0; fetched->stacks[i]; i++) {
+        int pid = PIDS_VAL(0, s_int, fetched->stacks[i], info);
+        if (pid <= prev)
+            return 0;
+        if (pid == getpid())
+            self = 1;
+        prev = pid;
+    }
+    return ( (i == fetched->counts->total) &&
+             (self) &&
+             (procps_pids_unref(&info) == 0));
+}
+
+int check_pids_reap_columns(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_columns *cols;
+    int i;
+    testname = "procps_pids_reap_columns() agrees with the stacks";
+
+    if (procps_pids_new(&info, items2, 2) < 0
+    || !(cols = procps_pids_reap_columns(info, PIDS_FETCH_TASKS_ONLY)))
+        return 0;
+    if (cols->numcols != 2
+    || cols->numrows != cols->rows->counts->total
+    || cols->cols[1].item != PIDS_VM_RSS)
+        return 0;
+    for (i = 0; i < cols->numrows; i++) {
+        if (PIDS_COL(0, s_int, cols, info)[i] != PIDS_VAL(0, s_int, cols->rows->stacks[i], info)
+        || PIDS_COL(1, ul_int, cols, info)[i] != PIDS_VAL(1, ul_int, cols->rows->stacks[i], info))
+            return 0;
+    }
+    return (procps_pids_unref(&info) == 0);
+}
+
+int check_pids_select_status_only(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetched;
+    unsigned pid = getpid();
+    testname = "procps_pids_select() with only some /proc/#/status lines";
+
+    if (procps_pids_new(&info, items3, 4) < 0
+    || !(fetched = procps_pids_select(info, &pid, 1, PIDS_SELECT_PID))
+    || fetched->counts->total != 1)
+        return 0;
+    return ( (PIDS_VAL(0, s_int, fetched->stacks[0], info) == getpid()) &&
+             (PIDS_VAL(1, s_int, fetched->stacks[0], info) == getppid()) &&
+             (PIDS_VAL(2, s_int, fetched->stacks[0], info) >= 1) &&
+             (PIDS_VAL(3, ul_int, fetched->stacks[0], info) > 0) &&
+             (procps_pids_unref(&info) == 0));
+}
+
+#define SORT_NUM 1000
+int check_pids_sort_multi(void *data)
+{
+    static struct pids_result heads[SORT_NUM][4];
+    static struct pids_stack stacks[SORT_NUM], *ptrs[SORT_NUM];
+    static char names[4][2] = { "a", "b", "c", "d" };
+    struct pids_sort_key keys[] = {
+        { PIDS_UTILIZATION, PIDS_SORT_DESCEND },
+        { PIDS_ID_PID, PIDS_SORT_ASCEND } };
+    struct pids_info *info = NULL;
+    int i;
+    testname = "procps_pids_sort() and procps_pids_sort_multi() ordering";
+
+    if (procps_pids_new(&info, items4, 4) < 0)
+        return 0;
+    srand(1);
+    for (i = 0; i < SORT_NUM; i++) {
+        heads[i][0].item = PIDS_ID_PID;
+        heads[i][0].result.s_int = rand() % 2001 - 1000;
+        heads[i][1].item = PIDS_TICS_BEGAN;
+        heads[i][1].result.ull_int = (unsigned long long)rand() << 33;
+        heads[i][2].item = PIDS_UTILIZATION;
+        heads[i][2].result.real = (rand() % 7 - 3) / 2.0;
+        heads[i][3].item = PIDS_CMD;
+        heads[i][3].result.str = names[rand() % 4];
+        stacks[i].head = heads[i];
+        ptrs[i] = &stacks[i];
+    }
+    if (!procps_pids_sort(info, ptrs, SORT_NUM, PIDS_TICS_BEGAN, PIDS_SORT_DESCEND))
+        return 0;
+    for (i = 1; i < SORT_NUM; i++)
+        if (ptrs[i - 1]->head[1].result.ull_int < ptrs[i]->head[1].result.ull_int)
+            return 0;
+    // a stable sort must leave equal names in their prior (pointer) order
+    for (i = 0; i < SORT_NUM; i++)
+        ptrs[i] = &stacks[i];
+    if (!procps_pids_sort(info, ptrs, SORT_NUM, PIDS_CMD, PIDS_SORT_ASCEND))
+        return 0;
+    for (i = 1; i < SORT_NUM; i++) {
+        int c = strcmp(ptrs[i - 1]->head[3].result.str, ptrs[i]->head[3].result.str);
+        if (c > 0 || (c == 0 && ptrs[i - 1] > ptrs[i]))
+            return 0;
+    }
+    if (!procps_pids_sort_multi(info, ptrs, SORT_NUM, keys, 2))
+        return 0;
+    for (i = 1; i < SORT_NUM; i++) {
+        double a = ptrs[i - 1]->head[2].result.real, b = ptrs[i]->head[2].result.real;
+        if (a < b || (a == b && ptrs[i - 1]->head[0].result.s_int > ptrs[i]->head[0].result.s_int))
+            return 0;
+    }
+    return (procps_pids_unref(&info) == 0);
+}
+
+int check_pids_incremental(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetched;
+    char **cmds;
+    int *pids, i, j, num, reused = 0;
+    testname = "procps_pids_incremental() reuses unchanged results";
+
+    if (procps_pids_new(&info, items5, 4) < 0
+    || procps_pids_incremental(info, 1) < 0
+    || !(fetched = procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)))
+        return 0;
+    num = fetched->counts->total;
+    pids = calloc(num, sizeof(int));
+    cmds = calloc(num, sizeof(char *));
+    for (i = 0; i < num; i++) {
+        if (PIDS_VAL(1, s_int, fetched->stacks[i], info) != 1)
+            return 0;
+        pids[i] = PIDS_VAL(0, s_int, fetched->stacks[i], info);
+        cmds[i] = strdup(PIDS_VAL(2, str, fetched->stacks[i], info));
+    }
+    if (!(fetched = procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)))
+        return 0;
+    for (i = 0; i < fetched->counts->total; i++) {
+        if (PIDS_VAL(1, s_int, fetched->stacks[i], info))
+            continue;
+        for (j = 0; j < num; j++)
+            if (pids[j] == PIDS_VAL(0, s_int, fetched->stacks[i], info))
+                break;
+        if (j >= num || strcmp(cmds[j], PIDS_VAL(2, str, fetched->stacks[i], info)))
+            return 0;
+        reused++;
+    }
+    for (i = 0; i < num; i++)
+        free(cmds[i]);
+    free(cmds);
+    free(pids);
+    return ( (reused > 0) &&
+             (procps_pids_unref(&info) == 0));
+}
+
+int check_pids_reap_strings(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetched;
+    char **vec;
+    int i, n, found = 0;
+    testname = "procps_pids_reap() strings survive repeated reaps";
+
+    if (procps_pids_new(&info, items6, 4) < 0)
+        return 0;
+    // the third reap will carve its strings where the first one's were
+    for (n = 0; n < 3; n++) {
+        if (!(fetched = procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)))
+            return 0;
+        for (i = 0; i < fetched->counts->total; i++) {
+            vec = PIDS_VAL(2, strv, fetched->stacks[i], info);
+            if (!vec || !vec[0]
+            || !PIDS_VAL(1, str, fetched->stacks[i], info)[0]
+            || !PIDS_VAL(3, str, fetched->stacks[i], info)[0])
+                return 0;
+            // with no arguments, our own cmdline is just that first vector
+            if (n == 2 && getpid() == PIDS_VAL(0, s_int, fetched->stacks[i], info)) {
+                if (strcmp(vec[0], PIDS_VAL(1, str, fetched->stacks[i], info)))
+                    return 0;
+                found = 1;
+            }
+        }
+    }
+    return ( found &&
+             (procps_pids_unref(&info) == 0));
+}
+
+int check_pids_nscache(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetched;
+    struct procps_ns ns;
+    int i, n, found = 0;
+    testname = "procps_pids_nscache() agrees with procps_ns_read_pid";
+
+    if (procps_pids_new(&info, items7, 3) < 0
+    || procps_pids_nscache(info, 1) < 0
+    || procps_ns_read_pid(getpid(), &ns) < 0)
+        return 0;
+    // first to fill the cache, then from it (serially and in parallel)
+    for (n = 0; n < 3; n++) {
+        if (!(fetched = procps_pids_reap_parallel(info, PIDS_FETCH_TASKS_ONLY, n ? n : 1)))
+            return 0;
+        for (i = 0; i < fetched->counts->total; i++) {
+            if (getpid() != PIDS_VAL(0, s_int, fetched->stacks[i], info))
+                continue;
+            if (PIDS_VAL(1, ul_int, fetched->stacks[i], info) != ns.ns[PROCPS_NS_PID]
+            || PIDS_VAL(2, ul_int, fetched->stacks[i], info) != ns.ns[PROCPS_NS_NET])
+                return 0;
+            found++;
+        }
+    }
+    return ( (found == 3) &&
+             (procps_pids_unref(&info) == 0));
+}
+
+    // is this pid among those reaped, and with our own cmdline?
+static int snap_found(struct pids_info *info, struct pids_fetch *fetched, int pid, const char *cmdline)
+{
+    int i;
+
+    for (i = 0; i < fetched->counts->total; i++)
+        if (pid == PIDS_VAL(0, s_int, fetched->stacks[i], info))
+            return !strcmp(cmdline, PIDS_VAL(1, str, fetched->stacks[i], info))
+                && !strcmp(cmdline, PIDS_VAL(2, strv, fetched->stacks[i], info)[0]);
+    return 0;
+}
+
+int check_pids_snapshot(void *data)
+{
+    struct pids_info *pub = NULL, *sub = NULL;
+    struct pids_fetch *fetched;
+    struct timespec nap = { 0, 20000000 };
+    char name[64], cmdline[256];
+    int i, child, ok = 0;
+    testname = "procps_pids_attach_snapshot() reaps what was published";
+
+    snprintf(name, sizeof(name), "/tmp/test_pids.snap.%d", (int)getpid());
+    if (procps_pids_new(&pub, items6, 4) < 0
+    || procps_pids_new(&sub, items6, 4) < 0
+    || procps_pids_publish_snapshot(pub, name) < 0
+    || procps_pids_attach_snapshot(sub, name, 0) < 0)
+        goto done;
+    // just one publisher at a time (and never the same info as a reader)
+    if (procps_pids_publish_snapshot(sub, name) != -EBUSY)
+        goto done;
+    // a child seen by the publisher, but gone before any reader reaps
+    if (0 > (child = fork()))
+        goto done;
+    if (child == 0) {
+        pause();
+        _exit(0);
+    }
+    if (!(fetched = procps_pids_reap(pub, PIDS_FETCH_TASKS_ONLY)))
+        goto done;
+    for (i = 0; i < fetched->counts->total; i++)
+        if (getpid() == PIDS_VAL(0, s_int, fetched->stacks[i], pub))
+            snprintf(cmdline, sizeof(cmdline), "%s", PIDS_VAL(1, str, fetched->stacks[i], pub));
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    // twice, so strings in both arena generations are exercised
+    for (i = 0; i < 2; i++) {
+        if (!(fetched = procps_pids_reap(sub, PIDS_FETCH_TASKS_ONLY))
+        || !snap_found(sub, fetched, getpid(), cmdline)
+        || !snap_found(sub, fetched, child, cmdline))
+            goto done;
+    }
+    // while a reader wanting threads, or a fresher snapshot, uses /proc
+    if (!(fetched = procps_pids_reap(sub, PIDS_FETCH_THREADS_TOO))
+    || snap_found(sub, fetched, child, cmdline)
+    || procps_pids_attach_snapshot(sub, name, 1) < 0)
+        goto done;
+    nanosleep(&nap, NULL);
+    if (!(fetched = procps_pids_reap(sub, PIDS_FETCH_TASKS_ONLY))
+    || !snap_found(sub, fetched, getpid(), cmdline)
+    || snap_found(sub, fetched, child, cmdline))
+        goto done;
+    ok = 1;
+done:
+    unlink(name);
+    return ( ok &&
+             (procps_pids_unref(&sub) == 0) &&
+             (procps_pids_unref(&pub) == 0));
+}
+
+    // in a child (so our own reaps are unaffected), is some pid among what's
+    // replayed from so many seconds into a recording
+static int replay_found(const char *path, const char *start, int pid, const char *cmdline)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetched;
+    int child, status;
+
+    if (0 > (child = fork()))
+        return -1;
+    if (child == 0) {
+        setenv("LIBPROC_REPLAY", path, 1);
+        setenv("LIBPROC_REPLAY_START", start, 1);
+        setenv("LIBPROC_REPLAY_SPEED", "0", 1);
+        if (procps_pids_new(&info, items6, 4) < 0
+        || !(fetched = procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)))
+            _exit(2);
+        _exit(snap_found(info, fetched, pid, cmdline));
+    }
+    if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status))
+        return -1;
+    return WEXITSTATUS(status);
+}
+
+int check_pids_record(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_fetch *fetched;
+    char path[64], cmdline[256];
+    int i, child, ok = 0;
+    testname = "procps_pids_record() reaps can be replayed";
+
+    snprintf(path, sizeof(path), "/tmp/test_pids.rec.%d", (int)getpid());
+    if (procps_pids_new(&info, items6, 4) < 0
+    || procps_pids_record(info, path) < 0
+    || procps_pids_incremental(info, 1) != -EBUSY)
+        goto done;
+    if (!(fetched = procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)))
+        goto done;
+    for (i = 0; i < fetched->counts->total; i++)
+        if (getpid() == PIDS_VAL(0, s_int, fetched->stacks[i], info))
+            snprintf(cmdline, sizeof(cmdline), "%s", PIDS_VAL(1, str, fetched->stacks[i], info));
+    // a child in only the later frames (which are deltas), gone before replay
+    if (0 > (child = fork()))
+        goto done;
+    if (child == 0) {
+        pause();
+        _exit(0);
+    }
+    for (i = 0; i < 2; i++)
+        if (!procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY))
+            break;
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    if (i < 2 || procps_pids_record(info, NULL) < 0)
+        goto done;
+    // the first frame, then (well beyond the end) the last
+    if (replay_found(path, "0", getpid(), cmdline) != 1
+    || replay_found(path, "0", child, cmdline) != 0
+    || replay_found(path, "3600", getpid(), cmdline) != 1
+    || replay_found(path, "3600", child, cmdline) != 1)
+        goto done;
+    ok = 1;
+done:
+    unlink(path);
+    return ( ok &&
+             (procps_pids_unref(&info) == 0));
+}
+
+int check_pids_stats(void *data)
+{
+    struct pids_info *info = NULL;
+    struct pids_stats s;
+    testname = "procps_pids_stats() counts reaps, then starts again";
+
+    if (procps_pids_new(&info, items8, 3) < 0
+    || procps_pids_stats(info, NULL) < 0)
+        return 0;
+    // the second reap is the one which consults the first's history
+    if (!procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)
+    || !procps_pids_reap(info, PIDS_FETCH_TASKS_ONLY)
+    || procps_pids_stats(info, &s) < 0)
+        return 0;
+    if (s.calls != 2 || s.tasks < 2 || !s.opens || !s.reads || !s.bytes
+    || !s.parse_stat || !s.hist_lookups || s.hist_probes < s.hist_lookups
+    || s.pw_hits + s.pw_misses < s.tasks)
+        return 0;
+    // the workers' own counts must reach us too
+    if (!procps_pids_reap_parallel(info, PIDS_FETCH_TASKS_ONLY, 2)
+    || procps_pids_stats(info, &s) < 0
+    || s.calls != 1 || !s.opens || !s.hist_lookups)
+        return 0;
+    if (procps_pids_stats(info, &s) < 0
+    || s.calls || s.tasks || s.opens || s.bytes || s.hist_lookups)
+        return 0;
+    return (procps_pids_unref(&info) == 0);
+}
+
 TestFunction test_funcs[] = {
     check_pids_new_nullinfo,
     // skipped, ask Jim check_pids_new_toomany,
     check_pids_new_and_unref,
     check_fatal_proc_unmounted,
+    check_pids_fdcache_nullinfo,
+    check_pids_fdcache_reap,
+    check_pids_reap_parallel,
+    check_pids_select_status_only,
+    check_pids_reap_columns,
+    check_pids_sort_multi,
+    check_pids_incremental,
+    check_pids_reap_strings,
+    check_pids_nscache,
+    check_pids_snapshot,
+    check_pids_record,
+    check_pids_stats,
     NULL };
 
 int main(int argc, char *argv[])
@@ -0,0 +1,165 @@
+/*
+ * test_pwcache.c - tests for the user/group name cache
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <pwd.h>
+#include <grp.h>
+
+/*
+ * The per-id NSS lookups are counted, so the library source is included
+ * directly with those calls redirected here.
+ */
+static int nss_calls;
+
+static int counted_getpwuid_r (uid_t uid, struct passwd *pwd, char *buf, size_t siz, struct passwd **res) {
+    nss_calls++;
+    return getpwuid_r(uid, pwd, buf, siz, res);
+}
+static int counted_getgrgid_r (gid_t gid, struct group *grp, char *buf, size_t siz, struct group **res) {
+    nss_calls++;
+    return getgrgid_r(gid, grp, buf, siz, res);
+}
+
+#define getpwuid_r counted_getpwuid_r
+#define getgrgid_r counted_getgrgid_r
+#include "pwcache.c"
+#undef getpwuid_r
+#undef getgrgid_r
+
+#include "tests.h"
+
+    // an id unlikely to exist anywhere, whose name must then be the number
+#define NOBODY_ID  3999999000u
+
+    // forget everything cached (leaking it), under some new configuration
+static void cache_reset (int want_enum, time_t ttl) {
+    pthread_once(&cfg_once, pgc_config);
+    memset(&pwcache, 0, sizeof(pwcache));
+    memset(&grcache, 0, sizeof(grcache));
+    cfg_enum = want_enum;
+    cfg_ttl = ttl;
+    nss_calls = 0;
+}
+
+    // every enumerable user and group agrees with what libc says directly
+static int names_agree (void) {
+    struct passwd *pw;
+    struct group *gr;
+    char buf[P_G_SZ];
+    int n = 0;
+
+    setpwent();
+    while ((pw = getpwent())) {
+        if (strlen(pw->pw_name) >= P_G_SZ)
+            continue;
+        if (strcmp(pwcache_get_user(pw->pw_uid), getpwuid(pw->pw_uid)->pw_name))
+            return -1;
+        n++;
+    }
+    endpwent();
+    setgrent();
+    while ((gr = getgrent())) {
+        if (strlen(gr->gr_name) >= P_G_SZ)
+            continue;
+        if (strcmp(pwcache_get_group(gr->gr_gid), getgrgid(gr->gr_gid)->gr_name))
+            return -1;
+        n++;
+    }
+    endgrent();
+    snprintf(buf, sizeof(buf), "%u", NOBODY_ID);
+    if (strcmp(pwcache_get_user(NOBODY_ID), buf)
+    || strcmp(pwcache_get_group(NOBODY_ID), buf))
+        return -1;
+    return n;
+}
+
+int check_pwcache_lookups (void *data)
+{
+    testname = "pwcache per-id names agree with libc";
+    cache_reset(0, 0);
+    return names_agree() >= 0;
+}
+
+int check_pwcache_enumerated (void *data)
+{
+    int n;
+
+    testname = "pwcache enumerated names agree with libc, sans per-id lookups";
+    cache_reset(1, 0);
+    if ((n = names_agree()) < 0)
+        return 0;
+    // only the unknown user and group ever warranted a lookup
+    if (nss_calls != 2)
+        return 0;
+    // and, once cached, neither does again
+    pwcache_get_user(NOBODY_ID);
+    pwcache_get_group(NOBODY_ID);
+    return nss_calls == 2;
+}
+
+int check_pwcache_ttl (void *data)
+{
+    char *name;
+
+    testname = "pwcache names become stale, yet remain valid";
+    cache_reset(0, 60);
+    name = pwcache_get_user(0);
+    pwcache_get_user(0);
+    if (nss_calls != 1)
+        return 0;
+    // pretend a minute passed
+    pwcache.expires = 0;
+    if (pwcache_get_user(0) != name || nss_calls != 2)
+        return 0;
+    // a rename gets a new entry, leaving the old name just as it was
+    strcpy(name, "renamed");
+    pwcache.expires = 0;
+    if (pwcache_get_user(0) == name || strcmp(name, "renamed"))
+        return 0;
+    return nss_calls == 3 && pwcache.count == 1;
+}
+
+int check_pwcache_growth (void *data)
+{
+    char buf[P_G_SZ];
+    unsigned i;
+
+    testname = "pwcache grows with many (container) ids";
+    cache_reset(0, 0);
+    for (i = 0; i < 5000; i++)
+        pwcache_get_group(NOBODY_ID + i);
+    if (grcache.count != 5000 || (1u << grcache.bits) < 5000)
+        return 0;
+    for (i = 0; i < 5000; i++) {
+        snprintf(buf, sizeof(buf), "%u", NOBODY_ID + i);
+        if (strcmp(pwcache_get_group(NOBODY_ID + i), buf))
+            return 0;
+    }
+    return nss_calls == 5000;
+}
+
+TestFunction test_funcs[] = {
+    check_pwcache_lookups,
+    check_pwcache_enumerated,
+    check_pwcache_ttl,
+    check_pwcache_growth,
+    NULL };
+
+int main(int argc, char *argv[])
+{
+    return run_tests(test_funcs, NULL);
+}
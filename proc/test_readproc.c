@@ -0,0 +1,186 @@
+/*
+ * test_readproc.c - tests for readproc internals
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Those functions of interest are all static, so the library source is
+ * included directly.
+ */
+#include "readproc.c"
+
+#include "tests.h"
+
+#define FUZZ_LINES  20000
+
+    // what stat2proc was, before it learned to skip fields, as the reference
+static void stat2proc_sscanf (const char *S, proc_t *restrict P) {
+    P->processor = 0;
+    P->rtprio = -1;
+    P->sched = -1;
+    P->nlwp = 0;
+
+    S = strchr(S, '(');
+    if (!S) return;
+    S = strrchr(S + 1, ')');
+    if (!S || !S[1]) return;
+    S += 2;
+
+    sscanf(S,
+       "%c "
+       "%d %d %d %d %d "
+       "%lu %lu %lu %lu %lu "
+       "%llu %llu %llu %llu "
+       "%d %d "
+       "%d "
+       "%lu "
+       "%llu "
+       "%lu "
+       "%lu "
+       "%lu %lu %lu %lu %lu %lu "
+       "%*s %*s %*s %*s "
+       "%lu %*u %*u "
+       "%d %d "
+       "%d %d "
+       "%llu %llu %llu",
+       &P->state,
+       &P->ppid, &P->pgrp, &P->session, &P->tty, &P->tpgid,
+       &P->flags, &P->min_flt, &P->cmin_flt, &P->maj_flt, &P->cmaj_flt,
+       &P->utime, &P->stime, &P->cutime, &P->cstime,
+       &P->priority, &P->nice,
+       &P->nlwp,
+       &P->alarm,
+       &P->start_time,
+       &P->vsize,
+       &P->rss,
+       &P->rss_rlim, &P->start_code, &P->end_code, &P->start_stack, &P->kstk_esp, &P->kstk_eip,
+       &P->wchan,
+       &P->exit_signal, &P->processor,
+       &P->rtprio, &P->sched,
+       &P->blkio_tics, &P->gtime, &P->cgtime
+    );
+    if (!P->nlwp)
+        P->nlwp = 1;
+}
+
+    // a field's type, in the order they appear following comm
+static const char stat_types[] = "c" "iiiii" "lllll" "LLLL" "ii" "i" "l" "L" "l" "l"
+    "llllll" "llll" "lll" "ii" "ii" "LLL" "LLLLLLLLLL";
+
+static unsigned long long rand64 (void) {
+    return ((unsigned long long)random() << 62) ^ ((unsigned long long)random() << 31) ^ random();
+}
+
+    // a stat line having a silly comm plus 'numflds' fields, all random
+static void stat_line (char *buf, int numflds) {
+    static const char comm_chars[] = "ab ()) (x9";
+    char *p = buf;
+    int i, len;
+
+    p += sprintf(p, "%ld (", random() % 4194304);
+    for (i = 0, len = random() % 16; i < len; i++)
+        *p++ = comm_chars[random() % (sizeof(comm_chars) - 1)];
+    *p++ = ')';
+    for (i = 0; i < numflds; i++) {
+        switch (stat_types[i]) {
+            case 'c':
+                p += sprintf(p, " %c", "RSDZTtXI"[random() % 8]);
+                break;
+            case 'i':
+                p += sprintf(p, " %d", (int)rand64() >> (random() % 32));
+                break;
+            case 'l':
+                p += sprintf(p, " %lu", (unsigned long)rand64() >> (random() % 64));
+                break;
+            default:
+                p += sprintf(p, " %llu", rand64() >> (random() % 64));
+                break;
+        }
+    }
+    strcpy(p, "\n");
+}
+
+ #define CMP(f) (a->f == b->f)
+static int stat_same (const proc_t *a, const proc_t *b, unsigned long long want) {
+ #define SAME(f) ((want & PROC_STAT_ ## f) ? CMP(f) : 1)
+    return SAME(state) && SAME(ppid) && SAME(pgrp) && SAME(session) && SAME(tty)
+        && SAME(tpgid) && SAME(flags) && SAME(min_flt) && SAME(cmin_flt)
+        && SAME(maj_flt) && SAME(cmaj_flt) && SAME(utime) && SAME(stime)
+        && SAME(cutime) && SAME(cstime) && SAME(priority) && SAME(nice)
+        && SAME(nlwp) && SAME(alarm) && SAME(start_time) && SAME(vsize)
+        && SAME(rss) && SAME(rss_rlim) && SAME(start_code) && SAME(end_code)
+        && SAME(start_stack) && SAME(kstk_esp) && SAME(kstk_eip) && SAME(wchan)
+        && SAME(exit_signal) && SAME(processor) && SAME(rtprio) && SAME(sched)
+        && SAME(blkio_tics) && SAME(gtime) && SAME(cgtime);
+ #undef SAME
+}
+ #undef CMP
+
+static int stat_fuzz (int selective) {
+    char line[2048], comm[64], cmd[64];
+    proc_t a, b;
+    unsigned long long want;
+    const char *s, *e;
+    int i;
+
+    srandom(selective ? 0x5e1ec7 : 0xf022);
+    for (i = 0; i < FUZZ_LINES; i++) {
+        // anything from a 2.0 kernel's line through all (and more) fields
+        stat_line(line, 1 + random() % (int)(sizeof(stat_types) - 1));
+        want = selective ? rand64() : 0;
+        memset(&a, 0, sizeof(a));
+        memset(&b, 0, sizeof(b));
+        if (stat2proc(line, &a, want))
+            return 0;
+        stat2proc_sscanf(line, &b);
+        if (!stat_same(&a, &b, want ? want | PROC_STAT_BASE : ~0ULL))
+            goto oops;
+        // comm is everything between the first '(' and the last ')'
+        s = strchr(line, '(') + 1;
+        e = strrchr(line, ')');
+        snprintf(comm, e - s + 1, "%s", s);
+        escape_str(cmd, comm, sizeof(cmd));
+        if (!a.cmd || strcmp(a.cmd, cmd))
+            goto oops;
+        free(a.cmd);
+    }
+    return 1;
+oops:
+    fprintf(stderr, "stat2proc mismatch with: %s", line);
+    return 0;
+}
+
+int check_stat2proc_all (void *data)
+{
+    testname = "stat2proc() agrees with sscanf for every field";
+    return stat_fuzz(0);
+}
+
+int check_stat2proc_selected (void *data)
+{
+    testname = "stat2proc() agrees with sscanf for selected fields";
+    return stat_fuzz(1);
+}
+
+TestFunction test_funcs[] = {
+    check_stat2proc_all,
+    check_stat2proc_selected,
+    NULL };
+
+int main(int argc, char *argv[])
+{
+    return run_tests(test_funcs, NULL);
+}
@@ -16,8 +16,13 @@
  * License along with this library; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
 
 #include <proc/misc.h>
 #include "tests.h"
@@ -49,10 +54,46 @@ int check_loadavg_null(void *data)
     return 0;
 }
 
+int check_root(void *data)
+{
+    char dir[] = "/tmp/test_sysinfo.XXXXXX", path[64], toolong[512];
+    double a = 0;
+    FILE *fp;
+    int ok;
+    testname = "procps_root_set() for another /proc";
+
+    if (!mkdtemp(dir))
+        return 0;
+    snprintf(path, sizeof(path), "%s/proc", dir);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/proc/loadavg", dir);
+    if (!(fp = fopen(path, "w")))
+        return 0;
+    fputs("12.25 0.50 0.75 1/100 4242\n", fp);
+    fclose(fp);
+
+    memset(toolong, 'x', sizeof(toolong) - 1);
+    toolong[sizeof(toolong) - 1] = '\0';
+    ok = (procps_root_set(toolong) == -ENAMETOOLONG
+        && procps_root_set(dir) == 0
+        && procps_root_get() && !strcmp(procps_root_get(), dir)
+        && procps_loadavg(&a, NULL, NULL) == 0
+        && a == 12.25
+        && procps_root_set(NULL) == 0
+        && procps_root_get() == NULL);
+
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/proc", dir);
+    rmdir(path);
+    rmdir(dir);
+    return ok;
+}
+
 TestFunction test_funcs[] = {
     check_hertz,
     check_loadavg,
     check_loadavg_null,
+    check_root,
     NULL,
 };
 
@@ -33,6 +33,7 @@
 
 #include <proc/misc.h>
 #include "procps-private.h"
+#include "record.h"
 
 #define UPTIME_FILE "/proc/uptime"
 
@@ -73,7 +74,7 @@ PROCPS_EXPORT int procps_uptime(
     FILE *fp;
     int rc;
 
-    if ((fp = fopen(UPTIME_FILE, "r")) == NULL)
+    if ((fp = replay_fopen(UPTIME_FILE)) == NULL)
         return -errno;
 
     tmplocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
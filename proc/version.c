@@ -50,11 +50,12 @@
 PROCPS_EXPORT int procps_linux_version(void)
 {
     FILE *fp;
-    char buf[256];
+    char buf[PROCPS_ROOTMAX + 64];
     unsigned int x = 0, y = 0, z = 0;
     int version_string_depth;
 
-    if ((fp = fopen(PROCFS_OSRELEASE, "r")) == NULL)
+    procps_rootf(buf, sizeof(buf), PROCFS_OSRELEASE);
+    if ((fp = fopen(buf, "r")) == NULL)
 	return -errno;
     if (fgets(buf, 256, fp) == NULL) {
 	fclose(fp);
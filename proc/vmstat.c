@@ -24,7 +24,6 @@
 
 #include <errno.h>
 #include <fcntl.h>
-#include <search.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +34,8 @@
 #include <sys/types.h>
 
 #include <proc/procps-private.h>
+#include <proc/keyhash.h>
+#include <proc/record.h>
 #include <proc/vmstat.h>
 
 
@@ -234,7 +235,7 @@ struct vmstat_info {
     int numitems;
     enum vmstat_item *items;
     struct stacks_extent *extents;
-    struct hsearch_data hashtab;
+    struct keyhash *keys;
     struct vmstat_result get_this;
     time_t sav_secs;
 };
@@ -981,19 +982,9 @@ static inline int vmstat_items_check_failed (
 } // end: vmstat_items_check_failed
 
 
-static int vmstat_make_hash_failed (
-        struct vmstat_info *info)
-{
- #define htVAL(f) e.key = STRINGIFY(f); e.data = &info->hist.new. f; \
-  if (!hsearch_r(e, ENTER, &ep, &info->hashtab)) return 1;
-    ENTRY e, *ep;
-    size_t n;
-
-    n = sizeof(struct vmstat_data) / sizeof(unsigned long);
-    // we'll follow the hsearch recommendation of an extra 25%
-    if (!hcreate_r(n + (n / 4), &info->hashtab))
-        return 1;
-
+// every key we know of, in no particular order
+ #define htVAL(f) KEYHASH_KEY(f, struct vmstat_data, f),
+static const struct keyhash_key vmstat_keys[] = {
     htVAL(allocstall_dma)
     htVAL(allocstall_dma32)
     htVAL(allocstall_high)
@@ -1145,10 +1136,8 @@ static int vmstat_make_hash_failed (
     htVAL(workingset_refault)
     htVAL(workingset_restore)
     htVAL(zone_reclaim_failed)
-
-    return 0;
+};
  #undef htVAL
-} // end: vmstat_make_hash_failed
 
 
 /*
@@ -1161,9 +1150,7 @@ static int vmstat_read_failed (
         struct vmstat_info *info)
 {
     char buf[VMSTAT_BUFF];
-    char *head, *tail;
     int size;
-    unsigned long *valptr;
 
     // remember history from last time around
     memcpy(&info->hist.old, &info->hist.new, sizeof(struct vmstat_data));
@@ -1171,9 +1158,19 @@ static int vmstat_read_failed (
     memset(&info->hist.new, 0, sizeof(struct vmstat_data));
 
 #ifndef __CYGWIN__ /* /proc/vmstat does not exist */
-    if (-1 == info->vmstat_fd
-    && (-1 == (info->vmstat_fd = open(VMSTAT_FILE, O_RDONLY))))
-        return 1;
+    if (replay_active()) {
+        if ((size = replay_read(VMSTAT_FILE, buf, sizeof(buf)-1)) < 0)
+            return 1;
+        goto have_size;
+    }
+
+    if (-1 == info->vmstat_fd) {
+        char path[PROCPS_ROOTMAX + 32];
+
+        procps_rootf(path, sizeof(path), VMSTAT_FILE);
+        if (-1 == (info->vmstat_fd = open(path, O_RDONLY)))
+            return 1;
+    }
 
     if (lseek(info->vmstat_fd, 0L, SEEK_SET) == -1)
         return 1;
@@ -1186,34 +1183,14 @@ static int vmstat_read_failed (
         }
         break;
     }
+have_size:
     if (size == 0) {
         errno = EIO;
         return 1;
     }
     buf[size] = '\0';
 
-    head = buf;
-
-    for (;;) {
-        static __thread ENTRY e;  // keep coverity off our backs (e.data)
-        ENTRY *ep;
-
-        if (!(tail = strchr(head, ' ')))
-            break;
-        *tail = '\0';
-        valptr = NULL;
-
-        e.key = head;
-        if (hsearch_r(e, FIND, &ep, &info->hashtab))
-            valptr = ep->data;
-        head = tail + 1;
-        if (valptr)
-            *valptr = strtoul(head, NULL, 10);
-
-        if (!(tail = strchr(head, '\n')))
-            break;
-        head = tail + 1;
-    }
+    keyhash_parse(info->keys, buf, size, ' ', &info->hist.new);
 #endif /* !__CYGWIN__ */
     return 0;
 } // end: vmstat_read_failed
@@ -1315,7 +1292,7 @@ PROCPS_EXPORT int procps_vmstat_new (
     p->refcount = 1;
     p->vmstat_fd = -1;
 
-    if (vmstat_make_hash_failed(p)) {
+    if (!(p->keys = keyhash_create(vmstat_keys, MAXTABLE(vmstat_keys)))) {
         free(p);
         return -errno;
     }
@@ -1363,7 +1340,7 @@ PROCPS_EXPORT int procps_vmstat_unref (
             vmstat_extents_free_all((*info));
         if ((*info)->items)
             free((*info)->items);
-        hdestroy_r(&(*info)->hashtab);
+        keyhash_destroy((*info)->keys);
 
         free(*info);
         *info = NULL;
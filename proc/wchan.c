@@ -18,21 +18,91 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
+#include "procps-private.h"
 #include "wchan.h"  // to verify prototype
 
 
+// There are but a few hundred distinct wait channels, so each name is kept
+// just once (per thread) and thereafter simply shared.  Such strings are
+// freed only when their thread calls wchan_thread_free, just before exit.
+#define WCHAN_HASH_INIT  512           // power of 2
+
+static __thread char **wchan_names;
+static __thread unsigned wchan_mask, wchan_used;
+
+static unsigned wchan_hash (const char *name) {
+   unsigned h = 2166136261u;           // FNV-1a
+
+   while (*name)
+      h = (h ^ (unsigned char)*name++) * 16777619u;
+   return h;
+}
+
+static int wchan_grow (void) {
+   char **old = wchan_names;
+   unsigned i, j, oldsiz = old ? wchan_mask + 1 : 0;
+   unsigned siz = oldsiz ? oldsiz * 2 : WCHAN_HASH_INIT;
+
+   if (!(wchan_names = calloc(siz, sizeof(char *)))) {
+      wchan_names = old;
+      return 0;
+   }
+   wchan_mask = siz - 1;
+   for (i = 0; i < oldsiz; i++) {
+      if (!old[i]) continue;
+      for (j = wchan_hash(old[i]) & wchan_mask; wchan_names[j]; j = (j + 1) & wchan_mask)
+         ;
+      wchan_names[j] = old[i];
+   }
+   free(old);
+   return 1;
+}
+
+static const char *wchan_intern (const char *name) {
+   unsigned i;
+
+   if (!wchan_names && !wchan_grow())
+      return "?";
+   for (i = wchan_hash(name) & wchan_mask; wchan_names[i]; i = (i + 1) & wchan_mask)
+      if (!strcmp(wchan_names[i], name))
+         return wchan_names[i];
+   if ((wchan_used + 1) * 4 > (wchan_mask + 1) * 3) {
+      if (!wchan_grow())
+         return "?";
+      for (i = wchan_hash(name) & wchan_mask; wchan_names[i]; i = (i + 1) & wchan_mask)
+         ;
+   }
+   if (!(wchan_names[i] = strdup(name)))
+      return "?";
+   wchan_used++;
+   return wchan_names[i];
+}
+
+
+const char *lookup_wchan_str (const char *wchan) {
+   if (!wchan[0]) return "?";
+   if (wchan[0]=='0' && wchan[1]=='\0') return "-";
+
+   // lame ppc64 has a '.' in front of every name
+   if (*wchan=='.') wchan++;
+   while(*wchan=='_') wchan++;
+
+   return wchan_intern(wchan);
+}
+
+
 const char *lookup_wchan (int pid) {
-   static __thread char buf[64];
-   const char *ret = buf;
+   char buf[PROCPS_ROOTMAX + 64];
    ssize_t num;
    int fd;
 
-   snprintf(buf, sizeof buf, "/proc/%d/wchan", pid);
+   procps_rootf(buf, sizeof buf, "/proc/%d/wchan", pid);
    fd = open(buf, O_RDONLY);
    if (fd==-1) return "?";
 
@@ -42,11 +112,16 @@ const char *lookup_wchan (int pid) {
    if (num<1) return "?"; // allow for "0"
    buf[num] = '\0';
 
-   if (buf[0]=='0' && buf[1]=='\0') return "-";
+   return lookup_wchan_str(buf);
+}
 
-   // lame ppc64 has a '.' in front of every name
-   if (*ret=='.') ret++;
-   while(*ret=='_') ret++;
 
-   return ret;
+void wchan_thread_free (void) {
+   unsigned i;
+
+   for (i = 0; wchan_names && i <= wchan_mask; i++)
+      free(wchan_names[i]);
+   free(wchan_names);
+   wchan_names = NULL;
+   wchan_mask = wchan_used = 0;
 }
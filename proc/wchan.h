@@ -1,6 +1,12 @@
 #ifndef PROCPS_PROC_WCHAN_H
 #define PROCPS_PROC_WCHAN_H
 
+// Both return a name which need never be freed (and must not be).  The
+// second accepts what was read from some /proc/#/wchan file.
 extern const char *lookup_wchan (int pid);
+extern const char *lookup_wchan_str (const char *wchan);
+
+// A thread other than the first frees its names this way, before exiting.
+extern void wchan_thread_free (void);
 
 #endif
@@ -287,6 +287,9 @@ static void value_this_proc_pcpu(proc_t *buf){
 
 /***** just display */
 static void simple_spew(void){
+  struct pids_sort_key tgid_then_began[] = {
+    { PIDS_ID_TGID,    PIDS_SORT_ASCEND },
+    { PIDS_TICS_BEGAN, PIDS_SORT_ASCEND } };
   struct pids_fetch *pidread;
   proc_t *buf;
   int i;
@@ -329,10 +332,8 @@ static void simple_spew(void){
       }
       break;
     case TF_show_proc|TF_show_task:      // m and -m options
-      procps_pids_sort(Pids_info, pidread->stacks
-        , pidread->counts->total, PIDS_TICS_BEGAN, PIDS_SORT_ASCEND);
-      procps_pids_sort(Pids_info, pidread->stacks
-        , pidread->counts->total, PIDS_ID_TGID, PIDS_SORT_ASCEND);
+      procps_pids_sort_multi(Pids_info, pidread->stacks
+        , pidread->counts->total, tgid_then_began, 2);
       for (i = 0; i < pidread->counts->total; i++) {
         buf = pidread->stacks[i];
 next_proc:
@@ -489,9 +490,20 @@ static void fancy_spew(void){
   }
   if (n) {
     if(forest_type) prep_forest_sort();
-    while(sort_list) {
-      procps_pids_sort(Pids_info, processes, n, sort_list->sr, sort_list->reverse);
-      sort_list = sort_list->next;
+    if(sort_list) {
+      /* the list's last node is the most significant, so it goes first */
+      struct pids_sort_key *keys;
+      sort_node *walk;
+      int k, numkeys = 0;
+      for(walk = sort_list; walk; walk = walk->next) numkeys++;
+      keys = xcalloc(numkeys, sizeof(struct pids_sort_key));
+      for(walk = sort_list, k = numkeys; walk; walk = walk->next) {
+        k--;
+        keys[k].item = walk->sr;
+        keys[k].order = walk->reverse;
+      }
+      procps_pids_sort_multi(Pids_info, processes, n, keys, numkeys);
+      free(keys);
     }
     if(forest_type) show_forest(n);
     else show_proc_array(n);
@@ -403,7 +403,12 @@ Modifications to the arguments are not shown.
 static int pr_args(char *restrict const outbuf, const proc_t *restrict const pp){
   char *endp;
   int rightward, fh;
-setREL2(CMDLINE,ENVIRON)
+  // environ is read (from every task) only if it'll be shown
+  if (!outbuf) {
+    chkREL(CMDLINE)
+    if (bsd_e_option) chkREL(ENVIRON)
+    return 0;
+  }
   endp = outbuf;
   rightward = max_rightward;
   fh = forest_helper(outbuf);
@@ -428,7 +433,11 @@ setREL2(CMDLINE,ENVIRON)
 static int pr_comm(char *restrict const outbuf, const proc_t *restrict const pp){
   char *endp;
   int rightward, fh;
-setREL3(CMD,CMDLINE,ENVIRON)
+  if (!outbuf) {
+    chkREL(CMD) chkREL(CMDLINE)
+    if (bsd_e_option) chkREL(ENVIRON)
+    return 0;
+  }
   endp = outbuf;
   rightward = max_rightward;
   fh = forest_helper(outbuf);
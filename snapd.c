@@ -0,0 +1,186 @@
+/*
+ * snapd.c - publish (or record) process snapshots for other programs
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "c.h"
+#include "fileutils.h"
+#include "nls.h"
+#include "strutils.h"
+
+#include <proc/pids.h>
+
+#define DEFAULT_NAME  "procps-snapshot"
+
+static volatile sig_atomic_t quit;
+
+static void sig_quit(int sig)
+{
+    (void)sig;
+    quit = 1;
+}
+
+/*
+ * Unless --all, those items whose /proc files are generally private to
+ * their owner (and root) are left out, since any user might then read
+ * them in the snapshot.  So are the addresses and wchan, which the kernel
+ * shows only to those who could ptrace the task.  The systemd items are
+ * omitted as costly.
+ */
+static int private_item(enum pids_item e)
+{
+    return e == PIDS_ENVIRON || e == PIDS_ENVIRON_V || e == PIDS_EXE
+        || (e >= PIDS_ADDR_CODE_END && e <= PIDS_ADDR_STACK_START)
+        || e == PIDS_WCHAN_NAME
+        || (e >= PIDS_IO_READ_BYTES && e <= PIDS_IO_WRITE_OPS)
+        || (e >= PIDS_NS_CGROUP && e <= PIDS_NS_UTS)
+        || (e >= PIDS_SD_MACH && e <= PIDS_SD_UUNIT)
+        || (e >= PIDS_SMAP_ANONYMOUS && e <= PIDS_SMAP_SWAP_PSS);
+}
+
+static void __attribute__ ((__noreturn__)) usage(FILE * out)
+{
+    fputs(USAGE_HEADER, out);
+    fprintf(out, _(" %s [options]\n"), program_invocation_short_name);
+    fputs(USAGE_OPTIONS, out);
+    fputs(_(" -a, --all            publish every item, even private ones\n"), out);
+    fputs(_(" -c, --count <num>    exit after this many snapshots\n"), out);
+    fputs(_(" -d, --delay <secs>   seconds between snapshots\n"), out);
+    fputs(_(" -n, --name <name>    name of the snapshot\n"), out);
+    fputs(_(" -r, --record <file>  record each snapshot in this file\n"), out);
+    fputs(_(" -t, --threads        include threads, not just processes\n"), out);
+    fputs(USAGE_SEPARATOR, out);
+    fputs(USAGE_HELP, out);
+    fputs(USAGE_VERSION, out);
+    fprintf(out, USAGE_MAN_TAIL("procps-snapd(8)"));
+
+    exit(out == stderr ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+int main(int argc, char **argv)
+{
+    enum pids_fetch_type which = PIDS_FETCH_TASKS_ONLY;
+    enum pids_item items[PIDS_WCHAN_NAME + 1];
+    struct pids_info *info = NULL;
+    const char *name = NULL, *record = NULL;
+    struct timespec nap;
+    struct sigaction sa;
+    double delay = 1.0;
+    long count = 0;
+    int c, e, rc, all = 0, numitems = 0;
+
+    static const struct option longopts[] = {
+        {"all", no_argument, NULL, 'a'},
+        {"count", required_argument, NULL, 'c'},
+        {"delay", required_argument, NULL, 'd'},
+        {"name", required_argument, NULL, 'n'},
+        {"record", required_argument, NULL, 'r'},
+        {"threads", no_argument, NULL, 't'},
+        {"help", no_argument, NULL, 'h'},
+        {"version", no_argument, NULL, 'V'},
+        {NULL, 0, NULL, 0}
+    };
+
+#ifdef HAVE_PROGRAM_INVOCATION_NAME
+    program_invocation_name = program_invocation_short_name;
+#endif
+    setlocale (LC_ALL, "");
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+    atexit(close_stdout);
+
+    while ((c = getopt_long(argc, argv, "ac:d:n:r:thV", longopts, NULL)) != -1)
+        switch (c) {
+        case 'a':
+            all = 1;
+            break;
+        case 'c':
+            count = strtol_or_err(optarg, _("failed to parse argument"));
+            if (count < 1)
+                xerrx(EXIT_FAILURE, _("count must be positive"));
+            break;
+        case 'd':
+            delay = strtod_nol_or_err(optarg, _("failed to parse argument"));
+            if (delay < 0.1)
+                delay = 0.1;
+            break;
+        case 'n':
+            name = optarg;
+            break;
+        case 'r':
+            record = optarg;
+            break;
+        case 't':
+            which = PIDS_FETCH_THREADS_TOO;
+            break;
+        case 'h':
+            usage(stdout);
+        case 'V':
+            printf(PROCPS_NG_VERSION);
+            return EXIT_SUCCESS;
+        default:
+            usage(stderr);
+        }
+
+    if (optind != argc)
+        usage(stderr);
+    // a recorder publishes too, but only when asked
+    if (!record && !name)
+        name = DEFAULT_NAME;
+
+    for (e = PIDS_ADDR_CODE_END; e <= PIDS_WCHAN_NAME; e++)
+        if (all || !private_item(e))
+            items[numitems++] = e;
+    if ((rc = procps_pids_new(&info, items, numitems)) < 0)
+        xerrx(EXIT_FAILURE, _("Unable to create pid info structure"));
+    // (we may have inherited a LIBPROC_SNAPSHOT meant for our readers)
+    procps_pids_attach_snapshot(info, NULL, 0);
+    if (name && (rc = procps_pids_publish_snapshot(info, name)) < 0) {
+        errno = -rc;
+        xerr(EXIT_FAILURE, _("cannot publish %s"), name);
+    }
+    if (record && (rc = procps_pids_record(info, record)) < 0) {
+        errno = -rc;
+        xerr(EXIT_FAILURE, _("cannot record %s"), record);
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sig_quit;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+
+    nap.tv_sec = (time_t)delay;
+    nap.tv_nsec = (long)((delay - nap.tv_sec) * 1000000000.0);
+    while (!quit) {
+        if (!procps_pids_reap(info, which))
+            xerr(EXIT_FAILURE, _("Unable to load process information"));
+        if (count && --count == 0)
+            break;
+        nanosleep(&nap, NULL);
+    }
+
+    procps_pids_unref(&info);
+    return EXIT_SUCCESS;
+}